@@ -0,0 +1,175 @@
+#include "ActivityView.h"
+
+namespace
+{
+    constexpr int lowestNote = 21;        // Piano range
+    constexpr int highestNote = 108;
+    constexpr int meterWidth = 6;         // Per route, right of the roll
+    constexpr float meterDecay = 0.85f;   // Per tick
+
+    // Most records a tick takes from the feed; the rest wait for the next one
+    constexpr int maxRecordsPerTick = 4096;
+
+    juce::Colour routeColour(int channel)
+    {
+        return juce::Colour::fromHSV((float)((channel - 1) % 16) / 16.0f + 0.1f, 0.55f, 0.95f, 1.0f);
+    }
+}
+
+ActivityView::ActivityView(stringfield::ActivityFeed& f, std::function<double()> sampleRate)
+    : feed(f), getSampleRate(std::move(sampleRate))
+{
+    setOpaque(true);
+    startTimerHz(refreshRateHz);
+}
+
+void ActivityView::clearHistory()
+{
+    notes.clear();
+    pedalSpans.clear();
+    pedalChannels = 0;
+}
+
+void ActivityView::handleRecord(const stringfield::ActivityRecord& record)
+{
+    // The host jumped back (locate, cycle): start a fresh roll
+    if (record.time + (int64_t)getSampleRate() < now)
+        clearHistory();
+
+    now = juce::jmax(now, record.time);
+
+    switch (record.kind)
+    {
+        case stringfield::ActivityRecord::NoteOn:
+        {
+            Note note;
+            note.start = record.time;
+            note.note = record.note;
+            note.channel = record.channel;
+            note.velocity = record.velocity;
+            notes.pushBack(note);
+
+            auto& meter = meters[(record.channel - 1) & 15];
+            meter = juce::jmax(meter, record.velocity / 127.0f);
+            break;
+        }
+
+        case stringfield::ActivityRecord::NoteOff:
+            // The newest sounding instance of this note ends
+            for (int i = notes.size() - 1; i >= 0; --i)
+            {
+                auto& note = notes[i];
+                if (note.end < 0 && note.note == record.note && note.channel == record.channel)
+                {
+                    note.end = record.time;
+                    break;
+                }
+            }
+            break;
+
+        case stringfield::ActivityRecord::PedalDown:
+            if (pedalChannels == 0)
+                pedalSpans.pushBack({ record.time, -1 });
+            pedalChannels = (uint16_t)(pedalChannels | (1u << ((record.channel - 1) & 15)));
+            break;
+
+        case stringfield::ActivityRecord::PedalUp:
+            pedalChannels = (uint16_t)(pedalChannels & ~(1u << ((record.channel - 1) & 15)));
+            if (pedalChannels == 0 && ! pedalSpans.empty() && pedalSpans[pedalSpans.size() - 1].end < 0)
+                pedalSpans[pedalSpans.size() - 1].end = record.time;
+            break;
+
+        default:
+            break;
+    }
+}
+
+void ActivityView::timerCallback()
+{
+    bool changed = false;
+
+    stringfield::ActivityRecord record;
+    for (int i = 0; i < maxRecordsPerTick && feed.pop(record); ++i)
+    {
+        handleRecord(record);
+        changed = true;
+    }
+
+    for (auto& meter : meters)
+    {
+        if (meter > 0.0f)
+        {
+            meter = meter < 0.01f ? 0.0f : meter * meterDecay;
+            changed = true;
+        }
+    }
+
+    if (changed)
+        repaint();
+}
+
+void ActivityView::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds();
+
+    g.fillAll(juce::Colour(0xFF141414));
+    g.setColour(juce::Colour(0xFF5A5A5A));
+    g.drawRect(bounds, 1);
+    bounds.reduce(2, 2);
+
+    // Route meters on the right, one thin bar per channel
+    auto meterArea = bounds.removeFromRight(16 * meterWidth);
+    for (int ch = 0; ch < 16; ++ch)
+    {
+        auto bar = meterArea.withX(meterArea.getX() + ch * meterWidth).withWidth(meterWidth - 1);
+        g.setColour(juce::Colour(0xFF2A2A2A));
+        g.fillRect(bar);
+
+        const int height = juce::roundToInt(meters[ch] * (float)bar.getHeight());
+        g.setColour(routeColour(ch + 1));
+        g.fillRect(bar.removeFromBottom(height));
+    }
+
+    bounds.removeFromRight(4);
+    auto pedalArea = bounds.removeFromBottom(4);
+    auto roll = bounds;
+
+    const double sampleRate = juce::jmax(1.0, getSampleRate());
+    const auto windowSamples = (int64_t)(windowSeconds * sampleRate);
+    const int64_t windowStart = now - windowSamples;
+
+    auto xFor = [&](int64_t time)
+    {
+        return (float)roll.getX() + (float)roll.getWidth() * (float)(time - windowStart) / (float)windowSamples;
+    };
+
+    // Sustain pedal
+    g.setColour(juce::Colour(0x80D4AF37));
+    for (int i = 0; i < pedalSpans.size(); ++i)
+    {
+        const auto& span = pedalSpans[i];
+        const int64_t end = span.end < 0 ? now : span.end;
+        if (end < windowStart)
+            continue;
+
+        const float x0 = juce::jmax((float)roll.getX(), xFor(span.start));
+        g.fillRect(juce::Rectangle<float>(x0, (float)pedalArea.getY(), xFor(end) - x0, (float)pedalArea.getHeight()));
+    }
+
+    // Notes, brightness by velocity
+    const float rowHeight = (float)roll.getHeight() / (float)(highestNote - lowestNote + 1);
+    for (int i = 0; i < notes.size(); ++i)
+    {
+        const auto& note = notes[i];
+        const int64_t end = note.end < 0 ? now : note.end;
+        if (end < windowStart)
+            continue;
+
+        const int pitch = juce::jlimit(lowestNote, highestNote, (int)note.note);
+        const float x0 = juce::jmax((float)roll.getX(), xFor(note.start));
+        const float y = (float)roll.getBottom() - (float)(pitch - lowestNote + 1) * rowHeight;
+
+        g.setColour(routeColour(note.channel).withAlpha(0.35f + 0.65f * note.velocity / 127.0f));
+        g.fillRect(juce::Rectangle<float>(x0, y, juce::jmax(1.0f, xFor(end) - x0), juce::jmax(1.0f, rowHeight)));
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "Core/ActivityFeed.h"
+#include "Core/FixedRingBuffer.h"
+
+// Scrolling piano roll of what the generator emits, with an activity meter
+// per route (MIDI channel) and the sustain pedal as a band underneath.
+//
+// Drains an ActivityFeed on the message thread refreshRateHz times a second;
+// nothing here touches the audio thread. Time runs with the host sample
+// clock, so the roll stands still while the transport is stopped.
+class ActivityView : public juce::Component,
+                     private juce::Timer
+{
+public:
+    static constexpr int refreshRateHz = 30;
+    static constexpr double windowSeconds = 8.0;
+
+    ActivityView(stringfield::ActivityFeed& feed, std::function<double()> getSampleRate);
+
+    void paint(juce::Graphics&) override;
+
+private:
+    void timerCallback() override;
+    void handleRecord(const stringfield::ActivityRecord& record);
+    void clearHistory();
+
+    struct Note
+    {
+        int64_t start = 0;
+        int64_t end = -1;             // -1 while sounding
+        uint8_t note = 0;
+        uint8_t channel = 1;
+        uint8_t velocity = 0;
+    };
+
+    struct PedalSpan
+    {
+        int64_t start = 0;
+        int64_t end = -1;
+    };
+
+    stringfield::ActivityFeed& feed;
+    std::function<double()> getSampleRate;
+
+    // Oldest entries fall off the front once the rings are full
+    stringfield::FixedRingBuffer<Note, 2048> notes;
+    stringfield::FixedRingBuffer<PedalSpan, 128> pedalSpans;
+    uint16_t pedalChannels = 0;       // Bit ch-1: pedal held on that channel
+
+    float meters[16] {};              // Route activity, decays every tick
+    int64_t now = 0;                  // Latest sample time seen
+
+    JUCE_DECLARE_NON_COPYABLE(ActivityView)
+};
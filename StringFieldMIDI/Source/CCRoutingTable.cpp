@@ -0,0 +1,26 @@
+#include "CCRoutingTable.h"
+#include "ParamSnapshot.h"
+
+std::unique_ptr<CCRoutingTable> CCRoutingTable::build(const std::map<int, juce::String>& ccToParameter,
+                                                      juce::AudioProcessorValueTreeState& apvts)
+{
+    auto table = std::make_unique<CCRoutingTable>();
+
+    for (const auto& mapping : ccToParameter)
+    {
+        if (mapping.first < 0 || mapping.first > 127)
+            continue;
+
+        Route route;
+        route.parameter = apvts.getParameter(mapping.second);
+        route.index = ParamSnapshot::indexOf(mapping.second);
+
+        if (route.parameter == nullptr || route.index < 0)
+            continue;
+
+        for (auto& channel : table->routes)
+            channel[mapping.first] = route;
+    }
+
+    return table;
+}
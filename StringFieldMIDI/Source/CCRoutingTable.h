@@ -0,0 +1,26 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <map>
+
+// Direct CC → parameter lookup for the audio thread: one slot per MIDI
+// channel and controller number. Built on the message thread whenever the
+// CC mappings change, then handed over whole; never modified afterwards.
+struct CCRoutingTable
+{
+    struct Route
+    {
+        juce::RangedAudioParameter* parameter = nullptr;
+        int index = -1;             // ParamSnapshot::Index
+    };
+
+    Route routes[16][128];          // [channel - 1][cc]
+
+    const Route& get(int channel, int cc) const noexcept
+    {
+        return routes[(channel - 1) & 15][cc & 127];
+    }
+
+    // Mappings apply on every channel (conductor CCs are omni)
+    static std::unique_ptr<CCRoutingTable> build(const std::map<int, juce::String>& ccToParameter,
+                                                 juce::AudioProcessorValueTreeState& apvts);
+};
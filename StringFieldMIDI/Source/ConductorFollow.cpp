@@ -0,0 +1,113 @@
+#include "ConductorFollow.h"
+
+ConductorFollowSettings::ConductorFollowSettings(juce::AudioProcessorValueTreeState& apvts)
+{
+    for (int i = 0; i < ParamSnapshot::numParams; ++i)
+    {
+        if (auto* param = apvts.getParameter(ParamSnapshot::ids[i]))
+        {
+            const auto& range = param->getNormalisableRange();
+            minValues[i] = range.start;
+            maxValues[i] = range.end;
+        }
+    }
+
+    setDefaults();
+}
+
+void ConductorFollowSettings::setDefaults()
+{
+    for (int i = 0; i < ParamSnapshot::numParams; ++i)
+    {
+        modes[i] = Ignore;
+        offsets[i] = 0.0f;
+    }
+
+    for (int i : { ParamSnapshot::rate, ParamSnapshot::density, ParamSnapshot::energy,
+                   ParamSnapshot::center, ParamSnapshot::spread, ParamSnapshot::vel,
+                   ParamSnapshot::memory, ParamSnapshot::articulation, ParamSnapshot::pulse,
+                   ParamSnapshot::tempo, ParamSnapshot::regularity })
+        modes[i] = Track;
+}
+
+void ConductorFollowSettings::applyTo(stringfield::EngineParams& params,
+                                      const stringfield::ConductorBus::Frame& frame) const noexcept
+{
+    for (int i = 0; i < ParamSnapshot::numParams; ++i)
+    {
+        if (modes[i] == Ignore)
+            continue;
+
+        float value = frame.values[i];
+        if (modes[i] == Offset)
+            value = juce::jlimit(minValues[i], maxValues[i], value + offsets[i]);
+
+        ParamSnapshot::apply(params, i, value);
+    }
+}
+
+juce::String ConductorFollowSettings::toString() const
+{
+    juce::String text;
+    for (int i = 0; i < ParamSnapshot::numParams; ++i)
+        text += juce::String(ParamSnapshot::ids[i]) + ":" + juce::String((int)modes[i])
+              + ":" + juce::String(offsets[i]) + ";";
+    return text;
+}
+
+void ConductorFollowSettings::fromString(const juce::String& text)
+{
+    setDefaults();
+
+    for (const auto& entry : juce::StringArray::fromTokens(text, ";", ""))
+    {
+        juce::StringArray parts = juce::StringArray::fromTokens(entry, ":", "");
+        if (parts.size() != 3)
+            continue;
+
+        const int index = ParamSnapshot::indexOf(parts[0]);
+        const int mode = parts[1].getIntValue();
+        if (index < 0 || mode < Ignore || mode > Offset)
+            continue;
+
+        modes[index] = (Mode)mode;
+        offsets[index] = parts[2].getFloatValue();
+    }
+}
+
+void ConductorFollowSettings::write(juce::OutputStream& out) const
+{
+    out.writeCompressedInt(ParamSnapshot::numParams);
+    for (int i = 0; i < ParamSnapshot::numParams; ++i)
+    {
+        out.writeString(ParamSnapshot::ids[i]);
+        out.writeByte((char)modes[i]);
+        out.writeFloat(offsets[i]);
+    }
+}
+
+bool ConductorFollowSettings::read(juce::InputStream& in)
+{
+    setDefaults();
+
+    const int count = in.readCompressedInt();
+    if (count < 0 || count > 256)
+        return false;
+
+    // Unknown IDs (parameters since removed) are skipped, like fromString
+    for (int n = 0; n < count; ++n)
+    {
+        const auto id = in.readString();
+        const int mode = (uint8_t)in.readByte();
+        const float offset = in.readFloat();
+
+        const int index = ParamSnapshot::indexOf(id);
+        if (index >= 0 && mode <= Offset)
+        {
+            modes[index] = (Mode)mode;
+            offsets[index] = offset;
+        }
+    }
+
+    return true;
+}
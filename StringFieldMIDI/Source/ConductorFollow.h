@@ -0,0 +1,41 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "Core/ConductorBus.h"
+#include "ParamSnapshot.h"
+
+// How a follower instance takes each parameter from the conductor bus.
+// Edited on the message thread; the audio thread gets immutable copies.
+struct ConductorFollowSettings
+{
+    enum Mode : uint8_t
+    {
+        Ignore = 0,     // Keep this instance's own value
+        Track,          // Take the leader's value
+        Offset          // Leader's value + offset (real units), clamped to range
+    };
+
+    Mode modes[ParamSnapshot::numParams] {};
+    float offsets[ParamSnapshot::numParams] {};
+    float minValues[ParamSnapshot::numParams] {};
+    float maxValues[ParamSnapshot::numParams] {};
+
+    // The conductor-ready parameters (those with default CCs) track, the rest
+    // (seed, routes, PC mode, pedal, voices, steal, memory mode) stay local
+    explicit ConductorFollowSettings(juce::AudioProcessorValueTreeState& apvts);
+
+    // Overrides the followed parameters with the leader's frame
+    void applyTo(stringfield::EngineParams& params,
+                 const stringfield::ConductorBus::Frame& frame) const noexcept;
+
+    // State format: "paramID:mode:offset;" per parameter
+    juce::String toString() const;
+    void fromString(const juce::String& text);
+
+    // Binary state: count, then paramID, mode byte and offset per parameter.
+    // Returns false on an implausible count (truncation is the caller's check).
+    void write(juce::OutputStream& out) const;
+    bool read(juce::InputStream& in);
+
+private:
+    void setDefaults();
+};
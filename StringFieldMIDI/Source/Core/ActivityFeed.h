@@ -0,0 +1,62 @@
+#pragma once
+#include "MidiEvent.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <cstdint>
+
+namespace stringfield
+{
+
+// One emitted note or pedal change, as shown by the editor's activity view
+struct ActivityRecord
+{
+    enum Kind : uint8_t { NoteOn, NoteOff, PedalDown, PedalUp };
+
+    int64_t time = 0;         // Host sample time
+    uint8_t kind = NoteOn;
+    uint8_t channel = 1;      // 1-16
+    uint8_t note = 0;
+    uint8_t velocity = 0;
+};
+
+// Emitted events → editor. The audio thread pays one wait-free queue write
+// per note or pedal event; when the queue is full (editor closed or
+// stalled) records are dropped and counted, never waited for. The editor
+// drains it at its own pace.
+class ActivityFeed
+{
+public:
+    static constexpr int Capacity = 4096;
+
+    // === Audio thread ===
+    void push(const MidiEvent& event, int64_t sampleTime) noexcept
+    {
+        ActivityRecord record;
+        record.time = sampleTime;
+        record.channel = (uint8_t)event.getChannel();
+        record.note = event.data[1];
+        record.velocity = event.data[2];
+
+        if (event.isNoteOn())
+            record.kind = ActivityRecord::NoteOn;
+        else if (event.isNoteOff())
+            record.kind = ActivityRecord::NoteOff;
+        else if (event.isController() && event.data[1] == 64)
+            record.kind = event.data[2] >= 64 ? ActivityRecord::PedalDown : ActivityRecord::PedalUp;
+        else
+            return;
+
+        if (!queue.push(record))
+            dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // === Editor ===
+    bool pop(ActivityRecord& record) noexcept { return queue.pop(record); }
+    uint64_t getDroppedCount() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    SpscQueue<ActivityRecord, Capacity> queue;
+    std::atomic<uint64_t> dropped { 0 };
+};
+
+} // namespace stringfield
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+
+namespace stringfield
+{
+
+// Walker/Vose alias table over up to MaxSize outcomes. Building is O(n);
+// every draw then costs one 32-bit random number and one lookup, whatever
+// the shape of the distribution. Storage is inline, so neither building nor
+// sampling allocates, and the table copies with its owner.
+//
+// A uniform table draws exactly like CounterRandom::nextInt(size).
+template <int MaxSize>
+class AliasTable
+{
+public:
+    static_assert(MaxSize > 0 && MaxSize <= 256, "aliases are stored as bytes");
+
+    // Weights need not be normalised. Negative weights count as 0; if
+    // nothing is left (or count < 1) the table is uniform over max(1, count).
+    void build(const float* weights, int count) noexcept
+    {
+        n = count < 1 ? 1 : (count > MaxSize ? MaxSize : count);
+
+        double total = 0.0;
+        for (int i = 0; i < n; ++i)
+            total += weights != nullptr && weights[i] > 0.0f ? (double)weights[i] : 0.0;
+
+        // Probabilities scaled so that the average column holds exactly 1
+        double scaled[MaxSize];
+        for (int i = 0; i < n; ++i)
+        {
+            const double w = total > 0.0 ? (weights[i] > 0.0f ? (double)weights[i] : 0.0) : 1.0;
+            scaled[i] = total > 0.0 ? w * n / total : 1.0;
+            alias[i] = (uint8_t)i;
+        }
+
+        // Vose: pair each under-full column with an over-full one
+        int small[MaxSize], large[MaxSize];
+        int numSmall = 0, numLarge = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            if (scaled[i] < 1.0)
+                small[numSmall++] = i;
+            else
+                large[numLarge++] = i;
+        }
+
+        while (numSmall > 0 && numLarge > 0)
+        {
+            const int s = small[--numSmall];
+            const int l = large[--numLarge];
+
+            threshold[s] = toThreshold(scaled[s]);
+            alias[s] = (uint8_t)l;
+
+            scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+            if (scaled[l] < 1.0)
+                small[numSmall++] = l;
+            else
+                large[numLarge++] = l;
+        }
+
+        // What remains is full (up to rounding)
+        while (numLarge > 0)
+            threshold[large[--numLarge]] = fullColumn;
+        while (numSmall > 0)
+            threshold[small[--numSmall]] = fullColumn;
+    }
+
+    // The high part of r * n picks a column, the low part chooses between
+    // it and its alias
+    int sample(uint32_t random) const noexcept
+    {
+        const uint64_t scaledRandom = (uint64_t)random * (uint32_t)n;
+        const int column = (int)(scaledRandom >> 32);
+        return (scaledRandom & 0xFFFFFFFFu) < threshold[column] ? column : alias[column];
+    }
+
+    int size() const noexcept { return n; }
+
+private:
+    static constexpr uint64_t fullColumn = 1ull << 32;
+
+    static uint64_t toThreshold(double probability) noexcept
+    {
+        if (probability <= 0.0)
+            return 0;
+        if (probability >= 1.0)
+            return fullColumn;
+        return (uint64_t)(probability * 4294967296.0);
+    }
+
+    int n = 1;
+    uint64_t threshold[MaxSize] { fullColumn };
+    uint8_t alias[MaxSize] {};
+};
+
+} // namespace stringfield
@@ -0,0 +1,147 @@
+#include "AllocationTrap.h"
+
+#if STRINGFIELD_ALLOCATION_TRAP
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace stringfield
+{
+
+namespace
+{
+    thread_local int noAllocationDepth = 0;
+    thread_local bool inTrapHandler = false;
+
+    std::atomic<AllocationTrapHandler> trapHandler { nullptr };
+    std::atomic<uint64_t> trappedCount { 0 };
+
+    void defaultTrapHandler(std::size_t bytes)
+    {
+        std::fprintf(stderr, "StringField: heap %s of %zu bytes on the audio thread\n",
+                     bytes > 0 ? "allocation" : "deallocation", bytes);
+        std::abort();
+    }
+
+    void checkAllocation(std::size_t bytes) noexcept
+    {
+        if (noAllocationDepth == 0 || inTrapHandler)
+            return;
+
+        trappedCount.fetch_add(1, std::memory_order_relaxed);
+
+        inTrapHandler = true;
+        auto handler = trapHandler.load(std::memory_order_acquire);
+        (handler != nullptr ? handler : defaultTrapHandler)(bytes);
+        inTrapHandler = false;
+    }
+
+    void* allocate(std::size_t size)
+    {
+        checkAllocation(size);
+
+        if (void* p = std::malloc(size > 0 ? size : 1))
+            return p;
+
+        throw std::bad_alloc();
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment)
+    {
+        checkAllocation(size);
+
+        const auto align = (std::size_t)alignment;
+        const std::size_t rounded = ((size > 0 ? size : 1) + align - 1) / align * align;
+
+       #if defined(_WIN32)
+        if (void* p = _aligned_malloc(rounded, align))
+            return p;
+       #else
+        if (void* p = std::aligned_alloc(align, rounded))
+            return p;
+       #endif
+
+        throw std::bad_alloc();
+    }
+
+    void release(void* p) noexcept
+    {
+        if (p != nullptr)
+        {
+            checkAllocation(0);
+            std::free(p);
+        }
+    }
+
+    void releaseAligned(void* p) noexcept
+    {
+        if (p != nullptr)
+        {
+            checkAllocation(0);
+           #if defined(_WIN32)
+            _aligned_free(p);
+           #else
+            std::free(p);
+           #endif
+        }
+    }
+}
+
+ScopedNoAllocation::ScopedNoAllocation() noexcept { ++noAllocationDepth; }
+ScopedNoAllocation::~ScopedNoAllocation() noexcept { --noAllocationDepth; }
+
+ScopedAllocationAllowed::ScopedAllocationAllowed() noexcept : savedDepth(noAllocationDepth)
+{
+    noAllocationDepth = 0;
+}
+
+ScopedAllocationAllowed::~ScopedAllocationAllowed() noexcept
+{
+    noAllocationDepth = savedDepth;
+}
+
+void setAllocationTrapHandler(AllocationTrapHandler handler) noexcept
+{
+    trapHandler.store(handler, std::memory_order_release);
+}
+
+uint64_t getTrappedAllocationCount() noexcept
+{
+    return trappedCount.load(std::memory_order_relaxed);
+}
+
+} // namespace stringfield
+
+// === Global allocation functions ===
+
+void* operator new(std::size_t size) { return stringfield::allocate(size); }
+void* operator new[](std::size_t size) { return stringfield::allocate(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return stringfield::allocate(size); } catch (...) { return nullptr; }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return stringfield::allocate(size); } catch (...) { return nullptr; }
+}
+
+void* operator new(std::size_t size, std::align_val_t al) { return stringfield::allocateAligned(size, al); }
+void* operator new[](std::size_t size, std::align_val_t al) { return stringfield::allocateAligned(size, al); }
+
+void operator delete(void* p) noexcept { stringfield::release(p); }
+void operator delete[](void* p) noexcept { stringfield::release(p); }
+void operator delete(void* p, std::size_t) noexcept { stringfield::release(p); }
+void operator delete[](void* p, std::size_t) noexcept { stringfield::release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { stringfield::release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { stringfield::release(p); }
+
+void operator delete(void* p, std::align_val_t) noexcept { stringfield::releaseAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { stringfield::releaseAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { stringfield::releaseAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { stringfield::releaseAligned(p); }
+
+#endif
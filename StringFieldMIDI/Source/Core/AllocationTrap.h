@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Debug-build guard against heap use on the audio thread.
+//
+// When STRINGFIELD_ALLOCATION_TRAP is defined (CMake sets it in Debug builds
+// of the executables linking stringfield_allocation_trap, never the plugin),
+// global operator new/delete are replaced and any allocation or deallocation
+// made while a ScopedNoAllocation is alive on the current thread calls the
+// trap handler. The default handler prints and aborts. In other builds the
+// scope compiles to nothing.
+
+namespace stringfield
+{
+
+using AllocationTrapHandler = void (*)(std::size_t bytes);
+
+#if STRINGFIELD_ALLOCATION_TRAP
+
+class ScopedNoAllocation
+{
+public:
+    ScopedNoAllocation() noexcept;
+    ~ScopedNoAllocation() noexcept;
+
+    ScopedNoAllocation(const ScopedNoAllocation&) = delete;
+    ScopedNoAllocation& operator=(const ScopedNoAllocation&) = delete;
+};
+
+// Temporarily lifts the trap, for calls into code we don't own (e.g. host
+// notifications) that may allocate behind our back.
+class ScopedAllocationAllowed
+{
+public:
+    ScopedAllocationAllowed() noexcept;
+    ~ScopedAllocationAllowed() noexcept;
+
+    ScopedAllocationAllowed(const ScopedAllocationAllowed&) = delete;
+    ScopedAllocationAllowed& operator=(const ScopedAllocationAllowed&) = delete;
+
+private:
+    int savedDepth;
+};
+
+// Replaces the abort-on-allocation handler (nullptr restores it). Handlers run
+// with the trap lifted, so they may allocate.
+void setAllocationTrapHandler(AllocationTrapHandler handler) noexcept;
+
+// Number of trapped allocations since startup
+uint64_t getTrappedAllocationCount() noexcept;
+
+#else
+
+class ScopedNoAllocation
+{
+public:
+    ScopedNoAllocation() noexcept {}
+};
+
+class ScopedAllocationAllowed
+{
+public:
+    ScopedAllocationAllowed() noexcept {}
+};
+
+inline void setAllocationTrapHandler(AllocationTrapHandler) noexcept {}
+inline uint64_t getTrappedAllocationCount() noexcept { return 0; }
+
+#endif
+
+} // namespace stringfield
@@ -0,0 +1,391 @@
+#include "BatchKernel.h"
+#include <algorithm>
+
+namespace stringfield
+{
+
+namespace
+{
+    template <typename T>
+    T limit(T lowerLimit, T upperLimit, T value)
+    {
+        return value < lowerLimit ? lowerLimit : (upperLimit < value ? upperLimit : value);
+    }
+
+    struct DiscardSink : EventSink
+    {
+        void handleEvent(const MidiEvent&) override {}
+    };
+}
+
+bool BatchKernel::supports(const EngineParams& params, const CompiledPitchClassSet* pcSet)
+{
+    const bool pcSetActive = params.pcMode > 0 && pcSet != nullptr && pcSet->numPitchClasses > 0;
+    return !params.pulse && params.memory <= 0 && !pcSetActive;
+}
+
+BatchKernel::BatchKernel(double sampleRate, const CompiledWeightProfile* profile)
+    : sr(sampleRate), weights(profile)
+{
+}
+
+void BatchKernel::render(Stream* streams, int numStreams, int64_t length)
+{
+    for (int first = 0; first < numStreams; first += MaxGroup)
+        renderGroup(streams + first, std::min(MaxGroup, numStreams - first), length);
+}
+
+void BatchKernel::renderGroup(Stream* streams, int numStreams, int64_t length)
+{
+    std::vector<Player> players((size_t)numStreams);
+    std::vector<Player*> active;
+
+    for (int s = 0; s < numStreams; ++s)
+    {
+        startPlayer(players[(size_t)s], streams[s], length);
+        active.push_back(&players[(size_t)s]);
+    }
+
+    // A stream leaves the group when its next note falls past the end
+    while (!active.empty())
+    {
+        const int numActive = (int)active.size();
+        drawChunk(active.data(), numActive, length);
+
+        int kept = 0;
+        for (int a = 0; a < numActive; ++a)
+            if (playChunk(*active[(size_t)a], a, length))
+                active[(size_t)kept++] = active[(size_t)a];
+
+        active.resize((size_t)kept);
+    }
+}
+
+void BatchKernel::startPlayer(Player& player, Stream& stream, int64_t length)
+{
+    const EngineParams& params = stream.params;
+    StringFieldEngine& engine = player.tables;
+
+    DiscardSink discard;
+    engine.prepare(sr);
+    engine.setWeightProfile(weights);
+    engine.setParameters(params, 0, discard);
+
+    player.stream = &stream;
+    player.duration = (int64_t)engine.calculateDuration(params.energy);
+
+    // Same arithmetic as StringFieldEngine::scheduleNextNote (rate mode)
+    player.baseInterval = 1.0 / std::max(0.001f, params.rate);
+    player.jitterScale = params.energy * player.baseInterval;
+
+    // Room for the expected notes (on and off each), pedal changes and the stop
+    const double expectedNotes = (double)length / std::max(1.0, player.baseInterval * sr) * params.density;
+    stream.events.reserve(stream.events.size() + (size_t)(2.2 * expectedNotes) + 64);
+
+    // The engine's first render schedules the first pedal change at 0
+    if (params.pedal)
+        schedulePedal(player, 0);
+}
+
+void BatchKernel::drawChunk(Player* const* active, int numActive, int64_t length)
+{
+    // Notes per stream: enough to pass the end at the shortest possible
+    // intervals, capped at a chunk (a stream that needs more gets another pass)
+    firstItem.resize((size_t)numActive + 1);
+
+    int numItems = 0;
+    for (int a = 0; a < numActive; ++a)
+    {
+        const Player& player = *active[a];
+        const double shortest = std::max(0.001, 0.5 * player.baseInterval) * sr;
+        const double remaining = (double)(length - player.lastOnset) / std::max(1.0, shortest);
+
+        firstItem[(size_t)a] = numItems;
+        numItems += (int)std::min<double>(ChunkNotes, remaining + 2.0);
+    }
+    firstItem[(size_t)numActive] = numItems;
+
+    // Two rhythm blocks per note, at most three more per sounding note
+    for (auto& words : counter)
+        words.resize((size_t)(3 * numItems));
+    for (auto& words : key)
+        words.resize((size_t)(3 * numItems));
+    for (auto& words : block)
+        words.resize((size_t)(3 * numItems));
+
+    // === Rhythm: interval (lane 0) and gate (lane 1) of every note ===
+    for (int a = 0; a < numActive; ++a)
+    {
+        const int first = firstItem[(size_t)a];
+        setItems(first, firstItem[(size_t)a + 1] - first, active[a]->noteIndex,
+                 (uint32_t)active[a]->stream->params.seed, RandomStream::Rhythm);
+    }
+
+    repeatItems(numItems, 1, 1, RandomStream::Rhythm);
+
+    generateBlocks(2 * numItems);
+
+    intervals.resize((size_t)numItems);
+    gate.resize((size_t)numItems);
+    sounding.resize((size_t)numItems);
+
+    int numSounding = 0;
+
+    for (int a = 0; a < numActive; ++a)
+    {
+        const Player& player = *active[a];
+        const float density = player.stream->params.density;
+
+        for (int i = firstItem[(size_t)a]; i < firstItem[(size_t)a + 1]; ++i)
+        {
+            // CounterRandom::nextDouble() and nextFloat() of the first block
+            const uint64_t bits = ((uint64_t)block[0][(size_t)i] << 21) ^ (block[1][(size_t)i] >> 11);
+            const double draw = (double)bits * (1.0 / 9007199254740992.0);
+            const double jitter = (draw - 0.5) * player.jitterScale;
+            const double intervalSec = std::max(0.001, player.baseInterval + jitter);
+            intervals[(size_t)i] = (int64_t)(intervalSec * sr);
+
+            const float gateDraw = (float)(block[0][(size_t)(i + numItems)] >> 8) * (1.0f / 16777216.0f);
+            const bool sounds = gateDraw <= density;
+            gate[(size_t)i] = sounds ? 1 : 0;
+
+            // Branch-free list of the items that sound
+            sounding[(size_t)numSounding] = i;
+            numSounding += sounds ? 1 : 0;
+        }
+    }
+
+    // === Pitch, velocity and route: sounding notes only ===
+    for (int a = 0, g = 0; a < numActive; ++a)
+    {
+        const int first = firstItem[(size_t)a];
+        const uint64_t firstNote = active[a]->noteIndex;
+        const uint32_t seed = (uint32_t)active[a]->stream->params.seed;
+
+        for (; g < numSounding && sounding[(size_t)g] < firstItem[(size_t)a + 1]; ++g)
+            setItems(g, 1, firstNote + (uint64_t)(sounding[(size_t)g] - first), seed, RandomStream::Pitch);
+    }
+
+    repeatItems(numSounding, 1, 0, RandomStream::Velocity);
+    repeatItems(numSounding, 2, 0, RandomStream::Articulation);
+
+    generateBlocks(3 * numSounding);
+
+    notes.resize((size_t)numSounding);
+    velocities.resize((size_t)numSounding);
+    channels.resize((size_t)numSounding);
+
+    for (int a = 0, g = 0; a < numActive; ++a)
+    {
+        const StringFieldEngine& engine = active[a]->tables;
+        const EngineParams& params = engine.params;
+
+        // Same choices as pickNote / pickVelocity / pickArticulation
+        for (; g < numSounding && sounding[(size_t)g] < firstItem[(size_t)a + 1]; ++g)
+        {
+            const uint32_t pitchWord = block[0][(size_t)g];
+            const uint32_t velocityWord = block[0][(size_t)(g + numSounding)];
+            const uint32_t routeWord = block[0][(size_t)(g + 2 * numSounding)];
+
+            notes[(size_t)g] = (uint8_t)(params.spread <= 0 ? limit(0, 127, params.center)
+                                                            : engine.pitchTableLow + engine.pitchTable.sample(pitchWord));
+
+            const int variation = -10 + (int)(((uint64_t)velocityWord * 21u) >> 32);
+            velocities[(size_t)g] = (uint8_t)limit(1, 127, params.vel + variation);
+
+            channels[(size_t)g] = (uint8_t)(params.routes <= 1 ? 1 : 1 + engine.routeTable.sample(routeWord));
+        }
+    }
+
+    sounding.resize((size_t)numSounding);
+}
+
+void BatchKernel::setItems(int first, int count, uint64_t firstNote, uint32_t seed, RandomStream stream)
+{
+    // Counter { 0, 0, note index }, key { seed, stream }: CounterRandom::seek()
+    uint32_t* const c0 = counter[0].data() + first;
+    uint32_t* const c1 = counter[1].data() + first;
+    uint32_t* const c2 = counter[2].data() + first;
+    uint32_t* const c3 = counter[3].data() + first;
+    uint32_t* const k0 = key[0].data() + first;
+    uint32_t* const k1 = key[1].data() + first;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const uint64_t note = firstNote + (uint64_t)i;
+        c0[i] = 0;
+        c1[i] = 0;
+        c2[i] = (uint32_t)note;
+        c3[i] = (uint32_t)(note >> 32);
+        k0[i] = seed;
+        k1[i] = (uint32_t)stream;
+    }
+}
+
+void BatchKernel::repeatItems(int count, int copy, uint32_t lane, RandomStream stream)
+{
+    // The same notes again, on another lane or stream
+    const size_t offset = (size_t)(copy * count);
+
+    for (int w = 0; w < 4; ++w)
+        std::copy(counter[w].begin(), counter[w].begin() + count, counter[w].begin() + (ptrdiff_t)offset);
+    std::copy(key[0].begin(), key[0].begin() + count, key[0].begin() + (ptrdiff_t)offset);
+
+    std::fill(counter[1].begin() + (ptrdiff_t)offset, counter[1].begin() + (ptrdiff_t)offset + count, lane);
+    std::fill(key[1].begin() + (ptrdiff_t)offset, key[1].begin() + (ptrdiff_t)offset + count, (uint32_t)stream);
+}
+
+void BatchKernel::generateBlocks(int count)
+{
+    const uint32_t* const counters[4] = { counter[0].data(), counter[1].data(), counter[2].data(), counter[3].data() };
+    const uint32_t* const keys[2] = { key[0].data(), key[1].data() };
+    uint32_t* const out[4] = { block[0].data(), block[1].data(), block[2].data(), block[3].data() };
+
+    PhiloxBatch::generate(counters, keys, out, count, isa);
+}
+
+bool BatchKernel::playChunk(Player& player, int a, int64_t length)
+{
+    const int first = firstItem[(size_t)a];
+    const int last = firstItem[(size_t)a + 1];
+
+    auto g = (int)(std::lower_bound(sounding.begin(), sounding.end(), first) - sounding.begin());
+
+    for (int i = first; i < last; ++i)
+    {
+        const int64_t onset = player.lastOnset + intervals[(size_t)i];
+        if (onset >= length)
+        {
+            finish(player, length);
+            return false;
+        }
+
+        // Pedal changes and releases due at the onset come first
+        if (player.nextPedal <= onset || (!player.releases.empty() && player.releases[0].time <= onset))
+            drain(player, onset);
+
+        if (gate[(size_t)i] != 0)
+        {
+            playNote(player, onset, notes[(size_t)g], velocities[(size_t)g], channels[(size_t)g]);
+            ++g;
+        }
+
+        player.lastOnset = onset;
+    }
+
+    player.noteIndex += (uint64_t)(last - first);
+    return true;
+}
+
+void BatchKernel::playNote(Player& player, int64_t now, int note, int velocity, int channel)
+{
+    StringFieldEngine& engine = player.tables;
+    VoicePool& voices = engine.voices;
+    auto& events = player.stream->events;
+
+    // Voice allocation as in StringFieldEngine::handleNoteOn
+    int slot = voices.findNote(note, channel);
+    if (slot < 0)
+        slot = voices.findFree();
+    if (slot < 0)
+        slot = voices.chooseVictim((StealMode)engine.params.steal, channel);
+
+    Voice& voice = voices[slot];
+
+    if (voice.active)
+    {
+        if (voices.getSize() == 1 && channel != voice.channel && engine.pedalDown)
+            events.push_back(BatchEvent::at(now, MidiEvent::controller(0, voice.channel, 64, 0)));
+
+        events.push_back(BatchEvent::at(now, MidiEvent::noteOff(0, voice.channel, voice.note)));
+
+        // Its pending release goes too (the others keep their order)
+        for (int i = player.releases.size(); --i >= 0;)
+        {
+            const Release release = player.releases[0];
+            player.releases.popFront();
+            if (release.voice != slot)
+                player.releases.pushBack(release);
+        }
+    }
+
+    events.push_back(BatchEvent::at(now, MidiEvent::noteOn(0, channel, note, velocity)));
+
+    voice.active = true;
+    voice.note = note;
+    voice.channel = channel;
+    voice.velocity = velocity;
+    voice.startTime = now;
+    voice.offTime = now + player.duration;
+    player.releases.pushBack({ voice.offTime, slot });
+}
+
+void BatchKernel::drain(Player& player, int64_t until)
+{
+    VoicePool& voices = player.tables.voices;
+    auto& releases = player.releases;
+
+    for (;;)
+    {
+        const int64_t offTime = releases.empty() ? INT64_MAX : releases[0].time;
+
+        // At equal times the pedal goes first
+        if (player.nextPedal <= until && player.nextPedal <= offTime)
+        {
+            togglePedal(player, player.nextPedal);
+        }
+        else if (offTime <= until)
+        {
+            Voice& voice = voices[releases[0].voice];
+            releases.popFront();
+
+            player.stream->events.push_back(BatchEvent::at(offTime, MidiEvent::noteOff(0, voice.channel, voice.note)));
+            voice.active = false;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+void BatchKernel::togglePedal(Player& player, int64_t now)
+{
+    StringFieldEngine& engine = player.tables;
+    const bool down = !engine.pedalDown && StringFieldEngine::isPedalEngaged(engine.params.energy, engine.params.density);
+
+    if (down != engine.pedalDown)
+    {
+        engine.pedalDown = down;
+        for (int ch = 1; ch <= 16; ++ch)
+            player.stream->events.push_back(BatchEvent::at(now, MidiEvent::controller(0, ch, 64, down ? 127 : 0)));
+    }
+
+    schedulePedal(player, now);
+}
+
+void BatchKernel::schedulePedal(Player& player, int64_t now)
+{
+    StringFieldEngine& engine = player.tables;
+
+    engine.pedalRng.seek(engine.pedalIndex++);
+    const double waitSec = StringFieldEngine::drawPedalWait(engine.pedalRng, engine.params.energy,
+                                                            engine.params.density, engine.pedalDown);
+    player.nextPedal = now + (int64_t)(waitSec * sr);
+}
+
+void BatchKernel::finish(Player& player, int64_t length)
+{
+    drain(player, length - 1);
+
+    // StringFieldEngine::stop()
+    auto& events = player.stream->events;
+    for (int ch = 1; ch <= 16; ++ch)
+    {
+        events.push_back(BatchEvent::at(length, MidiEvent::controller(0, ch, 64, 0)));
+        events.push_back(BatchEvent::at(length, MidiEvent::controller(0, ch, 123, 0)));
+        events.push_back(BatchEvent::at(length, MidiEvent::controller(0, ch, 120, 0)));
+    }
+}
+
+} // namespace stringfield
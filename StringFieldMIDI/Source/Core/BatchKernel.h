@@ -0,0 +1,122 @@
+#pragma once
+#include "FixedRingBuffer.h"
+#include "PhiloxBatch.h"
+#include "StringFieldEngine.h"
+#include <cstdint>
+#include <vector>
+
+namespace stringfield
+{
+
+// A MIDI message of an offline render, at an absolute sample time
+struct BatchEvent
+{
+    int64_t time = 0;
+    uint8_t data[3] = { 0, 0, 0 };
+
+    static BatchEvent at(int64_t time, const MidiEvent& event)
+    {
+        BatchEvent e;
+        e.time = time;
+        e.data[0] = event.data[0];
+        e.data[1] = event.data[1];
+        e.data[2] = event.data[2];
+        return e;
+    }
+};
+
+// Offline generator for many independent streams at once (e.g. a seed grid).
+// Each stream's output is identical to a StringFieldEngine rendering
+// [0, length) with its parameters and then stopping at `length`.
+//
+// In rate mode without memory or PC set, a note's timing, gate, pitch,
+// velocity and route are pure functions of (seed, note index), so a stream's
+// notes can be generated ahead of playing them. The kernel does that for all
+// streams together, a chunk of note indices at a time:
+//   1. the Philox blocks of every stream go through PhiloxBatch (AVX2 or
+//      SSE2, picked at runtime) as one structure-of-arrays pass,
+//   2. intervals and gates are derived for every note, and pitch, velocity
+//      and route blocks computed only for the notes that sound,
+//   3. per stream, the notes are played out: voices, note-offs and the
+//      pedal, which is all the state there is, with no queue or sink.
+// Other modes keep state between notes (supports() is false); render those
+// with the engine.
+//
+// Not thread-safe; use one kernel per thread. Allocates freely.
+class BatchKernel
+{
+public:
+    struct Stream
+    {
+        EngineParams params;
+        std::vector<BatchEvent> events;   // Output, in time order
+    };
+
+    // Whether a stream with these settings can be rendered by the kernel
+    static bool supports(const EngineParams& params, const CompiledPitchClassSet* pcSet = nullptr);
+
+    // `weights` (nullptr = flat) is shared by every stream and must outlive the kernel
+    explicit BatchKernel(double sampleRate, const CompiledWeightProfile* weights = nullptr);
+
+    // Instruction set for the random numbers (default: the best available)
+    void setIsa(PhiloxBatch::Isa newIsa) { isa = newIsa; }
+
+    // Appends each stream's events for [0, length) plus the stop at `length`.
+    // Every stream must be supported.
+    void render(Stream* streams, int numStreams, int64_t length);
+
+private:
+    static constexpr int ChunkNotes = 128;     // Most note indices per stream per pass
+    static constexpr int MaxGroup = 32;        // Streams sharing the scratch arrays
+
+    struct Release
+    {
+        int64_t time;
+        int voice;
+    };
+
+    // Per-stream playing state
+    struct Player
+    {
+        Stream* stream = nullptr;
+        StringFieldEngine tables;             // Its tables, voices and pedal state
+        uint64_t noteIndex = 0;               // First note of the current chunk
+        int64_t lastOnset = 0;                // Notes are scheduled from the previous one
+        int64_t duration = 0;
+        double baseInterval = 0.0;
+        double jitterScale = 0.0;
+        int64_t nextPedal = INT64_MAX;
+
+        // Note-offs of the sounding voices. Onsets only move forward and
+        // every note lasts `duration`, so they come due in the order queued.
+        FixedRingBuffer<Release, VoicePool::MaxVoices> releases;
+    };
+
+    void renderGroup(Stream* streams, int numStreams, int64_t length);
+    void startPlayer(Player& player, Stream& stream, int64_t length);
+    void drawChunk(Player* const* active, int numActive, int64_t length);
+    void setItems(int first, int count, uint64_t firstNote, uint32_t seed, RandomStream stream);
+    void repeatItems(int count, int copy, uint32_t lane, RandomStream stream);
+    void generateBlocks(int count);
+    bool playChunk(Player& player, int a, int64_t length);
+    void playNote(Player& player, int64_t now, int note, int velocity, int channel);
+    void drain(Player& player, int64_t until);
+    void togglePedal(Player& player, int64_t now);
+    void schedulePedal(Player& player, int64_t now);
+    void finish(Player& player, int64_t length);
+
+    double sr;
+    const CompiledWeightProfile* weights;
+    PhiloxBatch::Isa isa = PhiloxBatch::getIsa();
+
+    // Scratch, structure-of-arrays. A pass draws items firstItem[a] ..
+    // firstItem[a + 1] - 1 for active stream a, one per note index.
+    std::vector<int> firstItem;
+    std::vector<uint32_t> counter[4], key[2], block[4];  // Philox input and output
+    std::vector<int64_t> intervals;                       // Per item, in samples
+    std::vector<uint8_t> gate;                            // Per item: the note sounds
+    std::vector<int> sounding;                            // Items that sound, in order
+    std::vector<uint8_t> notes, velocities, channels;     // Per sounding item
+};
+
+} // namespace stringfield
@@ -0,0 +1,292 @@
+#include "CheckpointBuilder.h"
+#include <cmath>
+
+namespace stringfield
+{
+
+namespace
+{
+    struct DiscardSink : EventSink
+    {
+        void handleEvent(const MidiEvent&) override {}
+    };
+}
+
+void CheckpointBuilder::prepare(double sampleRate)
+{
+    stopWorker();
+
+    sr = sampleRate;
+    leadSamples = std::llround(sr * LeadMs / 1000.0);
+
+    for (auto& store : stores)
+    {
+        store.cache.prepare();
+        store.epoch.store(0, std::memory_order_relaxed);
+        store.serial.store(0, std::memory_order_relaxed);
+    }
+
+    if (scratch == nullptr)
+        scratch = std::make_unique<Ensemble>();
+
+    // Nobody else touches the queue while the worker is down
+    Request request;
+    while (requests.pop(request)) {}
+
+    live = 0;
+    ready.store(1, std::memory_order_relaxed);
+    buildIndex = 2;
+    playout.store(0, std::memory_order_relaxed);
+    taken.store(0, std::memory_order_relaxed);
+    building.store(0, std::memory_order_relaxed);
+    signalled.store(false, std::memory_order_relaxed);
+
+    epoch = 1;
+    sentSerial = 0;
+    requestedEpoch = 0;
+    inStep = false;
+    wakePending = false;
+
+    quit = false;
+    thread = std::thread([this] { run(); });
+}
+
+void CheckpointBuilder::release()
+{
+    stopWorker();
+}
+
+void CheckpointBuilder::stopWorker()
+{
+    if (! thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(wakeLock);
+        quit = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+// === Audio thread ===
+
+void CheckpointBuilder::invalidate() noexcept
+{
+    if (++epoch == 0)
+        epoch = 1;
+
+    inStep = false;
+}
+
+bool CheckpointBuilder::restore(Ensemble& ensemble, const GeneratorState& state, int64_t time, int64_t spacing,
+                                const TransportPosition* transport, bool exact) noexcept
+{
+    if (wakePending)
+        tryWake();
+
+    playout.store(time, std::memory_order_release);
+    takeReady();
+
+    Store& store = stores[live];
+    const bool valid = store.epoch.load(std::memory_order_relaxed) == epoch;
+
+    if (exact)
+    {
+        if (! valid)
+        {
+            store.cache.reset(sr, state.params, state.layout, state.pcSet, state.weights, transport);
+            store.epoch.store(epoch, std::memory_order_relaxed);
+            store.serial.store(sentSerial, std::memory_order_relaxed);
+        }
+
+        inStep = store.cache.restore(ensemble, time, spacing);
+        return true;
+    }
+
+    // One request per state, and another only once its store has come back
+    // and still falls short
+    const bool covered = store.cache.covers(time, spacing);
+    if (! (valid && covered)
+        && (requestedEpoch != epoch || (valid && store.serial.load(std::memory_order_relaxed) == sentSerial)))
+        request(state, spacing, transport);
+
+    if (! covered)
+        return false;
+
+    if (valid)
+    {
+        inStep = store.cache.restore(ensemble, time, spacing);
+        return inStep;
+    }
+
+    const int64_t position = store.cache.load(ensemble, time);
+    if (position < 0)
+        return false;
+
+    // The old timeline's players take the current state, before anything
+    // reads the objects the old one pointed to (they may be gone)
+    DiscardSink discard;
+    ensemble.setPitchClassSet(state.pcSet);
+    ensemble.setWeightProfile(state.weights);
+    ensemble.setParameters(state.params, position, discard);
+
+    auto* profiler = ensemble.getProfiler();
+    ensemble.setProfiler(nullptr);
+    ensemble.fastForward(position, time);
+    ensemble.setProfiler(profiler);
+
+    inStep = false;
+    return true;
+}
+
+void CheckpointBuilder::capture(const Ensemble& ensemble, int64_t time, int64_t spacing) noexcept
+{
+    if (wakePending)
+        tryWake();
+
+    if (inStep)
+        stores[live].cache.capture(ensemble, time, spacing);
+}
+
+bool CheckpointBuilder::isCurrent() const noexcept
+{
+    if (taken.load(std::memory_order_acquire) != sentSerial)
+        return false;
+
+    const uint32_t state = building.load(std::memory_order_acquire);
+    return state == 0 || state == epoch;
+}
+
+void CheckpointBuilder::takeReady() noexcept
+{
+    int published = ready.load(std::memory_order_acquire);
+    if ((published & Fresh) == 0)
+        return;
+
+    // Stores arrive in request order, but an exact restore may have made a
+    // newer live one in the meantime
+    const int index = published & IndexMask;
+    const uint32_t liveEpoch = stores[live].epoch.load(std::memory_order_relaxed);
+    if (liveEpoch != 0 && (int32_t)(stores[index].epoch.load(std::memory_order_relaxed) - liveEpoch) < 0)
+        return;
+
+    // Fails if the worker published another one just now; the next call takes that
+    if (ready.compare_exchange_strong(published, live, std::memory_order_acq_rel))
+    {
+        live = index;
+        inStep = false;
+    }
+}
+
+void CheckpointBuilder::request(const GeneratorState& state, int64_t spacing,
+                                const TransportPosition* transport) noexcept
+{
+    Request request;
+    request.serial = sentSerial + 1;
+    request.epoch = epoch;
+    request.spacing = spacing;
+    request.state = state;
+    request.hasTransport = transport != nullptr;
+    if (transport != nullptr)
+        request.transport = *transport;
+
+    // Full: the next call sends it
+    if (! requests.push(request))
+        return;
+
+    sentSerial = request.serial;
+    requestedEpoch = epoch;
+
+    signalled.store(true, std::memory_order_release);
+    wakePending = true;
+    tryWake();
+}
+
+void CheckpointBuilder::tryWake() noexcept
+{
+    // As in LookaheadGenerator: getting the mutex means the worker is either
+    // asleep (and the notify wakes it) or will see the flag before it sleeps
+    if (! wakeLock.try_lock())
+        return;
+
+    wakeLock.unlock();
+    wakePending = false;
+    wake.notify_one();
+}
+
+// === Worker thread ===
+
+void CheckpointBuilder::run()
+{
+    std::unique_lock<std::mutex> lock(wakeLock);
+
+    while (! quit)
+    {
+        lock.unlock();
+        const bool busy = work();
+        lock.lock();
+
+        if (busy || quit)
+            continue;
+
+        wake.wait(lock, [this] { return quit || signalled.exchange(false, std::memory_order_acquire); });
+    }
+}
+
+bool CheckpointBuilder::work()
+{
+    // Only the newest request matters; the others are for states already replaced
+    Request request, next;
+    bool any = false;
+    while (requests.pop(next))
+    {
+        request = next;
+        any = true;
+    }
+
+    if (! any)
+        return false;
+
+    building.store(request.epoch, std::memory_order_release);
+    taken.store(request.serial, std::memory_order_release);
+    build(request);
+    building.store(0, std::memory_order_release);
+    return true;
+}
+
+void CheckpointBuilder::build(const Request& request)
+{
+    Store& store = stores[buildIndex];
+    const GeneratorState& state = request.state;
+    const TransportPosition* transport = request.hasTransport ? &request.transport : nullptr;
+
+    store.cache.reset(sr, state.params, state.layout, state.pcSet, state.weights, transport);
+
+    DiscardSink discard;
+    scratch->reset();
+    scratch->prepare(sr);
+    scratch->setPitchClassSet(state.pcSet);
+    scratch->setWeightProfile(state.weights);
+    scratch->setLayout(state.layout, 0, discard);
+    scratch->setParameters(state.params, 0, discard);
+
+    // Until the store is ahead of the playout position, which the audio
+    // thread moves while it waits
+    int64_t reached = -1;
+    for (;;)
+    {
+        const int64_t goal = playout.load(std::memory_order_acquire) + leadSamples;
+        if (goal <= reached)
+            break;
+
+        store.cache.restore(*scratch, goal, request.spacing);
+        reached = goal;
+    }
+
+    store.epoch.store(request.epoch, std::memory_order_relaxed);
+    store.serial.store(request.serial, std::memory_order_relaxed);
+    buildIndex = ready.exchange(buildIndex | Fresh, std::memory_order_acq_rel) & IndexMask;
+}
+
+} // namespace stringfield
@@ -0,0 +1,148 @@
+#pragma once
+#include "CheckpointCache.h"
+#include "Ensemble.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace stringfield
+{
+
+// Checkpoints for the in-callback generator, rebuilt on a background thread.
+//
+// A CheckpointCache only makes a locate cheap where it has checkpoints.
+// After anything the generator depends on changes, or for a jump past the
+// newest checkpoint, the whole path up to the target has to be generated
+// first (some 40 ms for 90 minutes of one player), which is too long for
+// the audio callback. A worker thread does that here instead.
+//
+// The audio thread locates from its live store and extends it while
+// playing. A locate the live store can't serve exactly sends the current
+// state to the worker, which builds a fresh store from the origin to LeadMs
+// past the playout position and hands it back. Until it arrives:
+// - a live store from an older state (with as many players) still serves
+//   the locate: the players come from the old timeline and take the
+//   current state at the target, as if it had changed there;
+// - otherwise restore() reports that the generator has to wait, and the
+//   caller plays nothing and asks again each block.
+// So on the audio thread a locate is one copy plus at most one spacing of
+// generation (as thinned), wherever it lands. The worker finishes every
+// store it starts, so even with automation changing the state every block
+// the live store is at most one build behind.
+//
+// Stores change hands three ways (live, ready, building) with one atomic
+// exchange, so neither thread ever waits for the other. The pointers in a
+// GeneratorState stay in use by the worker until isCurrent() reports that it
+// has none older than the latest state.
+//
+// prepare() and release() run on the message thread; everything else is for
+// the audio thread and never allocates or locks. The worker sleeps without
+// polling between builds and is woken once per request (a try_lock of its
+// mutex, retried on the next call if the worker holds it just then).
+class CheckpointBuilder
+{
+public:
+    static constexpr int LeadMs = 1000;       // Built past the playout position
+
+    CheckpointBuilder() = default;
+    ~CheckpointBuilder() { release(); }
+
+    // === Control (message thread) ===
+    // Allocates the stores and (re)starts the worker. The audio thread must be idle.
+    void prepare(double sampleRate);
+
+    // Stops the worker until the next prepare()
+    void release();
+
+    // === Audio thread ===
+
+    // Something the generator depends on changed (the ensemble has the new state)
+    void invalidate() noexcept;
+
+    // Puts `ensemble`, already set to `state`, in the state it has at
+    // `time`. False if no store can serve it yet: the ensemble is untouched,
+    // and the caller should stay silent and try again with the host position
+    // next block. `exact` (offline renders) generates whatever is missing
+    // right here instead, and always succeeds.
+    bool restore(Ensemble& ensemble, const GeneratorState& state, int64_t time, int64_t spacing,
+                 const TransportPosition* transport, bool exact) noexcept;
+
+    // After each block played since the last restore(), with the ensemble's
+    // state at `time`. Only extends a store the ensemble is exactly in step with.
+    void capture(const Ensemble& ensemble, int64_t time, int64_t spacing) noexcept;
+
+    // The worker holds no pointers from a state older than the latest one
+    // (so objects only older states used are free to go)
+    bool isCurrent() const noexcept;
+
+private:
+    static constexpr int NumStores = 3;
+    static constexpr int IndexMask = 3;
+    static constexpr int Fresh = 4;           // In `ready`: published, not taken yet
+
+    struct Store
+    {
+        CheckpointCache cache;
+        std::atomic<uint32_t> epoch { 0 };    // State it was built for (0 = none)
+        std::atomic<uint32_t> serial { 0 };   // Request it was built for
+    };
+
+    struct Request
+    {
+        uint32_t serial = 0;
+        uint32_t epoch = 0;
+        int64_t spacing = 0;
+        bool hasTransport = false;
+        GeneratorState state;
+        TransportPosition transport;
+    };
+
+    // === Audio thread ===
+    void takeReady() noexcept;
+    void request(const GeneratorState& state, int64_t spacing, const TransportPosition* transport) noexcept;
+    void tryWake() noexcept;
+
+    // === Worker thread ===
+    void run();
+    bool work();
+    void build(const Request& request);
+
+    void stopWorker();
+
+    double sr = 44100.0;
+    int64_t leadSamples = 44100;
+
+    Store stores[NumStores];
+
+    // Shared
+    SpscQueue<Request, 16> requests;                  // Audio → worker
+    std::atomic<int> ready { 1 };                     // Index of the published store, plus Fresh
+    std::atomic<int64_t> playout { 0 };               // Latest locate target
+    std::atomic<uint32_t> taken { 0 };                // Serial of the newest request the worker took
+    std::atomic<uint32_t> building { 0 };             // Epoch of the store being built (0 = idle)
+    std::atomic<bool> signalled { false };            // Audio → worker: requests waiting
+
+    // === Audio thread state ===
+    int live = 0;
+    uint32_t epoch = 1;                   // Of the current state
+    uint32_t sentSerial = 0;
+    uint32_t requestedEpoch = 0;          // Of the newest request sent
+    bool inStep = false;                  // The ensemble is on the live store's timeline
+    bool wakePending = false;             // signalled is set, the worker not woken yet
+
+    // === Worker thread state ===
+    std::thread thread;
+    std::mutex wakeLock;
+    std::condition_variable wake;
+    bool quit = false;                    // Guarded by wakeLock
+    int buildIndex = 2;
+    std::unique_ptr<Ensemble> scratch;
+
+    CheckpointBuilder(const CheckpointBuilder&) = delete;
+    CheckpointBuilder& operator=(const CheckpointBuilder&) = delete;
+};
+
+} // namespace stringfield
@@ -0,0 +1,145 @@
+#include "CheckpointCache.h"
+#include <algorithm>
+
+namespace stringfield
+{
+
+void CheckpointCache::prepare(int capacity)
+{
+    // Room for the origin and one more checkpoint of a full ensemble
+    players.assign((size_t)std::max(2 * Ensemble::MaxPlayers, capacity), StringFieldEngine());
+    times.assign(players.size(), 0);
+    if (origin == nullptr)
+        origin = std::make_unique<Ensemble>();
+
+    playersPerCheckpoint = 1;
+    maxCount = (int)players.size();
+    count = 0;
+    spacingScale = 1;
+}
+
+void CheckpointCache::reset(double sampleRate, const EngineParams& params,
+                            const CompiledEnsemble* layout,
+                            const CompiledPitchClassSet* pcSet,
+                            const CompiledWeightProfile* weights,
+                            const TransportPosition* transport) noexcept
+{
+    if (players.empty())
+        return;
+
+    struct DiscardSink : EventSink
+    {
+        void handleEvent(const MidiEvent&) override {}
+    } discard;
+
+    origin->reset();
+    origin->prepare(sampleRate);
+    origin->setParameters(params, 0, discard);
+    origin->setLayout(layout, 0, discard);
+    origin->setPitchClassSet(pcSet);
+    origin->setWeightProfile(weights);
+    if (transport != nullptr)
+        origin->setTransport(*transport);
+
+    playersPerCheckpoint = origin->getNumPlayers();
+    maxCount = (int)players.size() / playersPerCheckpoint;
+
+    store(0, 0, *origin);
+    count = 1;
+    spacingScale = 1;
+}
+
+void CheckpointCache::capture(const Ensemble& ensemble, int64_t time, int64_t spacing) noexcept
+{
+    if (count == 0 || ensemble.getNumPlayers() != playersPerCheckpoint
+        || time < times[(size_t)count - 1] + spacing * spacingScale)
+        return;
+
+    if (count == maxCount)
+        thin();
+
+    store(count++, time, ensemble);
+}
+
+bool CheckpointCache::restore(Ensemble& ensemble, int64_t time, int64_t spacing) noexcept
+{
+    int64_t position = load(ensemble, time);
+    if (position < 0)
+        return false;
+
+    // The profiler belongs to the live ensemble, and catching up isn't timed as playback
+    auto* profiler = ensemble.getProfiler();
+    ensemble.setProfiler(nullptr);
+
+    // In steps, so a first jump far ahead leaves checkpoints for the next one
+    const int64_t step = std::max<int64_t>(1, spacing);
+    while (position < time)
+    {
+        const int64_t next = std::min(time, position + step * spacingScale);
+        ensemble.fastForward(position, next);
+        position = next;
+        capture(ensemble, position, step);
+    }
+
+    ensemble.setProfiler(profiler);
+    return true;
+}
+
+int64_t CheckpointCache::load(Ensemble& ensemble, int64_t time) const noexcept
+{
+    if (count == 0 || ensemble.getNumPlayers() != playersPerCheckpoint)
+        return -1;
+
+    const int index = latestAt(time);
+    auto* profiler = ensemble.getProfiler();
+    for (int p = 0; p < playersPerCheckpoint; ++p)
+        ensemble.getPlayer(p) = players[(size_t)(index * playersPerCheckpoint + p)];
+    ensemble.setProfiler(profiler);
+
+    return times[(size_t)index];
+}
+
+bool CheckpointCache::covers(int64_t time, int64_t spacing) const noexcept
+{
+    return count > 0 && time - times[(size_t)latestAt(time)] <= std::max<int64_t>(1, spacing) * spacingScale;
+}
+
+int CheckpointCache::latestAt(int64_t time) const noexcept
+{
+    // Times ascend; slot 0 is at 0
+    int lo = 0, hi = count - 1;
+    while (lo < hi)
+    {
+        const int mid = (lo + hi + 1) / 2;
+        if (times[(size_t)mid] <= time)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+
+    return lo;
+}
+
+void CheckpointCache::store(int index, int64_t time, const Ensemble& ensemble) noexcept
+{
+    times[(size_t)index] = time;
+    for (int p = 0; p < playersPerCheckpoint; ++p)
+        players[(size_t)(index * playersPerCheckpoint + p)] = ensemble.getPlayer(p);
+}
+
+void CheckpointCache::thin() noexcept
+{
+    // Keep the origin and every second checkpoint after it
+    int kept = 1;
+    for (int i = 2; i < count; i += 2, ++kept)
+    {
+        times[(size_t)kept] = times[(size_t)i];
+        std::copy_n(players.begin() + i * playersPerCheckpoint, playersPerCheckpoint,
+                    players.begin() + kept * playersPerCheckpoint);
+    }
+
+    count = kept;
+    spacingScale *= 2;
+}
+
+} // namespace stringfield
@@ -0,0 +1,72 @@
+#pragma once
+#include "Ensemble.h"
+#include <memory>
+#include <vector>
+
+namespace stringfield
+{
+
+// Generator snapshots along the timeline for instant locate.
+//
+// Slot 0 is the origin: a fresh ensemble with the current parameters, layout
+// and PC set at time 0. While playing, a copy of its players' engines is
+// stored every `spacing` samples past the newest checkpoint. Locating
+// restores the latest checkpoint at or before the target and fast-forwards
+// the remainder, so a jump costs one copy plus at most one spacing of
+// generation, anywhere in the arrangement.
+//
+// Checkpoints are only valid for the parameters they were captured with;
+// reset() whenever those change (CheckpointBuilder does that off the audio
+// thread for the processor). The store holds a fixed number of engine
+// snapshots, so a checkpoint of N players takes N of them; when it fills up,
+// every other checkpoint is dropped and the spacing doubles, so any session
+// length fits.
+class CheckpointCache
+{
+public:
+    static constexpr int DefaultCapacity = 1024;    // Engine snapshots
+
+    // Allocates the store (not realtime-safe)
+    void prepare(int capacity = DefaultCapacity);
+
+    // === Audio thread ===
+
+    // Drops every checkpoint and rebuilds the origin (following `transport`
+    // if the host provides one, so synced pulses replay on the host grid)
+    void reset(double sampleRate, const EngineParams& params, const CompiledEnsemble* layout,
+               const CompiledPitchClassSet* pcSet, const CompiledWeightProfile* weights = nullptr,
+               const TransportPosition* transport = nullptr) noexcept;
+
+    // Stores `ensemble` (its state at `time`) if due
+    void capture(const Ensemble& ensemble, int64_t time, int64_t spacing) noexcept;
+
+    // Puts `ensemble` in the state it has at `time`. Fast-forwarding past the
+    // newest checkpoint captures new ones on the way (every `spacing`).
+    // False (ensemble untouched) if the store is empty or holds another
+    // number of players.
+    bool restore(Ensemble& ensemble, int64_t time, int64_t spacing) noexcept;
+
+    // Copies the latest checkpoint at or before `time` into `ensemble` and
+    // returns its time, without fast-forwarding; -1 where restore() fails
+    int64_t load(Ensemble& ensemble, int64_t time) const noexcept;
+
+    // restore() would generate at most one spacing (as thinned) to reach `time`
+    bool covers(int64_t time, int64_t spacing) const noexcept;
+
+    int size() const noexcept { return count; }
+
+private:
+    int latestAt(int64_t time) const noexcept;
+    void store(int index, int64_t time, const Ensemble& ensemble) noexcept;
+    void thin() noexcept;
+
+    std::vector<int64_t> times;
+    std::vector<StringFieldEngine> players;     // Checkpoint i: [i * playersPerCheckpoint, ...)
+    std::unique_ptr<Ensemble> origin;           // Scratch for building slot 0
+    int playersPerCheckpoint = 1;
+    int maxCount = 0;
+    int count = 0;
+    int spacingScale = 1;         // Doubles each time the store is thinned
+};
+
+} // namespace stringfield
@@ -0,0 +1,73 @@
+#include "ConductorBus.h"
+
+namespace stringfield
+{
+
+ConductorBus& ConductorBus::shared()
+{
+    static ConductorBus bus;
+    return bus;
+}
+
+bool ConductorBus::claimLeadership(const void* owner) noexcept
+{
+    const void* expected = nullptr;
+    return leader.compare_exchange_strong(expected, owner, std::memory_order_acq_rel)
+        || expected == owner;
+}
+
+void ConductorBus::releaseLeadership(const void* owner) noexcept
+{
+    const void* expected = owner;
+    leader.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+}
+
+bool ConductorBus::publish(const float* newValues, int numValues) noexcept
+{
+    // Odd sequence = write in progress; taking it by CAS keeps writers exclusive
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    if ((seq & 1u) != 0 || ! sequence.compare_exchange_strong(seq, seq + 1, std::memory_order_relaxed))
+        return false;
+
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const int n = numValues < MaxValues ? numValues : MaxValues;
+    for (int i = 0; i < n; ++i)
+        values[i].store(newValues[i], std::memory_order_relaxed);
+
+    // Skip 0 on wrap-around so followers never mistake a frame for "nothing yet"
+    sequence.store(seq + 2 == 0 ? 2 : seq + 2, std::memory_order_release);
+    return true;
+}
+
+bool ConductorBus::read(Frame& frame) const noexcept
+{
+    for (int attempt = 0; attempt < maxReadAttempts; ++attempt)
+    {
+        const uint32_t before = sequence.load(std::memory_order_acquire);
+
+        if (before == frame.sequence)
+            return false;                 // Nothing new (or nothing published)
+
+        if ((before & 1u) != 0)
+            continue;                     // Leader mid-write
+
+        float copy[MaxValues];
+        for (int i = 0; i < MaxValues; ++i)
+            copy[i] = values[i].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (sequence.load(std::memory_order_relaxed) == before)
+        {
+            for (int i = 0; i < MaxValues; ++i)
+                frame.values[i] = copy[i];
+            frame.sequence = before;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace stringfield
@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace stringfield
+{
+
+// Process-wide parameter frame shared by every plugin instance loaded in the
+// same host process, so an ensemble can follow one leader without MIDI routing.
+//
+// One leader publishes a frame of parameter values; any number of followers
+// copy it at block start. Access is a seqlock: publishing bumps the sequence
+// to odd, writes the values and bumps it back to even, and readers retry if
+// the sequence moved underneath them. Neither side locks, allocates or waits
+// on the other. A reader gives up after a few collisions and keeps its
+// previous frame; a second writer racing the first simply skips its publish.
+class ConductorBus
+{
+public:
+    static constexpr int MaxValues = 32;
+
+    struct Frame
+    {
+        uint32_t sequence = 0;            // 0 = nothing received yet
+        float values[MaxValues] {};
+    };
+
+    // The instance every plugin in this process talks to
+    static ConductorBus& shared();
+
+    // === Leadership (any thread) ===
+    // At most one leader at a time; claiming is idempotent for the owner
+    bool claimLeadership(const void* owner) noexcept;
+    void releaseLeadership(const void* owner) noexcept;
+    bool isLeader(const void* owner) const noexcept { return leader.load(std::memory_order_acquire) == owner; }
+    bool hasLeader() const noexcept { return leader.load(std::memory_order_acquire) != nullptr; }
+
+    // === Leader (audio thread) ===
+    // Returns false if another publish was in flight
+    bool publish(const float* values, int numValues) noexcept;
+
+    // === Followers (audio thread) ===
+    // Copies the newest frame if it differs from frame.sequence
+    bool read(Frame& frame) const noexcept;
+
+private:
+    static constexpr int maxReadAttempts = 4;
+
+    std::atomic<const void*> leader { nullptr };
+    alignas(64) std::atomic<uint32_t> sequence { 0 };
+    std::atomic<float> values[MaxValues] {};
+};
+
+} // namespace stringfield
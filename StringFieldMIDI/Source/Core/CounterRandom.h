@@ -0,0 +1,88 @@
+#pragma once
+#include "Philox.h"
+#include <cstdint>
+
+namespace stringfield
+{
+
+// Independent random streams of the generator. Each is keyed separately, so
+// drawing more or fewer numbers in one never shifts another.
+enum class RandomStream : uint32_t
+{
+    Pitch = 1,
+    Rhythm,
+    Velocity,
+    Articulation,
+    Pedal
+};
+
+// Counter-based random numbers: the draws for (seed, stream, event, lane) are
+// a pure function of those four values, computed with Philox4x32-10.
+//
+// seek() jumps straight to an event; the following calls consume that
+// event's numbers in order. Nothing depends on what was drawn before, so any
+// point of the timeline can be reproduced without replaying history. Plain
+// data and trivially copyable, so generator state can be snapshotted.
+class CounterRandom
+{
+public:
+    CounterRandom() = default;
+    CounterRandom(uint32_t seed, RandomStream stream) noexcept { setKey(seed, stream); }
+
+    void setKey(uint32_t seed, RandomStream stream) noexcept
+    {
+        key[0] = seed;
+        key[1] = (uint32_t)stream;
+        seek(0);
+    }
+
+    // Positions at the first draw of an event. Lanes separate unrelated uses
+    // of the same event index within one stream.
+    void seek(uint64_t eventIndex, uint32_t lane = 0) noexcept
+    {
+        counter[0] = 0;
+        counter[1] = lane;
+        counter[2] = (uint32_t)eventIndex;
+        counter[3] = (uint32_t)(eventIndex >> 32);
+        used = 4;
+    }
+
+    uint32_t nextUInt32() noexcept
+    {
+        if (used == 4)
+        {
+            Philox4x32::generate(counter, key, block);
+            ++counter[0];
+            used = 0;
+        }
+        return block[used++];
+    }
+
+    // Uniform in [0, maxValue)
+    int nextInt(int maxValue) noexcept
+    {
+        return maxValue <= 0 ? 0 : (int)(((uint64_t)nextUInt32() * (uint32_t)maxValue) >> 32);
+    }
+
+    // Uniform in [start, end)
+    int nextInt(int start, int end) noexcept { return start + nextInt(end - start); }
+
+    // Uniform in [0, 1)
+    float nextFloat() noexcept { return (float)(nextUInt32() >> 8) * (1.0f / 16777216.0f); }
+
+    double nextDouble() noexcept
+    {
+        const uint64_t bits = ((uint64_t)nextUInt32() << 21) ^ (nextUInt32() >> 11);
+        return (double)bits * (1.0 / 9007199254740992.0);
+    }
+
+    bool nextBool() noexcept { return (nextUInt32() & 0x80000000u) != 0; }
+
+private:
+    uint32_t key[2] {};
+    uint32_t counter[4] {};
+    uint32_t block[4] {};
+    int used = 4;                 // Words of block consumed
+};
+
+} // namespace stringfield
@@ -0,0 +1,39 @@
+#pragma once
+
+namespace stringfield
+{
+
+// Plain parameter set for the generator (mirrors the plugin's APVTS layout).
+// Values are in real units, not normalised 0-1.
+struct EngineParams
+{
+    float rate = 2.0f;            // Events per second (0.05 - 20)
+    float density = 0.25f;        // Probability that a scheduled event sounds
+    float energy = 0.2f;          // Duration, jitter, articulation spread
+    int center = 60;              // Register center (MIDI note)
+    int spread = 12;              // Register spread (semitones)
+    int vel = 80;                 // Base velocity
+    int seed = 1;                 // RNG seed
+    int routes = 1;               // Number of articulation routes (MIDI channels)
+    int memory = 0;               // Pitch/rhythm memory size (or horizon, by memoryMode)
+    int memoryMode = 0;           // MemoryMode: 0=Recent, 1=Decay, 2=Markov
+    float articulation = 0.5f;    // Center of route distribution
+
+    // Pulse mode
+    bool pulse = false;
+    float tempo = 120.0f;         // BPM (free-running pulse, or the grid when there is no host tempo)
+    float regularity = 0.5f;
+    int sync = 0;                 // Host grid: 0=Free, 1=1/2, 2=1/4, 3=1/8, 4=1/8T, 5=1/16, 6=1/16T
+
+    int pcMode = 0;               // 0=Off, 1=Transpose, 2=Transpose+Invert
+    bool pedal = true;            // Automatic sustain pedal
+
+    // Polyphony
+    int voices = 1;               // 1 = monophonic (v0.1 behavior)
+    int steal = 0;                // StealMode: 0=Oldest, 1=Quietest, 2=Same route
+
+    // Ensemble size (read by Ensemble; a single engine ignores it)
+    int players = 1;
+};
+
+} // namespace stringfield
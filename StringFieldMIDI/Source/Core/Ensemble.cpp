@@ -0,0 +1,344 @@
+#include "Ensemble.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace stringfield
+{
+
+namespace
+{
+    template <typename T>
+    T limit(T lowerLimit, T upperLimit, T value)
+    {
+        return value < lowerLimit ? lowerLimit : (upperLimit < value ? upperLimit : value);
+    }
+
+    const CompiledEnsemble defaultLayout;
+
+    // Range of the Seed parameter; player seeds wrap around inside it
+    constexpr int64_t minSeed = 1;
+    constexpr int64_t maxSeed = 99999;
+
+    int playerSeed(int seed, int offset)
+    {
+        const int64_t span = maxSeed - minSeed + 1;
+        const int64_t wrapped = ((int64_t)seed - minSeed + offset) % span;
+        return (int)(minSeed + (wrapped < 0 ? wrapped + span : wrapped));
+    }
+
+    // Applies one "key=value" setting to player `p`
+    void parseSetting(CompiledEnsemble& layout, int p, const std::string& token)
+    {
+        const auto equals = token.find('=');
+        if (equals == std::string::npos || equals + 1 >= token.size())
+            return;
+
+        const std::string key = token.substr(0, equals);
+        const char* value = token.c_str() + equals + 1;
+        char* end = nullptr;
+
+        if (key == "ch")
+        {
+            const long first = std::strtol(value, &end, 10);
+            long last = first;
+            if (end != value && *end == '-')
+                last = std::strtol(end + 1, &end, 10);
+
+            if (first >= 1 && first <= last && last <= 16)
+            {
+                layout.firstChannel[p] = (uint8_t)first;
+                layout.lastChannel[p] = (uint8_t)last;
+            }
+            return;
+        }
+
+        if (key == "rate" || key == "density" || key == "energy")
+        {
+            const float number = std::strtof(value, &end);
+            if (end == value || !std::isfinite(number))
+                return;
+
+            if (key == "rate")
+                layout.rateScale[p] = std::max(0.0f, number);
+            else if (key == "density")
+                layout.densityOffset[p] = limit(-1.0f, 1.0f, number);
+            else
+                layout.energyOffset[p] = limit(-1.0f, 1.0f, number);
+            return;
+        }
+
+        const long number = std::strtol(value, &end, 10);
+        if (end == value)
+            return;
+
+        const int clamped = (int)limit(-100000L, 100000L, number);
+        if (key == "seed")
+            layout.seedOffset[p] = clamped;
+        else if (key == "center")
+            layout.centerOffset[p] = clamped;
+        else if (key == "spread")
+            layout.spreadOffset[p] = clamped;
+        else if (key == "vel")
+            layout.velOffset[p] = clamped;
+    }
+}
+
+CompiledEnsemble::CompiledEnsemble()
+{
+    for (int p = 0; p < MaxPlayers; ++p)
+    {
+        seedOffset[p] = p;
+        centerOffset[p] = 0;
+        spreadOffset[p] = 0;
+        velOffset[p] = 0;
+        rateScale[p] = 1.0f;
+        densityOffset[p] = 0.0f;
+        energyOffset[p] = 0.0f;
+        firstChannel[p] = 0;
+        lastChannel[p] = 0;
+    }
+}
+
+std::unique_ptr<CompiledEnsemble> CompiledEnsemble::compile(const std::string& text)
+{
+    auto layout = std::make_unique<CompiledEnsemble>();
+    layout->source = text;
+
+    int player = 0;
+    std::string token;
+
+    for (size_t i = 0; i <= text.size() && player < MaxPlayers; ++i)
+    {
+        const char c = i < text.size() ? text[i] : ';';
+
+        if (c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\n' || c == '\r')
+        {
+            if (!token.empty())
+                parseSetting(*layout, player, token);
+            token.clear();
+
+            if (c == ';' || c == '\n')
+                ++player;
+        }
+        else
+        {
+            token += c;
+        }
+    }
+
+    return layout;
+}
+
+// === Ensemble ===
+
+Ensemble::Ensemble()
+{
+    firstChannel[0] = 1;
+    numChannels[0] = 16;
+}
+
+void Ensemble::reset()
+{
+    for (auto& player : players)
+        player = StringFieldEngine();
+
+    params = EngineParams();
+    layout = nullptr;
+    profiler = nullptr;
+    numPlayers = 1;
+    std::fill(std::begin(firstChannel), std::end(firstChannel), (uint8_t)0);
+    std::fill(std::begin(numChannels), std::end(numChannels), (uint8_t)0);
+    firstChannel[0] = 1;
+    numChannels[0] = 16;
+}
+
+void Ensemble::prepare(double sampleRate)
+{
+    for (auto& player : players)
+        player.prepare(sampleRate);
+}
+
+void Ensemble::setParameters(const EngineParams& newParams, int64_t now, EventSink& sink)
+{
+    params = newParams;
+    updatePlayers(now, sink);
+}
+
+void Ensemble::setLayout(const CompiledEnsemble* newLayout, int64_t now, EventSink& sink)
+{
+    layout = newLayout;
+    updatePlayers(now, sink);
+}
+
+void Ensemble::updatePlayers(int64_t now, EventSink& sink)
+{
+    const CompiledEnsemble& l = layout != nullptr ? *layout : defaultLayout;
+    const int count = limit(1, MaxPlayers, params.players);
+    const int share = std::max(1, 16 / count);
+
+    uint8_t newFirst[MaxPlayers] {};
+    uint8_t newNum[MaxPlayers] {};
+
+    for (int p = 0; p < count; ++p)
+    {
+        const bool automatic = l.firstChannel[p] == 0;
+        newFirst[p] = automatic ? (uint8_t)(1 + p * share) : l.firstChannel[p];
+        newNum[p] = automatic ? (uint8_t)share : (uint8_t)(l.lastChannel[p] - l.firstChannel[p] + 1);
+    }
+
+    // Players leaving or moving release what they hold on their old channels
+    for (int p = 0; p < numPlayers; ++p)
+    {
+        if (p >= count || newFirst[p] != firstChannel[p] || newNum[p] != numChannels[p])
+        {
+            auto playerSink = sinkFor(p, sink);
+            players[p].stop(playerSink);
+        }
+    }
+
+    numPlayers = count;
+    std::copy(newFirst, newFirst + MaxPlayers, firstChannel);
+    std::copy(newNum, newNum + MaxPlayers, numChannels);
+
+    // One pass over the layout arrays derives every player's parameters
+    for (int p = 0; p < count; ++p)
+    {
+        EngineParams derived = params;
+        derived.seed = playerSeed(params.seed, l.seedOffset[p]);
+        derived.center = limit(0, 127, params.center + l.centerOffset[p]);
+        derived.spread = limit(0, 63, params.spread + l.spreadOffset[p]);
+        derived.vel = limit(1, 127, params.vel + l.velOffset[p]);
+        derived.rate = limit(0.05f, 20.0f, params.rate * l.rateScale[p]);
+        derived.density = limit(0.0f, 1.0f, params.density + l.densityOffset[p]);
+        derived.energy = limit(0.0f, 1.0f, params.energy + l.energyOffset[p]);
+        derived.routes = limit(1, (int)numChannels[p], params.routes);
+
+        auto playerSink = sinkFor(p, sink);
+        players[p].setParameters(derived, now, playerSink);
+    }
+}
+
+void Ensemble::setPitchClassSet(const CompiledPitchClassSet* set)
+{
+    // Inactive players too, so they are current when they join
+    for (auto& player : players)
+        player.setPitchClassSet(set);
+}
+
+void Ensemble::setWeightProfile(const CompiledWeightProfile* profile)
+{
+    for (auto& player : players)
+        player.setWeightProfile(profile);
+}
+
+void Ensemble::setProfiler(HotPathProfiler* newProfiler)
+{
+    profiler = newProfiler;
+    for (auto& player : players)
+        player.setProfiler(newProfiler);
+}
+
+void Ensemble::setTransport(const TransportPosition& position)
+{
+    for (int p = 0; p < numPlayers; ++p)
+        players[p].setTransport(position);
+}
+
+void Ensemble::render(int64_t startSample, int numSamples, EventSink& sink)
+{
+    if (numPlayers == 1)
+    {
+        auto playerSink = sinkFor(0, sink);
+        players[0].render(startSample, numSamples, playerSink);
+        return;
+    }
+
+    const int64_t end = startSample + numSamples;
+    int64_t position[MaxPlayers];
+
+    // An empty render schedules each player's next events from the start
+    for (int p = 0; p < numPlayers; ++p)
+    {
+        auto playerSink = sinkFor(p, sink);
+        players[p].render(startSample, 0, playerSink);
+        position[p] = startSample;
+    }
+
+    // Advance the player with the earliest pending event through that event's
+    // time, until no player has one left in range (ties go to the lower index)
+    for (;;)
+    {
+        int next = -1;
+        int64_t nextTime = end;
+
+        for (int p = 0; p < numPlayers; ++p)
+        {
+            const int64_t time = players[p].getNextEventTime();
+            if (time < nextTime)
+            {
+                next = p;
+                nextTime = time;
+            }
+        }
+
+        if (next < 0)
+            break;
+
+        const int64_t from = position[next];
+        const int64_t to = std::max(from, nextTime) + 1;
+
+        auto playerSink = sinkFor(next, sink, (int)(from - startSample));
+        players[next].render(from, (int)(to - from), playerSink);
+        position[next] = to;
+    }
+}
+
+void Ensemble::stop(EventSink& sink)
+{
+    for (int p = 0; p < numPlayers; ++p)
+    {
+        auto playerSink = sinkFor(p, sink);
+        players[p].stop(playerSink);
+    }
+}
+
+void Ensemble::fastForward(int64_t from, int64_t to)
+{
+    for (int p = 0; p < numPlayers; ++p)
+        players[p].fastForward(from, to);
+}
+
+void Ensemble::sendControllerState(EventSink& sink)
+{
+    for (int p = 0; p < numPlayers; ++p)
+    {
+        auto playerSink = sinkFor(p, sink);
+        players[p].sendControllerState(playerSink);
+    }
+}
+
+Ensemble::PlayerSink Ensemble::sinkFor(int player, EventSink& target, int offset) const
+{
+    PlayerSink playerSink;
+    playerSink.target = &target;
+    playerSink.offset = offset;
+    playerSink.firstChannel = firstChannel[player];
+    playerSink.numChannels = numChannels[player];
+    return playerSink;
+}
+
+void Ensemble::PlayerSink::handleEvent(const MidiEvent& event)
+{
+    // Channels past the range are the engine's all-channel messages
+    const int channel = event.getChannel();
+    if (channel > numChannels)
+        return;
+
+    MidiEvent mapped = event;
+    mapped.offset += offset;
+    mapped.data[0] = (uint8_t)((event.data[0] & 0xF0) | ((firstChannel + channel - 2) & 0x0F));
+    target->handleEvent(mapped);
+}
+
+} // namespace stringfield
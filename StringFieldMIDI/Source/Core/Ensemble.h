@@ -0,0 +1,138 @@
+#pragma once
+#include "StringFieldEngine.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace stringfield
+{
+
+// Per-player settings of an ensemble, parsed ahead of time like
+// CompiledWeightProfile. Immutable once compiled; share it read-only.
+//
+// Stored structure-of-arrays (one array per setting, indexed by player), so
+// deriving every player's parameters is one pass over contiguous values.
+struct CompiledEnsemble
+{
+    static constexpr int MaxPlayers = 16;
+
+    // One entry per player, separated by ';' or new lines, each a list of
+    // settings, e.g. "ch=1-4 center=+12; ch=5-8; ch=9-12 center=-12 seed=7":
+    //     seed=N              added to the Seed parameter (wraps in 1-99999)
+    //     center=N spread=N   added to the register (semitones)
+    //     vel=N               added to the velocity
+    //     density=X energy=X  added (0-1 scale; offsets beyond ±1 are clamped)
+    //     rate=X              multiplies the rate
+    //     ch=A or ch=A-B      channel range (1-16)
+    // Players without an entry (or settings not given) use the defaults:
+    // seed + player index, the shared register, an even share of the 16
+    // channels. Unknown or malformed settings (inf and nan included) are
+    // ignored.
+    static std::unique_ptr<CompiledEnsemble> compile(const std::string& text);
+
+    CompiledEnsemble();
+
+    std::string source;                // Text as typed
+
+    int seedOffset[MaxPlayers];
+    int centerOffset[MaxPlayers];
+    int spreadOffset[MaxPlayers];
+    int velOffset[MaxPlayers];
+    float rateScale[MaxPlayers];
+    float densityOffset[MaxPlayers];
+    float energyOffset[MaxPlayers];
+    uint8_t firstChannel[MaxPlayers];  // 0 = automatic range
+    uint8_t lastChannel[MaxPlayers];
+};
+
+// Up to 16 independent generators behind the StringFieldEngine interface,
+// on one timeline, driven by one parameter set (EngineParams::players of
+// them play).
+//
+// Each player derives its parameters from the shared set plus its own
+// offsets, and plays on its own channel range: its routes are the first
+// channels of the range (at most as many as the range holds), and pedal and
+// All Notes Off go to the whole range. Ranges may overlap; players sharing
+// a channel share its pedal.
+//
+// Players render in lockstep, one event time at a time, so the sink still
+// receives events in time order. With one player and the default layout the
+// output is exactly a StringFieldEngine's.
+//
+// Generator state is the players' engines; everything else is derived from
+// the parameters and layout, so CheckpointCache only stores the engines.
+// Like the engine: render(), setParameters() and stop() never allocate or lock.
+class Ensemble
+{
+public:
+    static constexpr int MaxPlayers = CompiledEnsemble::MaxPlayers;
+
+    Ensemble();
+
+    // Back to the freshly constructed state (one player, default layout)
+    void reset();
+
+    void prepare(double sampleRate);
+
+    // Applies the shared parameter set to every player (see StringFieldEngine).
+    // Players leaving, or changing channel range, are stopped first.
+    void setParameters(const EngineParams& newParams, int64_t now, EventSink& sink);
+    const EngineParams& getParameters() const { return params; }
+
+    // Adopts a per-player layout (nullptr = defaults). Realtime-safe; the
+    // layout must outlive its use by the ensemble.
+    void setLayout(const CompiledEnsemble* newLayout, int64_t now, EventSink& sink);
+
+    // Shared by all players (see StringFieldEngine)
+    void setPitchClassSet(const CompiledPitchClassSet* set);
+    void setWeightProfile(const CompiledWeightProfile* profile);
+    void setProfiler(HotPathProfiler* newProfiler);
+    HotPathProfiler* getProfiler() const { return profiler; }
+    void setTransport(const TransportPosition& position);
+
+    void render(int64_t startSample, int numSamples, EventSink& sink);
+    void stop(EventSink& sink);
+    void fastForward(int64_t from, int64_t to);
+    void sendControllerState(EventSink& sink);
+
+    int getNumPlayers() const { return numPlayers; }
+    StringFieldEngine& getPlayer(int index) { return players[index]; }
+    const StringFieldEngine& getPlayer(int index) const { return players[index]; }
+
+private:
+    // Moves a player's events onto its channel range and block offset
+    struct PlayerSink : EventSink
+    {
+        EventSink* target = nullptr;
+        int offset = 0;               // Of the player's render range in the block
+        int firstChannel = 1;
+        int numChannels = 16;
+
+        void handleEvent(const MidiEvent& event) override;
+    };
+
+    PlayerSink sinkFor(int player, EventSink& target, int offset = 0) const;
+    void updatePlayers(int64_t now, EventSink& sink);
+
+    EngineParams params;
+    const CompiledEnsemble* layout = nullptr;
+    HotPathProfiler* profiler = nullptr;
+    int numPlayers = 1;
+
+    // Channel ranges of the active players
+    uint8_t firstChannel[MaxPlayers] {};
+    uint8_t numChannels[MaxPlayers] {};
+
+    StringFieldEngine players[MaxPlayers];
+};
+
+// Everything an ensemble's output depends on apart from the transport
+struct GeneratorState
+{
+    EngineParams params;
+    const CompiledEnsemble* layout = nullptr;
+    const CompiledPitchClassSet* pcSet = nullptr;
+    const CompiledWeightProfile* weights = nullptr;
+};
+
+} // namespace stringfield
@@ -0,0 +1,136 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+namespace stringfield
+{
+
+// Things the engine schedules ahead of time. At equal timestamps they fire
+// in this order (pedal, then releases, then new notes).
+enum class ScheduledType : uint8_t
+{
+    PedalToggle = 0,
+    NoteOff = 1,
+    NoteOn = 2
+};
+
+struct ScheduledEvent
+{
+    int64_t time = 0;         // Absolute sample time
+    ScheduledType type = ScheduledType::NoteOn;
+    int note = 0;             // NoteOff only
+    int channel = 1;          // NoteOff only
+    int voice = -1;           // NoteOff only: VoicePool slot
+    uint32_t order = 0;       // Insertion order, breaks remaining ties
+};
+
+// Fixed-capacity min-heap of ScheduledEvents. Never allocates; ordering is
+// fully deterministic (time, type, insertion order).
+template <int Capacity>
+class EventQueue
+{
+public:
+    bool empty() const noexcept { return count == 0; }
+    int size() const noexcept { return count; }
+    bool full() const noexcept { return count == Capacity; }
+
+    void clear() noexcept { count = 0; }
+
+    const ScheduledEvent& top() const noexcept
+    {
+        assert(count > 0);
+        return heap[0];
+    }
+
+    // Returns false (and drops the event) when the queue is full
+    bool push(ScheduledEvent e) noexcept
+    {
+        if (count == Capacity)
+        {
+            assert(false && "EventQueue capacity exceeded");
+            return false;
+        }
+
+        e.order = nextOrder++;
+        int i = count++;
+        heap[i] = e;
+        siftUp(i);
+        return true;
+    }
+
+    ScheduledEvent pop() noexcept
+    {
+        assert(count > 0);
+        ScheduledEvent e = heap[0];
+        heap[0] = heap[--count];
+        siftDown(0);
+        return e;
+    }
+
+    // Removes every event matching pred. O(n), for rare cancellations.
+    template <typename Predicate>
+    int removeIf(Predicate pred) noexcept
+    {
+        int kept = 0;
+        for (int i = 0; i < count; ++i)
+            if (!pred(heap[i]))
+                heap[kept++] = heap[i];
+
+        int removed = count - kept;
+        count = kept;
+        for (int i = count / 2 - 1; i >= 0; --i)
+            siftDown(i);
+        return removed;
+    }
+
+    template <typename Predicate>
+    bool containsIf(Predicate pred) const noexcept
+    {
+        for (int i = 0; i < count; ++i)
+            if (pred(heap[i]))
+                return true;
+        return false;
+    }
+
+private:
+    ScheduledEvent heap[Capacity];
+    int count = 0;
+    uint32_t nextOrder = 0;
+
+    static bool before(const ScheduledEvent& a, const ScheduledEvent& b) noexcept
+    {
+        if (a.time != b.time) return a.time < b.time;
+        if (a.type != b.type) return a.type < b.type;
+        return a.order < b.order;
+    }
+
+    void siftUp(int i) noexcept
+    {
+        while (i > 0)
+        {
+            int parent = (i - 1) / 2;
+            if (!before(heap[i], heap[parent]))
+                break;
+            std::swap(heap[i], heap[parent]);
+            i = parent;
+        }
+    }
+
+    void siftDown(int i) noexcept
+    {
+        for (;;)
+        {
+            int smallest = i;
+            int l = 2 * i + 1, r = l + 1;
+            if (l < count && before(heap[l], heap[smallest])) smallest = l;
+            if (r < count && before(heap[r], heap[smallest])) smallest = r;
+            if (smallest == i)
+                break;
+            std::swap(heap[i], heap[smallest]);
+            i = smallest;
+        }
+    }
+};
+
+} // namespace stringfield
@@ -0,0 +1,64 @@
+#pragma once
+#include <cassert>
+
+namespace stringfield
+{
+
+// Bounded FIFO with deque-like access (index 0 = oldest). Storage is inline,
+// so pushing and popping never allocate.
+template <typename T, int Capacity>
+class FixedRingBuffer
+{
+public:
+    int size() const noexcept { return count; }
+    bool empty() const noexcept { return count == 0; }
+    bool full() const noexcept { return count == Capacity; }
+    static constexpr int capacity() noexcept { return Capacity; }
+
+    void clear() noexcept { head = 0; count = 0; }
+
+    // Appends at the back; when full, the oldest element is overwritten
+    void pushBack(const T& value) noexcept
+    {
+        if (count == Capacity)
+            popFront();
+
+        items[(head + count) % Capacity] = value;
+        ++count;
+    }
+
+    void popFront() noexcept
+    {
+        assert(count > 0);
+        head = (head + 1) % Capacity;
+        --count;
+    }
+
+    // Removes one element, keeping the order of the rest (O(size))
+    void erase(int index) noexcept
+    {
+        assert(index >= 0 && index < count);
+        for (int i = index; i + 1 < count; ++i)
+            items[(head + i) % Capacity] = items[(head + i + 1) % Capacity];
+        --count;
+    }
+
+    const T& operator[](int index) const noexcept
+    {
+        assert(index >= 0 && index < count);
+        return items[(head + index) % Capacity];
+    }
+
+    T& operator[](int index) noexcept
+    {
+        assert(index >= 0 && index < count);
+        return items[(head + index) % Capacity];
+    }
+
+private:
+    T items[Capacity] {};
+    int head = 0;
+    int count = 0;
+};
+
+} // namespace stringfield
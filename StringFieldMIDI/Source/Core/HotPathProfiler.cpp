@@ -0,0 +1,191 @@
+#include "HotPathProfiler.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace stringfield
+{
+
+const char* getStageName(HotPathStage stage)
+{
+    switch (stage)
+    {
+        case HotPathStage::Block:       return "block";
+        case HotPathStage::Controllers: return "controllers";
+        case HotPathStage::Parameters:  return "parameters";
+        case HotPathStage::Locate:      return "locate";
+        case HotPathStage::Pedal:       return "pedal";
+        case HotPathStage::Notes:       return "notes";
+        case HotPathStage::Playout:     return "playout";
+        default:                        return "?";
+    }
+}
+
+uint64_t StageStats::getPercentileCycles(double fraction) const noexcept
+{
+    if (count == 0)
+        return 0;
+
+    const auto target = (uint64_t)std::max(1.0, fraction * (double)count);
+    uint64_t seen = 0;
+
+    for (int b = 0; b < NumBuckets; ++b)
+    {
+        seen += buckets[b];
+        if (seen >= target)
+            return std::min(maxCycles, (uint64_t)2 << b);
+    }
+
+    return maxCycles;
+}
+
+double HotPathReport::getAverageLoad() const noexcept
+{
+    if (samples == 0 || sampleRate <= 0.0 || cyclesPerSecond <= 0.0)
+        return 0.0;
+
+    const double budgetCycles = (double)samples / sampleRate * cyclesPerSecond;
+    return (double)stages[(int)HotPathStage::Block].totalCycles / budgetCycles;
+}
+
+double HotPathReport::cyclesToMicroseconds(double cycles) const noexcept
+{
+    return cyclesPerSecond > 0.0 ? cycles / cyclesPerSecond * 1.0e6 : 0.0;
+}
+
+std::string HotPathReport::format() const
+{
+    std::string text;
+    char line[160];
+
+    std::snprintf(line, sizeof(line),
+                  "%llu blocks, %llu events (max %llu per block), %llu dropped\n"
+                  "load: average %.3f%%, worst block %.2f%%\n\n",
+                  (unsigned long long)blocks, (unsigned long long)events,
+                  (unsigned long long)maxEventsPerBlock, (unsigned long long)droppedEvents,
+                  getAverageLoad() * 100.0, worstBlockLoad * 100.0);
+    text += line;
+
+    std::snprintf(line, sizeof(line), "%-12s %10s %10s %10s %10s %10s\n",
+                  "stage", "count", "mean us", "p50 us", "p99 us", "max us");
+    text += line;
+
+    for (int i = 0; i < NumStages; ++i)
+    {
+        const auto& stage = stages[i];
+        const double mean = stage.count > 0 ? (double)stage.totalCycles / (double)stage.count : 0.0;
+
+        std::snprintf(line, sizeof(line), "%-12s %10llu %10.3f %10.3f %10.3f %10.3f\n",
+                      getStageName((HotPathStage)i), (unsigned long long)stage.count,
+                      cyclesToMicroseconds(mean),
+                      cyclesToMicroseconds((double)stage.getPercentileCycles(0.5)),
+                      cyclesToMicroseconds((double)stage.getPercentileCycles(0.99)),
+                      cyclesToMicroseconds((double)stage.maxCycles));
+        text += line;
+    }
+
+    return text;
+}
+
+#if STRINGFIELD_INSTRUMENTATION
+
+HotPathProfiler::HotPathProfiler() noexcept
+    : originCycles(readCycleCounter()),
+      originTime(std::chrono::steady_clock::now())
+{
+}
+
+void HotPathProfiler::clear() noexcept
+{
+    for (auto& stage : stages)
+    {
+        stage.count.store(0, std::memory_order_relaxed);
+        stage.totalCycles.store(0, std::memory_order_relaxed);
+        stage.maxCycles.store(0, std::memory_order_relaxed);
+
+        for (auto& bucket : stage.buckets)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+
+    blocks.store(0, std::memory_order_relaxed);
+    samples.store(0, std::memory_order_relaxed);
+    events.store(0, std::memory_order_relaxed);
+    maxEventsPerBlock.store(0, std::memory_order_relaxed);
+    worstCyclesPerSample.store(0, std::memory_order_relaxed);
+}
+
+void HotPathProfiler::beginBlock() noexcept
+{
+    if (resetRequested.load(std::memory_order_relaxed)
+        && resetRequested.exchange(false, std::memory_order_acquire))
+        clear();
+
+    blockStart = readCycleCounter();
+}
+
+void HotPathProfiler::endBlock(int numSamples, int numEvents, uint64_t dropped) noexcept
+{
+    const uint64_t cycles = readCycleCounter() - blockStart;
+    record(HotPathStage::Block, cycles);
+
+    add(blocks, 1);
+    add(samples, (uint64_t)numSamples);
+    add(events, (uint64_t)numEvents);
+    raise(maxEventsPerBlock, (uint64_t)numEvents);
+    droppedEvents.store(dropped, std::memory_order_relaxed);
+
+    if (numSamples > 0)
+        raise(worstCyclesPerSample, (cycles << 8) / (uint64_t)numSamples);
+}
+
+void HotPathProfiler::record(HotPathStage which, uint64_t cycles) noexcept
+{
+    auto& stage = stages[(int)which];
+
+    int bucket = 0;
+    for (uint64_t c = cycles >> 1; c != 0 && bucket < StageStats::NumBuckets - 1; c >>= 1)
+        ++bucket;
+
+    add(stage.count, 1);
+    add(stage.totalCycles, cycles);
+    add(stage.buckets[bucket], 1);
+    raise(stage.maxCycles, cycles);
+}
+
+HotPathReport HotPathProfiler::getReport() const
+{
+    HotPathReport report;
+
+    for (int i = 0; i < HotPathReport::NumStages; ++i)
+    {
+        auto& out = report.stages[i];
+        out.count = stages[i].count.load(std::memory_order_relaxed);
+        out.totalCycles = stages[i].totalCycles.load(std::memory_order_relaxed);
+        out.maxCycles = stages[i].maxCycles.load(std::memory_order_relaxed);
+
+        for (int b = 0; b < StageStats::NumBuckets; ++b)
+            out.buckets[b] = stages[i].buckets[b].load(std::memory_order_relaxed);
+    }
+
+    report.blocks = blocks.load(std::memory_order_relaxed);
+    report.samples = samples.load(std::memory_order_relaxed);
+    report.events = events.load(std::memory_order_relaxed);
+    report.maxEventsPerBlock = maxEventsPerBlock.load(std::memory_order_relaxed);
+    report.droppedEvents = droppedEvents.load(std::memory_order_relaxed);
+    report.sampleRate = preparedSampleRate.load(std::memory_order_relaxed);
+
+    // The counter's rate, measured over the profiler's lifetime
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - originTime).count();
+    if (elapsed > 0.0)
+        report.cyclesPerSecond = (double)(readCycleCounter() - originCycles) / elapsed;
+
+    const double budgetCyclesPerSample = report.cyclesPerSecond / std::max(1.0, report.sampleRate);
+    if (budgetCyclesPerSample > 0.0)
+        report.worstBlockLoad = (double)worstCyclesPerSample.load(std::memory_order_relaxed) / 256.0
+                                / budgetCyclesPerSample;
+
+    return report;
+}
+
+#endif
+
+} // namespace stringfield
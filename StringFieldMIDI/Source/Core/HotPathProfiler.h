@@ -0,0 +1,206 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#if STRINGFIELD_INSTRUMENTATION
+ #include <chrono>
+ #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <intrin.h>
+ #elif defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+ #endif
+#endif
+
+// Cycle-count timing of the audio callback and its stages.
+//
+// When STRINGFIELD_INSTRUMENTATION is defined (the CMake option of the same
+// name, on by default), ScopedStageTimer reads the CPU cycle counter around a
+// stage and the audio thread files the result into a log2 histogram. Every
+// slot has a single writer, so recording is a plain relaxed load/store (no
+// locked instructions), a few dozen cycles per stage. Any thread can read a
+// HotPathReport at any time. In other builds every call compiles to nothing.
+
+namespace stringfield
+{
+
+enum class HotPathStage : int
+{
+    Block,          // The whole processBlock
+    Controllers,    // Input CC scan (learn, mapped CCs, passthrough)
+    Parameters,     // Snapshot, conductor and engine parameter updates
+    Locate,         // Checkpoint restore after a transport jump
+    Pedal,          // Sustain toggles and their rescheduling
+    Notes,          // Note picking, voice allocation and scheduling
+    Playout,        // Copying pre-generated events out (lookahead mode)
+    NumStages
+};
+
+const char* getStageName(HotPathStage stage);
+
+struct StageStats
+{
+    static constexpr int NumBuckets = 40;     // Bucket b: [2^b, 2^(b+1)) cycles
+
+    uint64_t count = 0;
+    uint64_t totalCycles = 0;
+    uint64_t maxCycles = 0;
+    uint64_t buckets[NumBuckets] {};
+
+    // Upper edge of the bucket holding the given fraction (0-1) of samples
+    uint64_t getPercentileCycles(double fraction) const noexcept;
+};
+
+struct HotPathReport
+{
+    static constexpr int NumStages = (int)HotPathStage::NumStages;
+
+    StageStats stages[NumStages];
+
+    uint64_t blocks = 0;
+    uint64_t samples = 0;                 // Rendered, summed over blocks
+    uint64_t events = 0;                  // Emitted, summed over blocks
+    uint64_t maxEventsPerBlock = 0;
+    uint64_t droppedEvents = 0;           // Output shaper and MIDI export
+    double worstBlockLoad = 0.0;          // Of that block's real-time budget
+
+    double sampleRate = 0.0;
+    double cyclesPerSecond = 0.0;         // Measured against the system clock
+
+    const StageStats& operator[](HotPathStage stage) const noexcept { return stages[(int)stage]; }
+
+    // Mean share of the real-time budget spent in processBlock
+    double getAverageLoad() const noexcept;
+
+    double cyclesToMicroseconds(double cycles) const noexcept;
+
+    // Plain-text table, one stage per line
+    std::string format() const;
+};
+
+#if STRINGFIELD_INSTRUMENTATION
+
+inline uint64_t readCycleCounter() noexcept
+{
+   #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+   #elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+   #elif defined(__aarch64__)
+    uint64_t ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+   #else
+    return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+   #endif
+}
+
+class HotPathProfiler
+{
+public:
+    static constexpr bool enabled = true;
+
+    HotPathProfiler() noexcept;
+
+    void prepare(double sampleRate) noexcept { preparedSampleRate.store(sampleRate, std::memory_order_relaxed); }
+
+    // === Audio thread ===
+    // Starts the Block stage (and applies a pending reset)
+    void beginBlock() noexcept;
+
+    // Ends it. `droppedEvents` is the running total from the output stages.
+    void endBlock(int numSamples, int numEvents, uint64_t droppedEvents) noexcept;
+
+    void record(HotPathStage stage, uint64_t cycles) noexcept;
+
+    // === Any thread ===
+    HotPathReport getReport() const;
+
+    // Clears everything at the start of the next block
+    void reset() noexcept { resetRequested.store(true, std::memory_order_release); }
+
+private:
+    struct Stage
+    {
+        std::atomic<uint64_t> count { 0 };
+        std::atomic<uint64_t> totalCycles { 0 };
+        std::atomic<uint64_t> maxCycles { 0 };
+        std::atomic<uint64_t> buckets[StageStats::NumBuckets] {};
+    };
+
+    static void add(std::atomic<uint64_t>& counter, uint64_t amount) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    static void raise(std::atomic<uint64_t>& counter, uint64_t value) noexcept
+    {
+        if (value > counter.load(std::memory_order_relaxed))
+            counter.store(value, std::memory_order_relaxed);
+    }
+
+    void clear() noexcept;
+
+    Stage stages[HotPathReport::NumStages];
+
+    std::atomic<uint64_t> blocks { 0 };
+    std::atomic<uint64_t> samples { 0 };
+    std::atomic<uint64_t> events { 0 };
+    std::atomic<uint64_t> maxEventsPerBlock { 0 };
+    std::atomic<uint64_t> droppedEvents { 0 };
+    std::atomic<uint64_t> worstCyclesPerSample { 0 };   // ×256
+    std::atomic<double> preparedSampleRate { 44100.0 };
+    std::atomic<bool> resetRequested { false };
+
+    uint64_t blockStart = 0;
+
+    // Calibration origin for cyclesPerSecond
+    uint64_t originCycles;
+    std::chrono::steady_clock::time_point originTime;
+};
+
+class ScopedStageTimer
+{
+public:
+    ScopedStageTimer(HotPathProfiler* p, HotPathStage s) noexcept
+        : profiler(p), stage(s), start(p != nullptr ? readCycleCounter() : 0) {}
+
+    ~ScopedStageTimer()
+    {
+        if (profiler != nullptr)
+            profiler->record(stage, readCycleCounter() - start);
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    HotPathProfiler* profiler;
+    HotPathStage stage;
+    uint64_t start;
+};
+
+#else
+
+class HotPathProfiler
+{
+public:
+    static constexpr bool enabled = false;
+
+    void prepare(double) noexcept {}
+    void beginBlock() noexcept {}
+    void endBlock(int, int, uint64_t) noexcept {}
+    void record(HotPathStage, uint64_t) noexcept {}
+    HotPathReport getReport() const { return {}; }
+    void reset() noexcept {}
+};
+
+class ScopedStageTimer
+{
+public:
+    ScopedStageTimer(HotPathProfiler*, HotPathStage) noexcept {}
+};
+
+#endif
+
+} // namespace stringfield
@@ -0,0 +1,693 @@
+#include "LookaheadGenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace stringfield
+{
+
+namespace
+{
+    struct DiscardSink : EventSink
+    {
+        void handleEvent(const MidiEvent&) override {}
+    };
+}
+
+void LookaheadGenerator::prepare(double sampleRate)
+{
+    stopWorker();
+
+    sr = sampleRate;
+    chunkSamples = std::max<int64_t>(1, std::llround(sr * ChunkMs / 1000.0));
+    reactionSamples = std::llround(sr * ReactionMs / 1000.0);
+
+    // The worker stays at most MaxDistanceMs plus a chunk ahead, and changes
+    // land at least a reaction time after the playout position
+    historyCapacity = (MaxDistanceMs + ReactionMs) / ChunkMs + 2 + SlackChunks;
+    historyTimes.assign((size_t)historyCapacity, 0);
+    historyStride = 1;
+    historyPlayers.assign((size_t)historyCapacity, StringFieldEngine());
+    clearHistory();
+
+    checkpoints.prepare();
+    checkpointsValid = false;
+
+    staged.clear();
+    staged.reserve(QueueSize);
+    stagedSent = 0;
+
+    // Nobody else touches the queues while the worker is down
+    Command command;
+    while (commands.pop(command)) {}
+    Entry entry;
+    while (events.pop(entry)) {}
+
+    started = false;
+    stateChanged = true;
+    hasSentTransport = false;
+    pending.clear();
+    resendPending = false;
+    hasNext = false;
+    wakePending = false;
+    signalled.store(false, std::memory_order_relaxed);
+    usedChannels = 0;
+    playedEnd = 0;
+    lastChangeTime = 0;
+    playoutEnd.store(0, std::memory_order_relaxed);
+    late.store(0, std::memory_order_relaxed);
+
+    playing = false;
+    head = 0;
+    changeTime = INT64_MIN;
+
+    prepared = true;
+    if (enabled)
+        startWorker();
+}
+
+void LookaheadGenerator::release()
+{
+    stopWorker();
+    prepared = false;
+}
+
+void LookaheadGenerator::setEnabled(bool shouldRun)
+{
+    enabled = shouldRun;
+
+    if (enabled && prepared)
+        startWorker();
+    else if (! enabled)
+        stopWorker();
+}
+
+// === Message thread ===
+
+void LookaheadGenerator::startWorker()
+{
+    if (thread.joinable())
+        return;
+
+    quit = false;
+    thread = std::thread([this] { run(); });
+    running.store(true, std::memory_order_release);
+}
+
+void LookaheadGenerator::stopWorker()
+{
+    if (! thread.joinable())
+        return;
+
+    running.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(wakeLock);
+        quit = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+// === Audio thread ===
+
+void LookaheadGenerator::setDistance(double milliseconds) noexcept
+{
+    const double ms = std::min(std::max(milliseconds, 0.0), (double)MaxDistanceMs);
+    distance.store(std::llround(sr * ms / 1000.0), std::memory_order_relaxed);
+}
+
+void LookaheadGenerator::start(const GeneratorState& newState, int64_t time, int64_t checkpointSpacing,
+                               const TransportPosition* transport, bool silence, EventSink& sink) noexcept
+{
+    if (silence)
+        emitStop(sink);
+
+    started = true;
+    state = newState;
+    origin = time + reactionSamples;
+    playoutEnd.store(time, std::memory_order_release);
+    playedEnd = time;
+
+    Command command;
+    command.type = Command::Start;
+    command.time = origin;
+    command.spacing = checkpointSpacing;
+    command.state = state;
+    command.changed = stateChanged;
+
+    hasSentTransport = transport != nullptr;
+    if (hasSentTransport)
+    {
+        sentTransport = extrapolate(*transport, origin);
+        command.hasTransport = true;
+        command.transport = sentTransport;
+    }
+
+    stateChanged = false;
+    hasNext = false;
+    send(command);
+}
+
+void LookaheadGenerator::update(const GeneratorState& newState, int64_t time) noexcept
+{
+    state = newState;
+    stateChanged = true;
+
+    if (! started)
+        return;
+
+    Command command;
+    command.type = Command::Update;
+    command.time = nextBoundary(time);
+    command.state = state;
+    command.changed = true;
+
+    stateChanged = false;
+    send(command);
+}
+
+void LookaheadGenerator::setTransport(const TransportPosition& position) noexcept
+{
+    if (! started)
+        return;
+
+    // Same test as the engine: a host that agrees with the map sent last changes nothing
+    const double spb = 60.0 / std::max(1.0, position.bpm) * sr;
+    if (hasSentTransport)
+    {
+        const double sentSpb = 60.0 / std::max(1.0, sentTransport.bpm) * sr;
+        const double expectedPpq = sentTransport.ppq + (double)(position.time - sentTransport.time) / sentSpb;
+
+        if (std::abs(spb - sentSpb) <= 1e-9 * spb && std::abs(expectedPpq - position.ppq) <= 1e-6)
+            return;
+    }
+
+    Command command;
+    command.type = Command::Update;
+    command.time = nextBoundary(position.time);
+    command.state = state;
+    command.hasTransport = true;
+    command.transport = extrapolate(position, command.time);
+
+    sentTransport = command.transport;
+    hasSentTransport = true;
+    send(command);
+}
+
+void LookaheadGenerator::stop(EventSink& sink) noexcept
+{
+    emitStop(sink);
+    started = false;
+    hasNext = false;
+
+    Command command;
+    command.type = Command::Stop;
+    command.state = state;
+    send(command);
+}
+
+void LookaheadGenerator::play(int64_t startSample, int numSamples, EventSink& sink) noexcept
+{
+    if (resendPending)
+        resend(startSample);
+
+    if (wakePending)
+        tryWake();
+
+    const int64_t end = startSample + numSamples;
+    playoutEnd.store(end, std::memory_order_release);
+    playedEnd = end;
+
+    for (;;)
+    {
+        if (! hasNext && ! events.pop(next))
+            break;
+
+        hasNext = true;
+
+        if (next.size == 0)
+        {
+            acknowledge(next.epoch);
+            hasNext = false;
+            continue;
+        }
+
+        if (isSuperseded(next))
+        {
+            hasNext = false;
+            continue;
+        }
+
+        if (next.time >= end)
+            break;
+
+        MidiEvent event;
+        event.offset = (int)std::max<int64_t>(0, next.time - startSample);
+        std::copy(next.data, next.data + 3, event.data);
+        event.size = next.size;
+
+        if (next.time < startSample)
+            late.fetch_add(1, std::memory_order_relaxed);
+
+        usedChannels = (uint16_t)(usedChannels | (1 << (event.getChannel() - 1)));
+        sink.handleEvent(event);
+        hasNext = false;
+    }
+}
+
+void LookaheadGenerator::discard() noexcept
+{
+    if (resendPending)
+        resend(playoutEnd.load(std::memory_order_relaxed));
+
+    hasNext = false;
+
+    if (wakePending)
+        tryWake();
+
+    Entry entry;
+    while (events.pop(entry))
+        if (entry.size == 0)
+            acknowledge(entry.epoch);
+}
+
+void LookaheadGenerator::send(Command command) noexcept
+{
+    // Something that didn't fit last time is folded into this command: a
+    // newer update or start carries the whole state anyway
+    if (resendPending)
+    {
+        if (unsent.type != Command::Update && command.type == Command::Update)
+        {
+            unsent.state = command.state;
+            unsent.changed = unsent.changed || command.changed;
+            if (command.hasTransport)
+            {
+                unsent.hasTransport = true;
+                unsent.transport = command.transport;
+            }
+            return;
+        }
+
+        command.changed = command.changed || unsent.changed;
+        if (unsent.hasTransport && ! command.hasTransport && command.type == Command::Update)
+        {
+            command.hasTransport = true;
+            command.transport = extrapolate(unsent.transport, command.time);
+            sentTransport = command.transport;
+        }
+        resendPending = false;
+    }
+
+    command.epoch = nextEpoch;
+
+    if (pending.full() || ! commands.push(command))
+    {
+        unsent = command;
+        resendPending = true;
+        return;
+    }
+
+    ++nextEpoch;
+    pending.pushBack({ command.epoch, command.time, command.type != Command::Update });
+    lastChangeTime = command.time;
+    signal();
+}
+
+void LookaheadGenerator::signal() noexcept
+{
+    signalled.store(true, std::memory_order_release);
+    wakePending = true;
+    tryWake();
+}
+
+void LookaheadGenerator::tryWake() noexcept
+{
+    // The worker holds the mutex from checking `signalled` until it sleeps,
+    // so a notify sent while it does could be lost. Getting the mutex means
+    // it is either asleep (and the notify wakes it) or will see the flag.
+    if (! wakeLock.try_lock())
+        return;
+
+    wakeLock.unlock();
+    wakePending = false;
+    wake.notify_one();
+}
+
+void LookaheadGenerator::resend(int64_t now) noexcept
+{
+    Command command = unsent;
+    resendPending = false;
+
+    if (command.type == Command::Start)
+    {
+        origin = now + reactionSamples;
+        command.time = origin;
+    }
+    else if (command.type == Command::Update)
+    {
+        command.time = nextBoundary(now);
+    }
+
+    if (command.hasTransport)
+    {
+        command.transport = extrapolate(command.transport, command.time);
+        sentTransport = command.transport;
+    }
+
+    send(command);
+}
+
+void LookaheadGenerator::acknowledge(uint32_t epoch) noexcept
+{
+    while (! pending.empty() && (int32_t)(epoch - pending[0].epoch) >= 0)
+        pending.popFront();
+}
+
+bool LookaheadGenerator::isSuperseded(const Entry& entry) const noexcept
+{
+    // A start or stop that couldn't be sent yet already ended the old timeline
+    if (resendPending && unsent.type != Command::Update)
+        return true;
+
+    // Before the marker of the oldest command in flight, everything at or
+    // after its time is being regenerated
+    if (pending.empty())
+        return false;
+
+    return pending[0].restart || entry.time >= pending[0].time;
+}
+
+void LookaheadGenerator::emitStop(EventSink& sink) noexcept
+{
+    for (int ch = 1; ch <= 16; ++ch)
+    {
+        if ((usedChannels & (1 << (ch - 1))) == 0)
+            continue;
+
+        sink.handleEvent(MidiEvent::controller(0, ch, 64, 0));   // Pedal up
+        sink.handleEvent(MidiEvent::controller(0, ch, 123, 0));  // All Notes Off
+        sink.handleEvent(MidiEvent::controller(0, ch, 120, 0));  // All Sound Off
+    }
+
+    usedChannels = 0;
+}
+
+int64_t LookaheadGenerator::nextBoundary(int64_t time) const noexcept
+{
+    // Never at the start itself, so a change can't meet the start's own events
+    const int64_t earliest = std::max(time + reactionSamples, origin + chunkSamples);
+    return origin + (earliest - origin + chunkSamples - 1) / chunkSamples * chunkSamples;
+}
+
+TransportPosition LookaheadGenerator::extrapolate(const TransportPosition& position, int64_t time) const noexcept
+{
+    const double spb = 60.0 / std::max(1.0, position.bpm) * sr;
+
+    TransportPosition moved = position;
+    moved.ppq += (double)(time - position.time) / spb;
+    moved.time = time;
+    return moved;
+}
+
+// === Worker thread ===
+
+void LookaheadGenerator::run()
+{
+    std::unique_lock<std::mutex> lock(wakeLock);
+
+    while (! quit)
+    {
+        lock.unlock();
+        const bool busy = work();
+        lock.lock();
+
+        if (busy || quit)
+            continue;
+
+        // While playing, the playout position moves without a signal; check
+        // it often enough to meet the reaction time. Otherwise sleep until
+        // the audio thread sends something.
+        auto woken = [this] { return quit || signalled.exchange(false, std::memory_order_acquire); };
+        if (playing)
+            wake.wait_for(lock, std::chrono::milliseconds(PollMs), woken);
+        else
+            wake.wait(lock, woken);
+    }
+}
+
+bool LookaheadGenerator::work()
+{
+    Command command;
+    while (commands.pop(command))
+        apply(command);
+
+    // A full queue means the audio thread has enough to play for now
+    if (! flush())
+        return false;
+
+    if (! playing || head >= playoutEnd.load(std::memory_order_acquire) + distance.load(std::memory_order_relaxed))
+        return false;
+
+    renderChunk();
+    flush();
+    return true;
+}
+
+bool LookaheadGenerator::flush()
+{
+    while (stagedSent < staged.size())
+    {
+        if (! events.push(staged[stagedSent]))
+            return false;
+        ++stagedSent;
+    }
+
+    staged.clear();
+    stagedSent = 0;
+    return true;
+}
+
+void LookaheadGenerator::apply(const Command& command)
+{
+    if (command.changed)
+        checkpointsValid = false;
+
+    switch (command.type)
+    {
+        case Command::Start:
+            startAt(command, false);
+            break;
+
+        case Command::Update:
+            if (playing)
+            {
+                updateAt(command);
+            }
+            else
+            {
+                current = command.state;
+                mark(command.epoch);
+            }
+            break;
+
+        case Command::Stop:
+            dropStagedEvents();
+            mark(command.epoch);
+            playing = false;
+            break;
+    }
+}
+
+void LookaheadGenerator::startAt(const Command& command, bool silence)
+{
+    const int64_t time = command.time;
+    dropStagedEvents();
+    mark(command.epoch);
+
+    StageSink sink(staged, time);
+    if (silence)
+        generator.stop(sink);
+
+    current = command.state;
+    if (command.type == Command::Start)
+        spacing = command.spacing;
+
+    DiscardSink discard;
+    generator.reset();
+    generator.prepare(sr);
+    generator.setPitchClassSet(current.pcSet);
+    generator.setWeightProfile(current.weights);
+    generator.setLayout(current.layout, time, discard);
+    generator.setParameters(current.params, time, discard);
+
+    const TransportPosition* transport = command.hasTransport ? &command.transport : nullptr;
+    if (! checkpointsValid)
+    {
+        checkpoints.reset(sr, current.params, current.layout, current.pcSet, current.weights, transport);
+        checkpointsValid = true;
+    }
+
+    checkpoints.restore(generator, time, spacing);
+    if (transport != nullptr)
+        generator.setTransport(*transport);
+
+    generator.sendControllerState(sink);
+
+    playing = true;
+    head = time;
+    changeTime = INT64_MIN;
+    clearHistory();
+    capture(time);
+}
+
+void LookaheadGenerator::updateAt(const Command& command)
+{
+    const int64_t time = command.time;
+
+    if (time < head || time == changeTime)
+    {
+        // Too far behind for the snapshots: start over from the change,
+        // releasing whatever the lost stretch left sounding
+        if (! rewind(time))
+        {
+            startAt(command, true);
+            return;
+        }
+    }
+    else
+    {
+        while (head < time)
+            renderChunk();
+    }
+
+    dropStaged(time);
+
+    beforeChange = generator;
+    beforeChangeState = current;
+    changeTime = time;
+
+    mark(command.epoch);
+
+    // In the processor's order: parameters, then the shared objects
+    StageSink sink(staged, time);
+    generator.setParameters(command.state.params, time, sink);
+
+    if (command.state.pcSet != current.pcSet)
+        generator.setPitchClassSet(command.state.pcSet);
+    if (command.state.weights != current.weights)
+        generator.setWeightProfile(command.state.weights);
+    if (command.state.layout != current.layout)
+        generator.setLayout(command.state.layout, time, sink);
+
+    if (command.hasTransport)
+        generator.setTransport(command.transport);
+
+    current = command.state;
+    clearHistory();
+    capture(time);
+}
+
+bool LookaheadGenerator::rewind(int64_t time)
+{
+    // A second change at the same boundary replaces the first one
+    if (time == changeTime)
+    {
+        generator = beforeChange;
+        current = beforeChangeState;
+        head = time;
+        clearHistory();
+        return true;
+    }
+
+    for (int i = historyCount - 1; i >= 0; --i)
+    {
+        const int slot = (historyFirst + i) % historyCapacity;
+        if (historyTimes[(size_t)slot] < time)
+            break;
+
+        if (historyTimes[(size_t)slot] == time)
+        {
+            for (int p = 0; p < historyStride; ++p)
+                generator.getPlayer(p) = historyPlayers[(size_t)(slot * historyStride + p)];
+
+            historyCount = i + 1;
+            head = time;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void LookaheadGenerator::renderChunk()
+{
+    StageSink sink(staged, head);
+    generator.render(head, (int)chunkSamples, sink);
+    head += chunkSamples;
+
+    if (checkpointsValid)
+        checkpoints.capture(generator, head, spacing);
+
+    capture(head);
+}
+
+void LookaheadGenerator::mark(uint32_t epoch)
+{
+    staged.push_back({ 0, epoch, { 0, 0, 0 }, 0 });
+}
+
+void LookaheadGenerator::dropStaged(int64_t from)
+{
+    // Unsent events after the last marker are in time order
+    while (staged.size() > stagedSent && staged.back().size != 0 && staged.back().time >= from)
+        staged.pop_back();
+}
+
+void LookaheadGenerator::dropStagedEvents()
+{
+    // The markers still have to reach the audio thread
+    auto first = staged.begin() + (std::ptrdiff_t)stagedSent;
+    staged.erase(std::remove_if(first, staged.end(), [](const Entry& e) { return e.size != 0; }), staged.end());
+}
+
+void LookaheadGenerator::capture(int64_t time)
+{
+    const int stride = generator.getNumPlayers();
+    if (stride != historyStride)
+    {
+        historyStride = stride;
+        historyPlayers.resize((size_t)(historyCapacity * stride));
+        clearHistory();
+    }
+
+    int slot;
+    if (historyCount == historyCapacity)
+    {
+        slot = historyFirst;
+        historyFirst = (historyFirst + 1) % historyCapacity;
+    }
+    else
+    {
+        slot = (historyFirst + historyCount) % historyCapacity;
+        ++historyCount;
+    }
+
+    historyTimes[(size_t)slot] = time;
+    for (int p = 0; p < stride; ++p)
+        historyPlayers[(size_t)(slot * stride + p)] = generator.getPlayer(p);
+}
+
+void LookaheadGenerator::clearHistory()
+{
+    historyFirst = 0;
+    historyCount = 0;
+}
+
+void LookaheadGenerator::StageSink::handleEvent(const MidiEvent& event)
+{
+    staged.push_back({ base + event.offset, 0, { event.data[0], event.data[1], event.data[2] },
+                       (uint8_t)event.size });
+}
+
+} // namespace stringfield
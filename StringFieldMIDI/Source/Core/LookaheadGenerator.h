@@ -0,0 +1,254 @@
+#pragma once
+#include "CheckpointCache.h"
+#include "Ensemble.h"
+#include "FixedRingBuffer.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace stringfield
+{
+
+// Plays out an ensemble that a background thread generates ahead of time.
+//
+// A worker thread owns its own Ensemble and renders it in fixed chunks up to
+// `distance` past the playout position, streaming the events through a
+// lock-free queue. The audio thread only moves due events into the sink, so
+// its cost is one copy per event whatever the generator is doing.
+//
+// Events already queued can't see a change, so changes take effect at the
+// first chunk boundary at least ReactionMs after the block that made them.
+// The worker rewinds to its snapshot at that boundary, applies the change and
+// regenerates from there; the audio thread drops the superseded events. The
+// old timeline plays up to the boundary, so the two join without gaps or
+// stuck notes. A start or locate begins one reaction time after the host
+// position (the lead-in is silent). Should the worker fall behind anyway,
+// events are played at the start of the block they were due before, and
+// counted as late.
+//
+// The pointers in a GeneratorState stay in use by the worker until
+// isCurrent() reports that it has taken every state handed to it.
+//
+// The worker thread only exists while enabled (and prepared), and sleeps
+// without polling while nothing plays: the audio thread wakes it once per
+// command. While playing it checks the playout position every PollMs.
+//
+// prepare(), release() and setEnabled() run on the message thread;
+// everything else is for the audio thread and never allocates, locks or
+// waits for the worker. A wake is a try_lock of the worker's mutex and, if
+// that succeeds, one notify; if the worker holds the mutex just then, the
+// next block tries again.
+class LookaheadGenerator
+{
+public:
+    static constexpr int MaxDistanceMs = 500;
+    static constexpr int ChunkMs = 10;        // Worker render step; changes land on its boundaries
+    static constexpr int ReactionMs = 20;     // Least delay from a change to its boundary
+    static constexpr int QueueSize = 4096;    // Events between the worker and the audio thread
+
+    LookaheadGenerator() = default;
+    ~LookaheadGenerator() { release(); }
+
+    // === Control (message thread) ===
+    // Allocates the snapshot stores; starts the worker if enabled (restarting it if running).
+    // The audio thread must be idle.
+    void prepare(double sampleRate);
+
+    // Stops the worker until the next prepare()
+    void release();
+
+    // Starts or stops the worker thread (it only runs between prepare() and
+    // release()). Generator state is kept, so playout resumes where it was.
+    void setEnabled(bool shouldRun);
+
+    // The worker thread is up (the audio thread should only play out while it is)
+    bool isRunning() const noexcept { return running.load(std::memory_order_acquire); }
+
+    // === Audio thread ===
+
+    // How far ahead of the playout position the worker renders (clamped to MaxDistanceMs)
+    void setDistance(double milliseconds) noexcept;
+
+    // Starts generating from the state the ensemble has one reaction time
+    // after `time` (like a locate). `silence` releases what was playing.
+    void start(const GeneratorState& state, int64_t time, int64_t checkpointSpacing,
+               const TransportPosition* transport, bool silence, EventSink& sink) noexcept;
+
+    // A new state, made at `time`. While stopped it is only kept for the next start().
+    void update(const GeneratorState& state, int64_t time) noexcept;
+
+    // Host position for synced pulses, every block like Ensemble::setTransport.
+    // Only a jump or tempo change is passed on (as a change at the next boundary).
+    void setTransport(const TransportPosition& position) noexcept;
+
+    // Transport stop: pedal up, all notes off, all sound off on the channels played
+    void stop(EventSink& sink) noexcept;
+
+    // Emits the events due in [startSample, startSample + numSamples)
+    void play(int64_t startSample, int numSamples, EventSink& sink) noexcept;
+
+    // Drops whatever the worker still sends while nothing is played
+    void discard() noexcept;
+
+    bool isPlaying() const noexcept { return started; }
+
+    // The worker has taken the latest state and can't return to an older one
+    // (so pointers only older states held are free to go)
+    bool isCurrent() const noexcept
+    {
+        return pending.empty() && ! resendPending && (! started || playedEnd > lastChangeTime);
+    }
+
+    // Events played after their time because the worker fell behind
+    uint64_t getLateCount() const noexcept { return late.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int PollMs = 2;          // Worker check interval while playing
+    static constexpr int SlackChunks = 16;    // Snapshots kept behind the playout position
+
+    struct Command
+    {
+        enum Type : uint8_t { Start, Update, Stop };
+
+        Type type = Update;
+        bool changed = false;             // State differs from the previous command's
+        bool hasTransport = false;
+        uint32_t epoch = 0;
+        int64_t time = 0;                 // Where it takes effect (a chunk boundary for updates)
+        int64_t spacing = 0;              // Checkpoint spacing (Start)
+        GeneratorState state;
+        TransportPosition transport;      // At `time`
+    };
+
+    // A MIDI message at an absolute time, or (size 0) the marker the worker
+    // sends when it has applied command `epoch`
+    struct Entry
+    {
+        int64_t time;
+        uint32_t epoch;
+        uint8_t data[3];
+        uint8_t size;
+    };
+
+    // Worker → staging, at `base` + offset
+    struct StageSink : EventSink
+    {
+        StageSink(std::vector<Entry>& s, int64_t b) : staged(s), base(b) {}
+        void handleEvent(const MidiEvent& event) override;
+
+        std::vector<Entry>& staged;
+        int64_t base;
+    };
+
+    // === Audio thread ===
+    void send(Command command) noexcept;
+    void signal() noexcept;
+    void tryWake() noexcept;
+    void resend(int64_t now) noexcept;
+    void acknowledge(uint32_t epoch) noexcept;
+    bool isSuperseded(const Entry& entry) const noexcept;
+    void emitStop(EventSink& sink) noexcept;
+    int64_t nextBoundary(int64_t time) const noexcept;
+    TransportPosition extrapolate(const TransportPosition& position, int64_t time) const noexcept;
+
+    // === Message thread ===
+    void startWorker();
+    void stopWorker();
+
+    // === Worker thread ===
+    void run();
+    bool work();
+    bool flush();
+    void apply(const Command& command);
+    void startAt(const Command& command, bool silence);
+    void updateAt(const Command& command);
+    bool rewind(int64_t time);
+    void renderChunk();
+    void mark(uint32_t epoch);
+    void dropStaged(int64_t from);
+    void dropStagedEvents();
+    void capture(int64_t time);
+    void clearHistory();
+
+    double sr = 44100.0;
+    int64_t chunkSamples = 441;
+    int64_t reactionSamples = 882;
+
+    // Shared
+    SpscQueue<Command, 64> commands;                  // Audio → worker
+    SpscQueue<Entry, QueueSize> events;               // Worker → audio
+    std::atomic<int64_t> playoutEnd { 0 };            // End of the last played block
+    std::atomic<int64_t> distance { 0 };              // In samples
+    std::atomic<uint64_t> late { 0 };
+    std::atomic<bool> signalled { false };           // Audio → worker: commands waiting
+    std::atomic<bool> running { false };
+
+    // === Audio thread state ===
+    struct Pending
+    {
+        uint32_t epoch;
+        int64_t time;
+        bool restart;                     // Everything queued before its marker is stale
+    };
+
+    bool started = false;
+    int64_t origin = 0;                   // Start time; chunk boundaries are counted from it
+    GeneratorState state;
+    bool stateChanged = true;             // Since the last command
+    TransportPosition sentTransport;
+    bool hasSentTransport = false;
+    uint32_t nextEpoch = 1;
+    FixedRingBuffer<Pending, 64> pending; // Sent, marker not seen yet
+    Command unsent;                       // Didn't fit the queue; retried next block
+    bool resendPending = false;
+    int64_t playedEnd = 0;
+    int64_t lastChangeTime = 0;           // Of the newest command; another may land here until played
+    Entry next {};                        // Popped, not due yet
+    bool wakePending = false;             // signalled is set, the worker not woken yet
+    bool hasNext = false;
+    uint16_t usedChannels = 0;            // Played since the last stop (bit 0 = channel 1)
+
+    // === Worker thread state ===
+    std::thread thread;
+    std::mutex wakeLock;
+    std::condition_variable wake;
+    bool quit = false;                    // Guarded by wakeLock
+    bool enabled = false;                 // Message thread
+    bool prepared = false;
+
+    Ensemble generator;
+    GeneratorState current;
+    bool playing = false;
+    int64_t head = 0;                     // Rendered up to here (a chunk boundary)
+
+    // The state just before the last change, for another change at the same boundary
+    Ensemble beforeChange;
+    GeneratorState beforeChangeState;
+    int64_t changeTime = 0;
+
+    // Snapshots at chunk boundaries since the last change (players only; the
+    // rest of the ensemble is the same for all of them). A ring, oldest first.
+    std::vector<int64_t> historyTimes;
+    std::vector<StringFieldEngine> historyPlayers;
+    int historyCapacity = 0;
+    int historyFirst = 0;
+    int historyCount = 0;
+    int historyStride = 1;
+
+    // Locate support, as in the processor
+    CheckpointCache checkpoints;
+    bool checkpointsValid = false;
+    int64_t spacing = 0;
+
+    // Rendered, not yet in the queue (grows freely; the worker may allocate)
+    std::vector<Entry> staged;
+    size_t stagedSent = 0;
+
+    LookaheadGenerator(const LookaheadGenerator&) = delete;
+    LookaheadGenerator& operator=(const LookaheadGenerator&) = delete;
+};
+
+} // namespace stringfield
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+
+namespace stringfield
+{
+
+// A short MIDI message placed at a sample offset within a rendered block.
+// Channels are 1-16, matching juce::MidiMessage.
+struct MidiEvent
+{
+    int offset = 0;
+    uint8_t data[3] = { 0, 0, 0 };
+    int size = 3;
+
+    static MidiEvent noteOn(int offset, int channel, int note, int velocity)
+    {
+        return make(offset, 0x90, channel, note, velocity);
+    }
+
+    static MidiEvent noteOff(int offset, int channel, int note)
+    {
+        return make(offset, 0x80, channel, note, 0);
+    }
+
+    static MidiEvent controller(int offset, int channel, int cc, int value)
+    {
+        return make(offset, 0xB0, channel, cc, value);
+    }
+
+    int getChannel() const { return (data[0] & 0x0F) + 1; }
+    bool isNoteOn() const { return (data[0] & 0xF0) == 0x90 && data[2] > 0; }
+    bool isNoteOff() const { return (data[0] & 0xF0) == 0x80 || ((data[0] & 0xF0) == 0x90 && data[2] == 0); }
+    bool isController() const { return (data[0] & 0xF0) == 0xB0; }
+
+private:
+    static MidiEvent make(int offset, int status, int channel, int d1, int d2)
+    {
+        MidiEvent e;
+        e.offset = offset;
+        e.data[0] = (uint8_t)(status | ((channel - 1) & 0x0F));
+        e.data[1] = (uint8_t)(d1 & 0x7F);
+        e.data[2] = (uint8_t)(d2 & 0x7F);
+        return e;
+    }
+};
+
+// Receives events emitted by the engine, in time order.
+class EventSink
+{
+public:
+    virtual ~EventSink() = default;
+    virtual void handleEvent(const MidiEvent& event) = 0;
+};
+
+} // namespace stringfield
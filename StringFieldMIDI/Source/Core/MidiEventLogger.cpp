@@ -0,0 +1,83 @@
+#include "MidiEventLogger.h"
+#include <chrono>
+
+namespace stringfield
+{
+
+bool MidiEventLogger::start(const std::string& path, double sampleRate)
+{
+    stop();
+
+    // Nothing consumes the queue while stopped; discard anything pushed late
+    Entry stale;
+    while (queue.pop(stale)) {}
+
+    if (! writer.open(path, sampleRate))
+        return false;
+
+    written.store(0, std::memory_order_relaxed);
+    dropped.store(0, std::memory_order_relaxed);
+
+    quit = false;
+    thread = std::thread([this] { run(); });
+    recording.store(true, std::memory_order_release);
+    return true;
+}
+
+void MidiEventLogger::stop()
+{
+    recording.store(false, std::memory_order_release);
+
+    if (! thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(wakeLock);
+        quit = true;
+    }
+    wake.notify_one();
+    thread.join();
+
+    // Anything the audio thread pushed while the writer was shutting down
+    drain();
+    writer.close();
+}
+
+void MidiEventLogger::log(const MidiEvent& event) noexcept
+{
+    Entry entry { clock + event.offset, { event.data[0], event.data[1], event.data[2] }, (uint8_t)event.size };
+
+    if (! queue.push(entry))
+        dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MidiEventLogger::run()
+{
+    std::unique_lock<std::mutex> lock(wakeLock);
+
+    while (! quit)
+    {
+        // The audio thread never signals; poll often enough to keep the ring short
+        wake.wait_for(lock, std::chrono::milliseconds(20));
+
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+void MidiEventLogger::drain()
+{
+    Entry entry;
+    uint64_t count = 0;
+
+    while (queue.pop(entry))
+    {
+        writer.write(entry.time, entry.data, entry.size);
+        ++count;
+    }
+
+    written.fetch_add(count, std::memory_order_relaxed);
+}
+
+} // namespace stringfield
@@ -0,0 +1,80 @@
+#pragma once
+#include "MidiEvent.h"
+#include "MidiFileWriter.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace stringfield
+{
+
+// Records emitted MIDI to a .mid file without burdening the audio thread.
+//
+// The audio thread pushes each event into a fixed SPSC ring; a background
+// thread drains it every few milliseconds and streams the events through
+// MidiFileWriter. If the ring is full the event is dropped and counted,
+// never waited for.
+//
+// Events are stamped with the logger's own clock, the samples processed so
+// far, not the host position: a loop, locate or restart jumps the host
+// position back, but the file keeps running forward.
+class MidiEventLogger
+{
+public:
+    static constexpr int Capacity = 16384;     // ~0.3 s of a 1-event-per-sample flood at 48 kHz
+
+    MidiEventLogger() = default;
+    ~MidiEventLogger() { stop(); }
+
+    // === Control (message thread) ===
+    // Opens the file and starts the writer thread. Restarts if already recording.
+    bool start(const std::string& path, double sampleRate);
+
+    // Flushes what's queued, closes the file and joins the writer thread
+    void stop();
+
+    bool isRecording() const noexcept { return recording.load(std::memory_order_acquire); }
+
+    // Totals for the current (or last) recording
+    uint64_t getWrittenCount() const noexcept { return written.load(std::memory_order_relaxed); }
+    uint64_t getDroppedCount() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+    // === Audio thread ===
+    // An event of the current block, at its offset
+    void log(const MidiEvent& event) noexcept;
+
+    // Moves the clock past a processed block (recording or not)
+    void advance(int numSamples) noexcept { clock += numSamples; }
+
+private:
+    struct Entry
+    {
+        int64_t time;
+        uint8_t data[3];
+        uint8_t size;
+    };
+
+    void run();
+    void drain();
+
+    SpscQueue<Entry, Capacity> queue;
+    int64_t clock = 0;                        // Audio thread: start of the current block
+    std::atomic<bool> recording { false };
+    std::atomic<uint64_t> written { 0 };
+    std::atomic<uint64_t> dropped { 0 };
+
+    // Writer thread
+    MidiFileWriter writer;
+    std::thread thread;
+    std::mutex wakeLock;
+    std::condition_variable wake;
+    bool quit = false;                        // Guarded by wakeLock
+
+    MidiEventLogger(const MidiEventLogger&) = delete;
+    MidiEventLogger& operator=(const MidiEventLogger&) = delete;
+};
+
+} // namespace stringfield
@@ -0,0 +1,113 @@
+#include "MidiFileWriter.h"
+#include <cmath>
+
+namespace stringfield
+{
+
+namespace
+{
+    void putBigEndian(uint8_t* dest, uint32_t value, int numBytes)
+    {
+        for (int i = numBytes - 1; i >= 0; --i)
+        {
+            dest[i] = (uint8_t)(value & 0xFF);
+            value >>= 8;
+        }
+    }
+}
+
+bool MidiFileWriter::open(const std::string& path, double sampleRate, double bpm)
+{
+    close();
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (! file.is_open())
+        return false;
+
+    ticksPerSample = ticksPerQuarter * bpm / (60.0 * sampleRate);
+    firstSample = -1;
+    lastTick = 0;
+    runningStatus = 0;
+    numEvents = 0;
+
+    // Header chunk: format 0, one track, ticks per quarter note
+    uint8_t header[14] = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 0 };
+    putBigEndian(header + 12, ticksPerQuarter, 2);
+    file.write((const char*)header, sizeof(header));
+
+    // Track chunk; length patched on close
+    const uint8_t trackHeader[8] = { 'M', 'T', 'r', 'k', 0, 0, 0, 0 };
+    file.write((const char*)trackHeader, sizeof(trackHeader));
+    trackLengthPos = file.tellp() - std::streamoff(4);
+    trackBytes = 0;
+
+    // Tempo meta event at tick 0 (microseconds per quarter note)
+    uint8_t tempo[7] = { 0x00, 0xFF, 0x51, 0x03, 0, 0, 0 };
+    putBigEndian(tempo + 4, (uint32_t)std::lround(60000000.0 / bpm), 3);
+    writeBytes(tempo, sizeof(tempo));
+
+    return file.good();
+}
+
+void MidiFileWriter::write(int64_t sampleTime, const uint8_t* data, int size)
+{
+    if (! file.is_open() || size <= 0 || data[0] < 0x80 || data[0] >= 0xF0)
+        return;
+
+    if (firstSample < 0)
+        firstSample = sampleTime;
+
+    // Ticks from absolute time, so rounding never accumulates
+    int64_t tick = (int64_t)std::llround((double)(sampleTime - firstSample) * ticksPerSample);
+    if (tick < lastTick)
+        tick = lastTick;
+
+    writeVarLen((uint32_t)(tick - lastTick));
+    lastTick = tick;
+
+    if (data[0] == runningStatus)
+        writeBytes(data + 1, size - 1);
+    else
+        writeBytes(data, size);
+
+    runningStatus = data[0];
+    ++numEvents;
+}
+
+bool MidiFileWriter::close()
+{
+    if (! file.is_open())
+        return false;
+
+    const uint8_t endOfTrack[4] = { 0x00, 0xFF, 0x2F, 0x00 };
+    writeBytes(endOfTrack, sizeof(endOfTrack));
+
+    uint8_t length[4];
+    putBigEndian(length, trackBytes, 4);
+    file.seekp(trackLengthPos);
+    file.write((const char*)length, sizeof(length));
+
+    const bool ok = file.good();
+    file.close();
+    return ok;
+}
+
+void MidiFileWriter::writeVarLen(uint32_t value)
+{
+    uint8_t bytes[5];
+    int count = 0;
+
+    bytes[4 - count++] = (uint8_t)(value & 0x7F);
+    while ((value >>= 7) != 0)
+        bytes[4 - count++] = (uint8_t)((value & 0x7F) | 0x80);
+
+    writeBytes(bytes + 5 - count, count);
+}
+
+void MidiFileWriter::writeBytes(const uint8_t* bytes, int count)
+{
+    file.write((const char*)bytes, count);
+    trackBytes += (uint32_t)count;
+}
+
+} // namespace stringfield
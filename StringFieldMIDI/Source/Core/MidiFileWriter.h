@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace stringfield
+{
+
+// Streams a single-track Standard MIDI File (format 0) to disk as events
+// arrive, so arbitrarily long recordings never sit in memory.
+//
+// Event times are in samples and converted to ticks at a fixed tempo; the
+// first event lands at tick 0. Consecutive channel messages with the same
+// status byte use running status. The track length is patched in on close().
+class MidiFileWriter
+{
+public:
+    static constexpr int ticksPerQuarter = 960;
+
+    ~MidiFileWriter() { close(); }
+
+    bool open(const std::string& path, double sampleRate, double bpm = 120.0);
+
+    // Channel voice message (status byte first); times must not go backwards
+    void write(int64_t sampleTime, const uint8_t* data, int size);
+
+    // Ends the track and fixes up its length. False if anything failed to write.
+    bool close();
+
+    bool isOpen() const noexcept { return file.is_open(); }
+    uint64_t getNumEvents() const noexcept { return numEvents; }
+
+private:
+    void writeVarLen(uint32_t value);
+    void writeBytes(const uint8_t* bytes, int count);
+
+    std::ofstream file;
+    std::streampos trackLengthPos;
+    uint32_t trackBytes = 0;
+
+    double ticksPerSample = 0.0;
+    int64_t firstSample = -1;
+    int64_t lastTick = 0;
+    uint8_t runningStatus = 0;
+    uint64_t numEvents = 0;
+};
+
+} // namespace stringfield
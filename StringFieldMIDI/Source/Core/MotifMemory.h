@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+
+namespace stringfield
+{
+
+// How the memory parameter recalls earlier notes and intervals
+enum class MemoryMode
+{
+    Recent,     // Uniformly from the last `memory` notes
+    Decay,      // Recency-weighted over a long horizon
+    Markov      // What followed the same context before
+};
+
+// Long-horizon memory of a value stream in a fixed number of slots.
+//
+// Each new value replaces a random slot with probability Slots / horizon
+// (always while the slots fill), so a slot holds a value that has survived
+// a geometric number of events: a uniform draw then recalls a value of age
+// k with weight about exp(-k / horizon). The horizon can be thousands of
+// events while adding and drawing stay one random number and one lookup.
+// Plain data and trivially copyable, so it snapshots with its owner.
+template <typename T, int Slots>
+class RecencyReservoir
+{
+public:
+    static_assert(Slots > 0 && Slots <= 255, "the count is stored as a byte");
+
+    bool empty() const noexcept { return count == 0; }
+    int size() const noexcept { return count; }
+    void clear() noexcept { count = 0; }
+
+    // Records `value` for a memory of about `horizon` (>= 1) events; `random`
+    // is a uniform 32-bit draw. Horizons below Slots use only that many slots.
+    void add(T value, int horizon, uint32_t random) noexcept
+    {
+        const int used = horizon < Slots ? horizon : Slots;
+        if (count > used)
+            count = (uint8_t)used;
+
+        if (count < used)
+        {
+            values[count++] = value;
+            return;
+        }
+
+        // A slot out of `horizon`; only the first `used` exist
+        const int slot = (int)(((uint64_t)random * (uint32_t)horizon) >> 32);
+        if (slot < used)
+            values[slot] = value;
+    }
+
+    // A remembered value, recency-weighted as above. Not for an empty reservoir.
+    T sample(uint32_t random) const noexcept
+    {
+        return values[((uint64_t)random * count) >> 32];
+    }
+
+private:
+    T values[Slots] {};
+    uint8_t count = 0;
+};
+
+// First-order transitions: for each context, a RecencyReservoir of the values
+// that followed it. Memory is Contexts × Slots whatever the horizon, and a
+// draw is one lookup in the context's row.
+template <typename T, int Contexts, int Slots>
+class TransitionTable
+{
+public:
+    bool empty(int context) const noexcept { return rows[context].empty(); }
+
+    void clear() noexcept
+    {
+        for (auto& row : rows)
+            row.clear();
+    }
+
+    // `horizon` counts the context's own occurrences
+    void add(int context, T value, int horizon, uint32_t random) noexcept
+    {
+        rows[context].add(value, horizon, random);
+    }
+
+    // A value that has followed `context`. Not for an empty context.
+    T sample(int context, uint32_t random) const noexcept { return rows[context].sample(random); }
+
+private:
+    RecencyReservoir<T, Slots> rows[Contexts];
+};
+
+} // namespace stringfield
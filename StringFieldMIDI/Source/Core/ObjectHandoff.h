@@ -0,0 +1,111 @@
+#pragma once
+#include "SpscQueue.h"
+#include <atomic>
+#include <memory>
+
+namespace stringfield
+{
+
+// Hands immutable objects from a producer thread (GUI, state restore) to the
+// audio thread without locks.
+//
+// The producer builds an object and publishes it with one atomic exchange.
+// The audio thread picks up the newest one with another exchange and keeps
+// using it until a newer one arrives; the replaced object goes back through a
+// retire queue and is deleted by collectGarbage(). The audio thread never
+// frees, allocates or waits.
+//
+// publish() may be called from any thread (hosts restore state off the
+// message thread). collectGarbage() pops the single-consumer retire queue,
+// so exactly one thread may call it; in the plugin that is the message
+// thread's timer.
+template <typename T>
+class ObjectHandoff
+{
+public:
+    ObjectHandoff() = default;
+
+    ~ObjectHandoff()
+    {
+        delete incoming.load();
+        delete current;
+        delete previous;
+        collectGarbage();
+    }
+
+    // === Producer threads ===
+
+    void publish(std::unique_ptr<T> object)
+    {
+        // Anything still waiting in the slot was never seen by the consumer
+        delete incoming.exchange(object.release(), std::memory_order_acq_rel);
+    }
+
+    // === Garbage collecting thread (one only) ===
+
+    // Deletes objects the consumer has finished with
+    void collectGarbage()
+    {
+        T* old = nullptr;
+        while (retired.pop(old))
+            delete old;
+    }
+
+    // === Consumer (audio) thread ===
+
+    // Newest published object if one arrived since the last call, else nullptr.
+    // The previous object stays valid until this returns a new one.
+    const T* receive() noexcept
+    {
+        // Only swap when the old object can be handed back for deletion
+        if (current != nullptr && retired.freeSpace() == 0)
+            return nullptr;
+
+        T* next = incoming.exchange(nullptr, std::memory_order_acq_rel);
+        if (next == nullptr)
+            return nullptr;
+
+        if (current != nullptr)
+            retired.push(current);
+
+        current = next;
+        return current;
+    }
+
+    // Like receive(), but the replaced object stays alive until
+    // releasePrevious(), for when the audio thread has passed it on to
+    // another thread that may still be using it. Nothing newer is taken
+    // while one is held.
+    const T* receiveKeepingPrevious() noexcept
+    {
+        if (previous != nullptr || (current != nullptr && retired.freeSpace() < 2))
+            return nullptr;
+
+        T* next = incoming.exchange(nullptr, std::memory_order_acq_rel);
+        if (next == nullptr)
+            return nullptr;
+
+        previous = current;
+        current = next;
+        return current;
+    }
+
+    void releasePrevious() noexcept
+    {
+        if (previous != nullptr && retired.push(previous))
+            previous = nullptr;
+    }
+
+    const T* getCurrent() const noexcept { return current; }
+
+private:
+    std::atomic<T*> incoming { nullptr };
+    T* current = nullptr;                 // Owned by the consumer side
+    T* previous = nullptr;                // Replaced, not yet released (consumer side)
+    SpscQueue<T*, 16> retired;            // Consumer → producer
+
+    ObjectHandoff(const ObjectHandoff&) = delete;
+    ObjectHandoff& operator=(const ObjectHandoff&) = delete;
+};
+
+} // namespace stringfield
@@ -0,0 +1,164 @@
+#include "OutputShaper.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace stringfield
+{
+
+void OutputShaper::prepare(double sampleRate) noexcept
+{
+    samplesPerByte = sampleRate * 10.0 / DinBaudRate;
+    blockStart = 0;
+    blockEnd = 0;
+    wireFreeAt = 0.0;
+    liveChannels = 0;
+    std::fill(std::begin(wantPedal), std::end(wantPedal), false);
+    std::fill(std::begin(sentPedal), std::end(sentPedal), false);
+    deferred.clear();
+}
+
+void OutputShaper::beginBlock(int numSamples, EventSink& port) noexcept
+{
+    blockStart = blockEnd;
+    blockEnd = blockStart + numSamples;
+
+    // Without the limit, anything still queued goes out right away (inside
+    // this block, even what was due after it)
+    while (!deferred.empty() && (!bandwidthLimit || deferred[0].time < blockEnd))
+    {
+        MidiEvent e = deferred[0].event;
+        e.offset = (int)std::min<int64_t>(std::max<int64_t>(0, deferred[0].time - blockStart),
+                                          std::max(0, numSamples - 1));
+        deferred.popFront();
+        port.handleEvent(e);
+    }
+
+    if (!bandwidthLimit)
+        wireFreeAt = (double)blockStart;
+}
+
+void OutputShaper::handleEvent(const MidiEvent& e, EventSink& port) noexcept
+{
+    const int channel = e.getChannel() - 1;
+    const uint16_t bit = (uint16_t)(1u << channel);
+
+    if (e.isController())
+    {
+        switch (e.data[1])
+        {
+            case 64:
+            {
+                const bool down = e.data[2] >= 64;
+                wantPedal[channel] = down;
+
+                // Idle channels pick a pressed pedal up with their next note;
+                // a pedal still held on one is always released
+                if (sentPedal[channel] != down && ((liveChannels & bit) != 0 || sentPedal[channel]))
+                    sendPedal(channel, down, e.offset, port);
+                return;
+            }
+
+            case 123:  // All Notes Off
+                if ((liveChannels & bit) != 0)
+                    send(e, port);
+                return;
+
+            case 120:  // All Sound Off (the generator's last word to a channel)
+                if ((liveChannels & bit) != 0)
+                    send(e, port);
+                liveChannels = (uint16_t)(liveChannels & ~bit);
+                return;
+
+            default:
+                break;
+        }
+    }
+    else if (e.isNoteOn())
+    {
+        if (sentPedal[channel] != wantPedal[channel])
+            sendPedal(channel, wantPedal[channel], e.offset, port);
+        liveChannels = (uint16_t)(liveChannels | bit);
+    }
+
+    send(e, port);
+}
+
+void OutputShaper::sendPedal(int channel, bool down, int offset, EventSink& port) noexcept
+{
+    sentPedal[channel] = down;
+    send(MidiEvent::controller(offset, channel + 1, 64, down ? 127 : 0), port);
+}
+
+bool OutputShaper::isRelease(const MidiEvent& e) noexcept
+{
+    if (e.isNoteOff())
+        return true;
+
+    // Pedal up, All Sound Off, All Notes Off
+    return e.isController() && ((e.data[1] == 64 && e.data[2] < 64) || e.data[1] == 120 || e.data[1] == 123);
+}
+
+bool OutputShaper::dropNewestNonRelease() noexcept
+{
+    for (int i = deferred.size() - 1; i >= 0; --i)
+    {
+        if (!isRelease(deferred[i].event))
+        {
+            deferred.erase(i);
+            ++dropped;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void OutputShaper::send(const MidiEvent& e, EventSink& port) noexcept
+{
+    if (!bandwidthLimit)
+    {
+        port.handleEvent(e);
+        return;
+    }
+
+    // Serialise: a message starts when the port is free and occupies it for
+    // its length in bytes
+    const double start = std::max((double)(blockStart + e.offset), wireFreeAt);
+    wireFreeAt = start + e.size * samplesPerByte;
+
+    const auto time = (int64_t)std::ceil(start);
+    if (time < blockEnd && deferred.empty())
+    {
+        MidiEvent shifted = e;
+        shifted.offset = (int)(time - blockStart);
+        port.handleEvent(shifted);
+        return;
+    }
+
+    // Other events stop at MaxDeferred; a release takes a reserved slot or,
+    // with those gone too, the place of a queued note-on or controller
+    const bool release = isRelease(e);
+    if (!release && deferred.size() >= MaxDeferred)
+    {
+        ++dropped;
+        wireFreeAt -= e.size * samplesPerByte;
+        return;
+    }
+
+    if (deferred.full() && !dropNewestNonRelease())
+    {
+        // Nothing but releases queued: send it now, unpaced, at the end of
+        // the block. It only overtakes other releases (its note-on or pedal
+        // down went out already), so that costs no more than wire timing.
+        wireFreeAt -= e.size * samplesPerByte;
+        MidiEvent late = e;
+        late.offset = (int)std::max<int64_t>(0, blockEnd - 1 - blockStart);
+        port.handleEvent(late);
+        return;
+    }
+
+    deferred.pushBack({ time, e });
+}
+
+} // namespace stringfield
@@ -0,0 +1,78 @@
+#pragma once
+#include "FixedRingBuffer.h"
+#include "MidiEvent.h"
+#include <cstdint>
+
+namespace stringfield
+{
+
+// Output stage between the generator and a MIDI port.
+//
+// The generator addresses the sustain pedal and All Notes Off / All Sound Off
+// to all 16 channels. Here they only reach channels that have played since
+// their last All Sound Off; a channel that joins later gets the current
+// pedal state just before its first note. Pedal changes a channel already
+// has are dropped.
+//
+// Optionally, events are serialised at the rate of a 31250-baud DIN port
+// (10 bits per byte, so about 1 ms per 3-byte message). Events that no
+// longer fit in the block are carried over, in order, into the next ones.
+// Releases (note-offs, pedal up, All Notes Off / All Sound Off) are never
+// dropped: other events may only fill MaxDeferred slots, the rest is kept
+// for releases, and a release that finds the queue full replaces the
+// newest queued note-on or other controller (or, if there is none, goes out
+// unpaced).
+//
+// Offsets are relative to the current block. Never allocates or locks.
+class OutputShaper
+{
+public:
+    static constexpr int MaxDeferred = 512;   // About half a second of DIN traffic
+    static constexpr int ReleaseReserve = 128; // Further slots only releases may take
+    static constexpr double DinBaudRate = 31250.0;
+
+    // Forgets all channel state and pending events
+    void prepare(double sampleRate) noexcept;
+
+    void setBandwidthLimit(bool enabled) noexcept { bandwidthLimit = enabled; }
+    bool hasBandwidthLimit() const noexcept { return bandwidthLimit; }
+
+    // Starts a block: sends the carried-over events that fall inside it
+    void beginBlock(int numSamples, EventSink& port) noexcept;
+
+    // Filters one event (offset within the current block) and sends it
+    void handleEvent(const MidiEvent& event, EventSink& port) noexcept;
+
+    // Note-ons and controllers dropped because the carry-over queue was full
+    uint64_t getNumDropped() const noexcept { return dropped; }
+    int getNumDeferred() const noexcept { return deferred.size(); }
+
+private:
+    struct Deferred
+    {
+        int64_t time = 0;
+        MidiEvent event;
+    };
+
+    static bool isRelease(const MidiEvent& event) noexcept;
+    bool dropNewestNonRelease() noexcept;
+    void send(const MidiEvent& event, EventSink& port) noexcept;
+    void sendPedal(int channel, bool down, int offset, EventSink& port) noexcept;
+
+    double samplesPerByte = 44100.0 * 10.0 / DinBaudRate;
+    bool bandwidthLimit = false;
+
+    // Shaper-local clock (samples since prepare)
+    int64_t blockStart = 0;
+    int64_t blockEnd = 0;
+    double wireFreeAt = 0.0;          // When the DIN port finishes the last message
+
+    uint16_t liveChannels = 0;        // Bit ch-1: played since its last All Sound Off
+    bool wantPedal[16] {};            // Pedal state the generator asked for
+    bool sentPedal[16] {};            // Pedal state the channel has
+
+    FixedRingBuffer<Deferred, MaxDeferred + ReleaseReserve> deferred;
+    uint64_t dropped = 0;
+};
+
+} // namespace stringfield
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+namespace stringfield
+{
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+// A keyed bijection from a 128-bit counter to 128 random bits: any block can
+// be computed directly from its counter, with no state to replay.
+struct Philox4x32
+{
+    static constexpr uint32_t M0 = 0xD2511F53u;
+    static constexpr uint32_t M1 = 0xCD9E8D57u;
+    static constexpr uint32_t W0 = 0x9E3779B9u;   // Key schedule (golden ratio)
+    static constexpr uint32_t W1 = 0xBB67AE85u;   // sqrt(3) - 1
+    static constexpr int rounds = 10;
+
+    static void generate(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]) noexcept
+    {
+        uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+        uint32_t k0 = key[0], k1 = key[1];
+
+        for (int r = 0; r < rounds; ++r)
+        {
+            const uint64_t p0 = (uint64_t)M0 * c0;
+            const uint64_t p1 = (uint64_t)M1 * c2;
+
+            const uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+            const uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+            c1 = (uint32_t)p1;
+            c3 = (uint32_t)p0;
+            c0 = n0;
+            c2 = n2;
+
+            k0 += W0;
+            k1 += W1;
+        }
+
+        out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+    }
+};
+
+} // namespace stringfield
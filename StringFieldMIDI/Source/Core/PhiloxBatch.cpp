@@ -0,0 +1,281 @@
+#include "PhiloxBatch.h"
+#include "Philox.h"
+
+// SSE2 is part of x86-64, AVX2 is compiled per function and only called
+// after the CPU check, so the library itself needs no extra compiler flags
+#if defined(__x86_64__) || defined(_M_X64)
+ #define STRINGFIELD_PHILOX_SIMD 1
+ #include <immintrin.h>
+ #if defined(_MSC_VER) && !defined(__clang__)
+  #include <intrin.h>
+  #define STRINGFIELD_TARGET_AVX2
+ #else
+  #define STRINGFIELD_TARGET_AVX2 __attribute__((target("avx2")))
+ #endif
+#else
+ #define STRINGFIELD_PHILOX_SIMD 0
+#endif
+
+namespace stringfield
+{
+
+namespace
+{
+    void generateScalar(const uint32_t* const counter[4], const uint32_t* const key[2],
+                        uint32_t* const out[4], int first, int count) noexcept
+    {
+        for (int i = first; i < count; ++i)
+        {
+            const uint32_t c[4] = { counter[0][i], counter[1][i], counter[2][i], counter[3][i] };
+            const uint32_t k[2] = { key[0][i], key[1][i] };
+            uint32_t block[4];
+
+            Philox4x32::generate(c, k, block);
+
+            out[0][i] = block[0];
+            out[1][i] = block[1];
+            out[2][i] = block[2];
+            out[3][i] = block[3];
+        }
+    }
+
+   #if STRINGFIELD_PHILOX_SIMD
+    bool cpuHasAvx2() noexcept
+    {
+       #if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        // The OS must save the YMM registers too
+        __cpuid(info, 1);
+        const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+
+        __cpuidex(info, 7, 0);
+        return osSavesYmm && (info[1] & (1 << 5)) != 0;
+       #else
+        return __builtin_cpu_supports("avx2") != 0;
+       #endif
+    }
+
+    // Full 32×32 → 64-bit products of every lane. _mm_mul_epu32 only
+    // multiplies the even lanes, so the odd ones are shifted down for a
+    // second multiply and both halves are interleaved back.
+    inline void mulHiLo(__m128i a, __m128i m, __m128i& hi, __m128i& lo) noexcept
+    {
+        const __m128i lowWords = _mm_set_epi32(0, -1, 0, -1);
+        const __m128i even = _mm_mul_epu32(a, m);
+        const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), m);
+
+        hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(lowWords, odd));
+        lo = _mm_or_si128(_mm_and_si128(even, lowWords), _mm_slli_epi64(odd, 32));
+    }
+
+    // Counters and keys of four items, one lane each
+    struct Sse2Block
+    {
+        __m128i c0, c1, c2, c3, k0, k1;
+
+        void load(const uint32_t* const counter[4], const uint32_t* const key[2], int i) noexcept
+        {
+            c0 = _mm_loadu_si128((const __m128i*)(counter[0] + i));
+            c1 = _mm_loadu_si128((const __m128i*)(counter[1] + i));
+            c2 = _mm_loadu_si128((const __m128i*)(counter[2] + i));
+            c3 = _mm_loadu_si128((const __m128i*)(counter[3] + i));
+            k0 = _mm_loadu_si128((const __m128i*)(key[0] + i));
+            k1 = _mm_loadu_si128((const __m128i*)(key[1] + i));
+        }
+
+        void round() noexcept
+        {
+            __m128i hi0, lo0, hi1, lo1;
+            mulHiLo(c0, _mm_set1_epi32((int)Philox4x32::M0), hi0, lo0);
+            mulHiLo(c2, _mm_set1_epi32((int)Philox4x32::M1), hi1, lo1);
+
+            c0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), k0);
+            c2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), k1);
+            c1 = lo1;
+            c3 = lo0;
+
+            k0 = _mm_add_epi32(k0, _mm_set1_epi32((int)Philox4x32::W0));
+            k1 = _mm_add_epi32(k1, _mm_set1_epi32((int)Philox4x32::W1));
+        }
+
+        void store(uint32_t* const out[4], int i) const noexcept
+        {
+            _mm_storeu_si128((__m128i*)(out[0] + i), c0);
+            _mm_storeu_si128((__m128i*)(out[1] + i), c1);
+            _mm_storeu_si128((__m128i*)(out[2] + i), c2);
+            _mm_storeu_si128((__m128i*)(out[3] + i), c3);
+        }
+    };
+
+    // Two vectors per step: one block's rounds are a chain of dependent
+    // multiplies, so a second independent chain keeps the multipliers busy
+    int generateSse2(const uint32_t* const counter[4], const uint32_t* const key[2],
+                     uint32_t* const out[4], int count) noexcept
+    {
+        int i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            Sse2Block a, b;
+            a.load(counter, key, i);
+            b.load(counter, key, i + 4);
+
+            for (int r = 0; r < Philox4x32::rounds; ++r)
+            {
+                a.round();
+                b.round();
+            }
+
+            a.store(out, i);
+            b.store(out, i + 4);
+        }
+
+        for (; i + 4 <= count; i += 4)
+        {
+            Sse2Block a;
+            a.load(counter, key, i);
+            for (int r = 0; r < Philox4x32::rounds; ++r)
+                a.round();
+            a.store(out, i);
+        }
+
+        return i;
+    }
+
+    STRINGFIELD_TARGET_AVX2
+    inline void mulHiLo(__m256i a, __m256i m, __m256i& hi, __m256i& lo) noexcept
+    {
+        const __m256i lowWords = _mm256_set_epi32(0, -1, 0, -1, 0, -1, 0, -1);
+        const __m256i even = _mm256_mul_epu32(a, m);
+        const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+
+        hi = _mm256_or_si256(_mm256_srli_epi64(even, 32), _mm256_andnot_si256(lowWords, odd));
+        lo = _mm256_or_si256(_mm256_and_si256(even, lowWords), _mm256_slli_epi64(odd, 32));
+    }
+
+    struct Avx2Block
+    {
+        __m256i c0, c1, c2, c3, k0, k1;
+
+        STRINGFIELD_TARGET_AVX2
+        void load(const uint32_t* const counter[4], const uint32_t* const key[2], int i) noexcept
+        {
+            c0 = _mm256_loadu_si256((const __m256i*)(counter[0] + i));
+            c1 = _mm256_loadu_si256((const __m256i*)(counter[1] + i));
+            c2 = _mm256_loadu_si256((const __m256i*)(counter[2] + i));
+            c3 = _mm256_loadu_si256((const __m256i*)(counter[3] + i));
+            k0 = _mm256_loadu_si256((const __m256i*)(key[0] + i));
+            k1 = _mm256_loadu_si256((const __m256i*)(key[1] + i));
+        }
+
+        STRINGFIELD_TARGET_AVX2
+        void round() noexcept
+        {
+            __m256i hi0, lo0, hi1, lo1;
+            mulHiLo(c0, _mm256_set1_epi32((int)Philox4x32::M0), hi0, lo0);
+            mulHiLo(c2, _mm256_set1_epi32((int)Philox4x32::M1), hi1, lo1);
+
+            c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), k0);
+            c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), k1);
+            c1 = lo1;
+            c3 = lo0;
+
+            k0 = _mm256_add_epi32(k0, _mm256_set1_epi32((int)Philox4x32::W0));
+            k1 = _mm256_add_epi32(k1, _mm256_set1_epi32((int)Philox4x32::W1));
+        }
+
+        STRINGFIELD_TARGET_AVX2
+        void store(uint32_t* const out[4], int i) const noexcept
+        {
+            _mm256_storeu_si256((__m256i*)(out[0] + i), c0);
+            _mm256_storeu_si256((__m256i*)(out[1] + i), c1);
+            _mm256_storeu_si256((__m256i*)(out[2] + i), c2);
+            _mm256_storeu_si256((__m256i*)(out[3] + i), c3);
+        }
+    };
+
+    STRINGFIELD_TARGET_AVX2
+    int generateAvx2(const uint32_t* const counter[4], const uint32_t* const key[2],
+                     uint32_t* const out[4], int count) noexcept
+    {
+        int i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            Avx2Block a, b;
+            a.load(counter, key, i);
+            b.load(counter, key, i + 8);
+
+            for (int r = 0; r < Philox4x32::rounds; ++r)
+            {
+                a.round();
+                b.round();
+            }
+
+            a.store(out, i);
+            b.store(out, i + 8);
+        }
+
+        for (; i + 8 <= count; i += 8)
+        {
+            Avx2Block a;
+            a.load(counter, key, i);
+            for (int r = 0; r < Philox4x32::rounds; ++r)
+                a.round();
+            a.store(out, i);
+        }
+
+        return i;
+    }
+   #endif
+}
+
+PhiloxBatch::Isa PhiloxBatch::getIsa() noexcept
+{
+   #if STRINGFIELD_PHILOX_SIMD
+    static const Isa best = cpuHasAvx2() ? Isa::Avx2 : Isa::Sse2;
+    return best;
+   #else
+    return Isa::Scalar;
+   #endif
+}
+
+const char* PhiloxBatch::getIsaName(Isa isa) noexcept
+{
+    switch (isa)
+    {
+        case Isa::Avx2:   return "avx2";
+        case Isa::Sse2:   return "sse2";
+        case Isa::Scalar:
+        default:          return "scalar";
+    }
+}
+
+void PhiloxBatch::generate(const uint32_t* const counter[4], const uint32_t* const key[2],
+                           uint32_t* const out[4], int count) noexcept
+{
+    generate(counter, key, out, count, getIsa());
+}
+
+void PhiloxBatch::generate(const uint32_t* const counter[4], const uint32_t* const key[2],
+                           uint32_t* const out[4], int count, Isa isa) noexcept
+{
+    if ((int)isa > (int)getIsa())
+        isa = getIsa();
+
+    int done = 0;
+
+   #if STRINGFIELD_PHILOX_SIMD
+    if (isa == Isa::Avx2)
+        done = generateAvx2(counter, key, out, count);
+    else if (isa == Isa::Sse2)
+        done = generateSse2(counter, key, out, count);
+   #endif
+
+    // The items that don't fill a vector
+    generateScalar(counter, key, out, done, count);
+}
+
+} // namespace stringfield
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+
+namespace stringfield
+{
+
+// Philox4x32-10 over many independent (counter, key) pairs at once, for
+// offline generation. Inputs and outputs are structure-of-arrays: word w of
+// item i is counter[w][i], key[w][i], out[w][i].
+//
+// Every result is bit-identical to Philox4x32::generate for the same item.
+// The widest instruction set the CPU supports is picked at runtime (AVX2:
+// 8 items per step, SSE2: 4), with the portable scalar code elsewhere.
+struct PhiloxBatch
+{
+    enum class Isa
+    {
+        Scalar = 0,
+        Sse2,
+        Avx2
+    };
+
+    // Best instruction set of this CPU (detected once)
+    static Isa getIsa() noexcept;
+    static const char* getIsaName(Isa isa) noexcept;
+
+    // Blocks for `count` items. `isa` may only narrow the choice (e.g. to
+    // compare against the scalar path); anything above getIsa() is lowered.
+    static void generate(const uint32_t* const counter[4], const uint32_t* const key[2],
+                         uint32_t* const out[4], int count) noexcept;
+    static void generate(const uint32_t* const counter[4], const uint32_t* const key[2],
+                         uint32_t* const out[4], int count, Isa isa) noexcept;
+};
+
+} // namespace stringfield
@@ -0,0 +1,40 @@
+#include "PitchClassSet.h"
+#include <algorithm>
+
+namespace stringfield
+{
+
+std::unique_ptr<CompiledPitchClassSet> CompiledPitchClassSet::compile(const std::string& text)
+{
+    auto set = std::make_unique<CompiledPitchClassSet>();
+    set->source = text;
+
+    for (char ch : text)
+    {
+        int pc = -1;
+
+        if (ch >= '0' && ch <= '9')
+            pc = ch - '0';
+        else if (ch == 'A' || ch == 'a')
+            pc = 10;
+        else if (ch == 'B' || ch == 'b')
+            pc = 11;
+
+        if (pc < 0)
+            continue;
+
+        auto* end = set->pitchClasses + set->numPitchClasses;
+        if (std::find(set->pitchClasses, end, pc) == end)
+            set->pitchClasses[set->numPitchClasses++] = pc;
+    }
+
+    for (int note = 0; note <= 127; ++note)
+    {
+        const int pc = note % 12;
+        set->notesForPC[pc][set->numNotesForPC[pc]++] = (uint8_t)note;
+    }
+
+    return set;
+}
+
+} // namespace stringfield
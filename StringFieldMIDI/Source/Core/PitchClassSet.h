@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace stringfield
+{
+
+// A pitch-class set parsed and tabulated ahead of time, so the audio thread
+// never touches strings. Immutable once compiled; share it read-only.
+struct CompiledPitchClassSet
+{
+    // Parses pitch-class notation: 0-9, A=10, B=11. Other characters are
+    // ignored, duplicates dropped. An empty set disables PC mode.
+    static std::unique_ptr<CompiledPitchClassSet> compile(const std::string& text);
+
+    std::string source;                // Text as typed
+
+    int pitchClasses[12] {};           // In order of first appearance
+    int numPitchClasses = 0;
+
+    // Every MIDI note (0-127) of each pitch class, ascending. Covers all 12
+    // classes because Tn/TnI transforms can land anywhere.
+    uint8_t notesForPC[12][11] {};
+    uint8_t numNotesForPC[12] {};
+};
+
+} // namespace stringfield
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace stringfield
+{
+
+// Wait-free single-producer/single-consumer ring of trivially copyable items.
+// One thread may push, one other thread may pop; neither ever blocks or
+// allocates. Capacity must be a power of two.
+template <typename T, int Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "Items are copied with plain assignment");
+
+public:
+    static constexpr int capacity() noexcept { return Capacity; }
+
+    // Producer: false (item dropped) when the queue is full
+    bool push(const T& item) noexcept
+    {
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == (uint32_t)Capacity)
+            return false;
+
+        items[t & (Capacity - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: false when the queue is empty
+    bool pop(T& item) noexcept
+    {
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+
+        item = items[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Exact for the producer's free space and the consumer's item count;
+    // approximate from any other thread.
+    int size() const noexcept
+    {
+        return (int)(tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire));
+    }
+
+    int freeSpace() const noexcept { return Capacity - size(); }
+
+private:
+    alignas(64) std::atomic<uint32_t> head { 0 };
+    alignas(64) std::atomic<uint32_t> tail { 0 };
+    alignas(64) T items[Capacity];
+};
+
+} // namespace stringfield
@@ -0,0 +1,931 @@
+#include "StringFieldEngine.h"
+#include <algorithm>
+#include <cmath>
+
+namespace stringfield
+{
+
+namespace
+{
+    // Same arithmetic as juce::jmap / juce::jlimit, so results match the plugin
+    template <typename T>
+    T mapRange(T value, T sourceMin, T sourceMax, T targetMin, T targetMax)
+    {
+        return targetMin + (targetMax - targetMin) * (value - sourceMin) / (sourceMax - sourceMin);
+    }
+
+    template <typename T>
+    T limit(T lowerLimit, T upperLimit, T value)
+    {
+        return value < lowerLimit ? lowerLimit : (upperLimit < value ? upperLimit : value);
+    }
+
+    // Synced pulse grid in quarter notes, by EngineParams::sync (0 = free-running)
+    constexpr double syncGridBeats[] = { 0.0, 2.0, 1.0, 0.5, 1.0 / 3.0, 0.25, 1.0 / 6.0 };
+    constexpr int maxSync = 6;
+
+    // Decay/Markov horizon in notes by Memory: doubles every two steps, 32 at 2 to 4096 at 16
+    constexpr int memoryHorizons[] = { 0, 23, 32, 45, 64, 91, 128, 181, 256, 362, 512, 724,
+                                       1024, 1448, 2048, 2896, 4096 };
+
+    // Transition rows see about one note in this many (a typical register
+    // spread), so they keep their own visits for horizon / contextShare
+    constexpr int contextShare = 16;
+
+    // Order-2 context: the last two notes hashed onto 128 rows
+    int hashNotePair(int older, int newer)
+    {
+        return (int)(((uint32_t)(older * 128 + newer) * 0x9E3779B1u) >> 25);
+    }
+
+    // Markov rhythm context: the interval against the base in eighths, 0 to 2
+    int intervalBucket(double intervalSec, double baseInterval)
+    {
+        return limit(0, 15, (int)(intervalSec / baseInterval * 8.0));
+    }
+}
+
+StringFieldEngine::StringFieldEngine()
+{
+    setSeed(1);
+    std::fill(std::begin(pcToMidiMap), std::end(pcToMidiMap), -1);
+    buildPitchTable();
+    buildRouteTable();
+}
+
+void StringFieldEngine::prepare(double sampleRate)
+{
+    sr = sampleRate;
+    queue.clear();
+    notesScheduled = false;
+    pedalScheduled = false;
+    pulseSlot = NoPulseSlot;
+    pulseQueued = false;
+    voices.clear();
+}
+
+void StringFieldEngine::setParameters(const EngineParams& newParams, int64_t now, EventSink& sink)
+{
+    // === Seed Handling ===
+    if (newParams.seed != lastSeed)
+    {
+        setSeed(newParams.seed);
+
+        // Restart the note scheduler from the next rendered block
+        queue.removeIf([](const ScheduledEvent& e) { return e.type == ScheduledType::NoteOn; });
+        notesScheduled = false;
+
+        // A cancelled synced onset is drawn again for the same slot
+        if (pulseQueued)
+            --pulseSlot;
+        pulseQueued = false;
+    }
+
+    // === Sustain Pedal Parameter Change ===
+    if (newParams.pedal != lastPedalParamState)
+    {
+        // When disabling pedal: immediately release on all channels
+        if (!newParams.pedal && lastPedalParamState)
+        {
+            for (int ch = 1; ch <= 16; ++ch)
+                sink.handleEvent(MidiEvent::controller(0, ch, 64, 0));
+            pedalDown = false;
+            queue.removeIf([](const ScheduledEvent& e) { return e.type == ScheduledType::PedalToggle; });
+            pedalScheduled = false;
+        }
+        // When enabling pedal: let the algorithm schedule it (judicious application)
+        // No immediate action needed - render will handle it
+
+        lastPedalParamState = newParams.pedal;
+    }
+
+    // === Pulse Grid Changes ===
+    const bool gridChanged = newParams.sync != params.sync;
+    const bool freeTempoChanged = !hostTempo && newParams.tempo != params.tempo;
+
+    const bool rangeChanged = newParams.center != params.center || newParams.spread != params.spread;
+    const bool routingChanged = newParams.routes != params.routes
+                                || newParams.articulation != params.articulation
+                                || newParams.energy != params.energy;
+
+    params = newParams;
+    voices.setSize(params.voices);
+
+    if (rangeChanged)
+        buildPitchTable();
+    if (routingChanged)
+        buildRouteTable();
+
+    if (gridChanged)
+    {
+        // Slots of another grid don't count: a running scheduler continues
+        // after the current position, an idle one starts on the next slot
+        pulseSlot = params.sync > 0 && notesScheduled
+                        ? (int64_t)std::floor(timeToPpq(now) / syncGridBeats[limit(1, maxSync, params.sync)])
+                        : NoPulseSlot;
+    }
+    else if (freeTempoChanged)
+    {
+        retimeSyncedPulse(now);
+    }
+}
+
+void StringFieldEngine::setTransport(const TransportPosition& position)
+{
+    const double spb = 60.0 / std::max(1.0, position.bpm) * sr;
+
+    // While the host agrees with the current map, keep it: steady playback,
+    // fastForward() and checkpoints then put onsets on identical samples
+    if (hostTempo && std::abs(spb - samplesPerBeat) <= 1e-9 * spb
+        && std::abs(timeToPpq(position.time) - position.ppq) <= 1e-6)
+        return;
+
+    hostTempo = true;
+    anchorTime = position.time;
+    anchorPpq = position.ppq;
+    samplesPerBeat = spb;
+
+    // The queued onset keeps its grid position and moves with the tempo
+    retimeSyncedPulse(position.time);
+}
+
+double StringFieldEngine::getSamplesPerBeat() const
+{
+    return hostTempo ? samplesPerBeat : 60.0 / std::max(40.0f, params.tempo) * sr;
+}
+
+double StringFieldEngine::timeToPpq(int64_t time) const
+{
+    return anchorPpq + (double)(time - anchorTime) / getSamplesPerBeat();
+}
+
+int64_t StringFieldEngine::ppqToTime(double ppq) const
+{
+    return anchorTime + (int64_t)std::llround((ppq - anchorPpq) * getSamplesPerBeat());
+}
+
+void StringFieldEngine::setSeed(int seed)
+{
+    const auto key = (uint32_t)seed;
+    pitchRng.setKey(key, RandomStream::Pitch);
+    rhythmRng.setKey(key, RandomStream::Rhythm);
+    velocityRng.setKey(key, RandomStream::Velocity);
+    articulationRng.setKey(key, RandomStream::Articulation);
+    pedalRng.setKey(key, RandomStream::Pedal);
+
+    lastSeed = seed;
+    noteIndex = 0;
+    pedalIndex = 0;
+}
+
+void StringFieldEngine::stop(EventSink& sink)
+{
+    // Release sustain pedal on all channels
+    for (int ch = 1; ch <= 16; ++ch)
+    {
+        sink.handleEvent(MidiEvent::controller(0, ch, 64, 0));  // Pedal up
+        sink.handleEvent(MidiEvent::controller(0, ch, 123, 0)); // All Notes Off
+        sink.handleEvent(MidiEvent::controller(0, ch, 120, 0)); // All Sound Off
+    }
+    queue.clear();
+    notesScheduled = false;
+    pedalScheduled = false;
+    pulseSlot = NoPulseSlot;
+    pulseQueued = false;
+    voices.clear();
+    pedalDown = false;
+}
+
+void StringFieldEngine::fastForward(int64_t from, int64_t to)
+{
+    struct DiscardSink : EventSink
+    {
+        void handleEvent(const MidiEvent&) override {}
+    } discard;
+
+    // Same path as playback, so the state matches having played [from, to)
+    while (from < to)
+    {
+        const int numSamples = (int)std::min<int64_t>(to - from, 1 << 30);
+        render(from, numSamples, discard);
+        from += numSamples;
+    }
+}
+
+void StringFieldEngine::sendControllerState(EventSink& sink)
+{
+    if (!pedalDown)
+        return;
+
+    for (int ch = 1; ch <= 16; ++ch)
+        sink.handleEvent(MidiEvent::controller(0, ch, 64, 127));
+}
+
+void StringFieldEngine::setWeightProfile(const CompiledWeightProfile* profile)
+{
+    weights = profile;
+    buildPitchTable();
+    buildRouteTable();
+}
+
+void StringFieldEngine::buildPitchTable()
+{
+    int lo = limit(0, 127, params.center - params.spread);
+    int hi = limit(0, 127, params.center + params.spread);
+
+    float noteWeights[128];
+    for (int note = lo; note <= hi; ++note)
+        noteWeights[note - lo] = weights != nullptr && !weights->flatPitch ? weights->pitch[note % 12] : 1.0f;
+
+    pitchTable.build(noteWeights, hi - lo + 1);
+    pitchTableLow = lo;
+}
+
+void StringFieldEngine::buildRouteTable()
+{
+    // Exact distribution of the triangular articulation draw:
+    //   channel = round(center + (r1 + r2) * spreadWidth), clamped
+    // with r1 + r2 triangular on (-1, 1)
+    // articulation (0.0-1.0): center of distribution
+    //   0.0 = favor channel 1 (legato, sustained)
+    //   0.5 = favor middle channels
+    //   1.0 = favor channel numRoutes (staccato, extreme)
+    // energy: controls spread width
+    //   Low energy (0.0): ±0.5 channel (very focused)
+    //   High energy (1.0): ±(numRoutes-1) (full exploration)
+    const int numRoutes = limit(1, 16, params.routes);
+    if (numRoutes <= 1)
+    {
+        routeTable.build(nullptr, 1);
+        return;
+    }
+
+    const double centerChannel = (double)(params.articulation * (float)(numRoutes - 1));
+    const double spreadWidth = (double)mapRange(params.energy, 0.0f, 1.0f, 0.5f, (float)(numRoutes - 1));
+
+    auto triangularCdf = [](double x)
+    {
+        if (x <= -1.0) return 0.0;
+        if (x < 0.0)   return 0.5 * (1.0 + x) * (1.0 + x);
+        if (x < 1.0)   return 1.0 - 0.5 * (1.0 - x) * (1.0 - x);
+        return 1.0;
+    };
+
+    float routeWeights[16];
+    float shaped[16];
+    for (int i = 0; i < numRoutes; ++i)
+    {
+        const double lower = i == 0 ? 0.0 : triangularCdf((i - 0.5 - centerChannel) / spreadWidth);
+        const double upper = i == numRoutes - 1 ? 1.0 : triangularCdf((i + 0.5 - centerChannel) / spreadWidth);
+        routeWeights[i] = (float)(upper - lower);
+        shaped[i] = weights != nullptr && !weights->flatRoutes ? routeWeights[i] * weights->routes[i] : 0.0f;
+    }
+
+    // User weights scale the shape; if they silence every reachable route, keep the shape
+    const bool useShaped = std::any_of(shaped, shaped + numRoutes, [](float w) { return w > 0.0f; });
+    routeTable.build(useShaped ? shaped : routeWeights, numRoutes);
+}
+
+int StringFieldEngine::pickNote(int center, int spread)
+{
+    if (spread <= 0)
+        return limit(0, 127, center);
+
+    // === PITCH-CLASS SET MODE ===
+    if (params.pcMode > 0 && numPitchClasses > 0)
+    {
+        // Check if set is exhausted
+        if (numRemainingPCs == 0)
+            transformPitchClassSet();  // Transform and reset
+
+        if (numRemainingPCs == 0)  // Fallback if still empty
+            return limit(0, 127, center);
+
+        // Pick next pitch class from remaining set
+        int pitchClass = remainingPCs[--numRemainingPCs];
+
+        // Map to MIDI note with octave memory
+        return mapPCToMIDI(pitchClass, center, spread);
+    }
+
+    // === CHROMATIC MODE ===
+    // (range and pitch weights are compiled into pitchTable)
+    int memorySize = std::min(params.memory, MaxMemory);
+
+    // Long-horizon memory (Decay, Markov)
+    if (memorySize > 0 && params.memoryMode != (int)MemoryMode::Recent)
+        return pickRememberedNote(memoryHorizons[memorySize]);
+
+    // MOTIVIC MEMORY MODE: Higher memory = more repetition of recent notes
+    // Scale memory strength by energy
+    // Low energy = strong repetition (motivic loops)
+    // High energy = weaker repetition (more exploration)
+    float memoryStrength = mapRange(params.energy, 0.0f, 1.0f, 1.0f, 0.3f);
+
+    // No memory: use simple random
+    if (memorySize <= 0 || recentNotes.empty())
+    {
+        int note = pitchTableLow + pitchTable.sample(pitchRng.nextUInt32());
+
+        // Store in memory for future
+        if (memorySize > 0)
+        {
+            recentNotes.pushBack(note);
+            if ((int)recentNotes.size() > memorySize)
+                recentNotes.popFront();
+        }
+
+        return note;
+    }
+
+    // With memory: FAVOR repeating recent notes (strength scaled by energy)
+    // Probability to repeat from memory vs pick something new
+    float repeatProbability = memoryStrength * 0.8f;  // 80% at low energy, 24% at high energy
+
+    int note;
+    if (pitchRng.nextFloat() < repeatProbability && !recentNotes.empty())
+    {
+        // Pick randomly from recent notes (motivic repetition)
+        int memoryIndex = pitchRng.nextInt(0, (int)recentNotes.size());
+        note = recentNotes[memoryIndex];
+    }
+    else
+    {
+        // Pick from full range (exploration)
+        note = pitchTableLow + pitchTable.sample(pitchRng.nextUInt32());
+    }
+
+    // Update memory
+    recentNotes.pushBack(note);
+    if ((int)recentNotes.size() > memorySize)
+        recentNotes.popFront();
+
+    return note;
+}
+
+int StringFieldEngine::pickRememberedNote(int horizon)
+{
+    // Same repeat odds as the recent-notes memory (strength scaled by energy)
+    const float repeatProbability = mapRange(params.energy, 0.0f, 1.0f, 1.0f, 0.3f) * 0.8f;
+    const bool markov = params.memoryMode == (int)MemoryMode::Markov;
+    const int pair = previousNotes[1] >= 0 ? hashNotePair(previousNotes[1], previousNotes[0]) : -1;
+
+    int note = -1;
+    if (pitchRng.nextFloat() < repeatProbability)
+    {
+        if (! markov)
+        {
+            if (! decayNotes.empty())
+                note = decayNotes.sample(pitchRng.nextUInt32());
+        }
+        else if (pair >= 0 && ! notePairTransitions.empty(pair))
+        {
+            // Continue a phrase heard before, else what followed the last note
+            note = notePairTransitions.sample(pair, pitchRng.nextUInt32());
+        }
+        else if (previousNotes[0] >= 0 && ! noteTransitions.empty(previousNotes[0]))
+        {
+            note = noteTransitions.sample(previousNotes[0], pitchRng.nextUInt32());
+        }
+    }
+
+    // Nothing to recall: pick from full range (exploration)
+    if (note < 0)
+        note = pitchTableLow + pitchTable.sample(pitchRng.nextUInt32());
+
+    // Update memory
+    if (! markov)
+    {
+        decayNotes.add((uint8_t)note, horizon, pitchRng.nextUInt32());
+    }
+    else
+    {
+        const int rowHorizon = std::max(1, horizon / contextShare);
+        if (previousNotes[0] >= 0)
+            noteTransitions.add(previousNotes[0], (uint8_t)note, rowHorizon, pitchRng.nextUInt32());
+        if (pair >= 0)
+            notePairTransitions.add(pair, (uint8_t)note, rowHorizon, pitchRng.nextUInt32());
+    }
+
+    previousNotes[1] = previousNotes[0];
+    previousNotes[0] = note;
+    return note;
+}
+
+double StringFieldEngine::pickRememberedInterval(double baseInterval, int horizon)
+{
+    // Same repeat odds as the recent-intervals memory; the rhythm horizon is
+    // half the pitch horizon, as in Recent mode (Markov rows: about eight
+    // buckets in use, each kept for horizon / contextShare visits)
+    const float energy = params.energy;
+    const float repeatProbability = mapRange(energy, 0.0f, 1.0f, 1.0f, 0.3f) * 0.75f;
+    const bool markov = params.memoryMode == (int)MemoryMode::Markov;
+
+    double intervalSec = 0.0;
+    bool recalled = false;
+    if (rhythmRng.nextFloat() < repeatProbability)
+    {
+        if (! markov && ! decayIntervals.empty())
+        {
+            intervalSec = decayIntervals.sample(rhythmRng.nextUInt32());
+            recalled = true;
+        }
+        else if (markov && previousIntervalBucket >= 0 && ! intervalTransitions.empty(previousIntervalBucket))
+        {
+            intervalSec = intervalTransitions.sample(previousIntervalBucket, rhythmRng.nextUInt32());
+            recalled = true;
+        }
+    }
+
+    if (recalled)
+    {
+        // Add slight variation (±10%) to avoid mechanical feel
+        double variation = (rhythmRng.nextDouble() - 0.5) * 0.2 * intervalSec;
+        intervalSec = std::max(0.001, intervalSec + variation);
+    }
+    else
+    {
+        double jitter = (rhythmRng.nextDouble() - 0.5) * (energy * baseInterval);
+        intervalSec = std::max(0.001, baseInterval + jitter);
+    }
+
+    // Update rhythm memory
+    if (! markov)
+        decayIntervals.add((float)intervalSec, std::max(1, horizon / 2), rhythmRng.nextUInt32());
+    else if (previousIntervalBucket >= 0)
+        intervalTransitions.add(previousIntervalBucket, (float)intervalSec,
+                                std::max(1, horizon / contextShare), rhythmRng.nextUInt32());
+
+    previousIntervalBucket = intervalBucket(intervalSec, baseInterval);
+    return intervalSec;
+}
+
+int StringFieldEngine::pickVelocity(int baseVel)
+{
+    int variation = velocityRng.nextInt(-10, 11);
+    return limit(1, 127, baseVel + variation);
+}
+
+int StringFieldEngine::pickArticulation(int numRoutes)
+{
+    // Triangular around Articulation, width from Energy, times the user route
+    // weights: compiled into routeTable, so one draw per note
+    if (numRoutes <= 1)
+        return 1;
+
+    return 1 + routeTable.sample(articulationRng.nextUInt32());
+}
+
+double StringFieldEngine::calculateDuration(float energy)
+{
+    // Low energy -> long notes (Feldman-ish)
+    double durationSec = mapRange((double)energy, 0.0, 1.0, 1.2, 0.08);
+    return durationSec * sr;
+}
+
+bool StringFieldEngine::isPedalEngaged(float energy, float density)
+{
+    // Engagement probability: low energy and high density want the pedal
+    return (1.0f - energy) * density >= 0.15f;
+}
+
+double StringFieldEngine::drawPedalWait(CounterRandom& rng, float energy, float density, bool pedalDown)
+{
+    // AUTOMATIC SUSTAIN PEDAL (Energy/Density controlled)
+    // Low energy + low density = pedal stays DOWN for long periods (creates chords/washes)
+    // High energy + high density = pedal rarely used (clean articulation)
+
+    // Decide whether to use pedal at all
+    if (!isPedalEngaged(energy, density) && !pedalDown)
+    {
+        // Very low engagement - the pedal stays up; look again in 5 seconds.
+        // (A held pedal is lifted after its usual hold time, below.)
+        return 5.0;
+    }
+
+    if (pedalDown)
+    {
+        // Pedal is down - schedule when to lift it
+        // Low energy = long pedal down (many notes blend together)
+        // High energy = short pedal down (minimal blending)
+        double pedalDownDurationSec = mapRange((double)energy,
+                                               0.0, 1.0,
+                                               8.0, 0.5);  // 8 seconds to 0.5 seconds
+
+        // Add some randomness (±30%)
+        double variation = (rng.nextDouble() - 0.5) * 0.6 * pedalDownDurationSec;
+        return std::max(0.5, pedalDownDurationSec + variation);
+    }
+
+    // Pedal is up - schedule when to press it
+    // At low energy, short gaps between pedal phrases
+    // At high energy, longer gaps (pedal rarely engaged)
+    double pedalUpDurationSec = mapRange((double)energy,
+                                         0.0, 1.0,
+                                         1.0, 5.0);  // 1 second to 5 seconds
+
+    // Add some randomness
+    double variation = (rng.nextDouble() - 0.5) * 0.6 * pedalUpDurationSec;
+    return std::max(0.5, pedalUpDurationSec + variation);
+}
+
+void StringFieldEngine::schedulePedalChange(int64_t now, float energy, float density)
+{
+    pedalRng.seek(pedalIndex++);
+
+    ScheduledEvent e;
+    e.time = now + (int64_t)(drawPedalWait(pedalRng, energy, density, pedalDown) * sr);
+    e.type = ScheduledType::PedalToggle;
+    pedalScheduled = queue.push(e);
+}
+
+void StringFieldEngine::scheduleNextNote(int64_t now)
+{
+    ScheduledEvent next;
+    next.type = ScheduledType::NoteOn;
+
+    pulseQueued = false;
+
+    // === SYNCED PULSE MODE ===
+    if (params.pulse && params.sync > 0)
+    {
+        scheduleSyncedPulse(now);
+        return;
+    }
+
+    pulseSlot = NoPulseSlot;
+
+    // Interval draws belong to the note being scheduled
+    rhythmRng.seek(noteIndex);
+
+    // === PULSE MODE ===
+    if (params.pulse)
+    {
+        // Beat interval in seconds
+        double beatInterval = 60.0 / std::max(40.0f, params.tempo);
+
+        // Regularity controls variance:
+        // High regularity (1.0) = strict tempo, minimal variance (±5%)
+        // Low regularity (0.0) = high variance (±100%), tempo not perceivable
+        float varianceAmount = mapRange(params.regularity, 0.0f, 1.0f, 1.0f, 0.05f);
+
+        // Random variance around beat interval
+        double variance = (rhythmRng.nextDouble() - 0.5) * 2.0 * varianceAmount * beatInterval;
+        double intervalSec = std::max(0.05, beatInterval + variance);
+
+        next.time = now + (int64_t)(intervalSec * sr);
+        notesScheduled = queue.push(next);
+        return;
+    }
+
+    // === RATE MODE (original behavior) ===
+    float energy = params.energy;
+    int memorySize = std::min(params.memory, MaxMemory);
+
+    double baseInterval = 1.0 / std::max(0.001f, params.rate);
+
+    // RHYTHMIC MEMORY MODE: Higher memory = more repetition of recent rhythms
+    // Low energy = strong rhythmic repetition (ostinato patterns)
+    // High energy = weaker repetition (more varied rhythm)
+    float memoryStrength = mapRange(energy, 0.0f, 1.0f, 1.0f, 0.3f);
+
+    // Long-horizon rhythm memory (Decay, Markov)
+    if (memorySize > 0 && params.memoryMode != (int)MemoryMode::Recent)
+    {
+        double intervalSec = pickRememberedInterval(baseInterval, memoryHorizons[memorySize]);
+        next.time = now + (int64_t)(intervalSec * sr);
+        notesScheduled = queue.push(next);
+        return;
+    }
+
+    // No rhythm memory: use simple jitter
+    if (memorySize <= 0 || recentIntervals.empty())
+    {
+        double jitter = (rhythmRng.nextDouble() - 0.5) * (energy * baseInterval);
+        double intervalSec = std::max(0.001, baseInterval + jitter);
+
+        // Store in rhythm memory for future
+        if (memorySize > 0)
+        {
+            recentIntervals.pushBack(intervalSec);
+            int rhythmMemorySize = std::max(1, memorySize / 2);  // Rhythm memory is half of pitch memory
+            if ((int)recentIntervals.size() > rhythmMemorySize)
+                recentIntervals.popFront();
+        }
+
+        next.time = now + (int64_t)(intervalSec * sr);
+        notesScheduled = queue.push(next);
+        return;
+    }
+
+    // With rhythm memory: FAVOR repeating recent intervals (strength scaled by energy)
+    int rhythmMemorySize = std::max(1, memorySize / 2);
+    float repeatProbability = memoryStrength * 0.75f;  // 75% at low energy, 22.5% at high energy
+
+    double intervalSec;
+    if (rhythmRng.nextFloat() < repeatProbability && !recentIntervals.empty())
+    {
+        // Pick from recent intervals (rhythmic ostinato)
+        int memoryIndex = rhythmRng.nextInt(0, (int)recentIntervals.size());
+        intervalSec = recentIntervals[memoryIndex];
+
+        // Add slight variation (±10%) to avoid mechanical feel
+        double variation = (rhythmRng.nextDouble() - 0.5) * 0.2 * intervalSec;
+        intervalSec = std::max(0.001, intervalSec + variation);
+    }
+    else
+    {
+        // Pick new interval (exploration)
+        double jitter = (rhythmRng.nextDouble() - 0.5) * (energy * baseInterval);
+        intervalSec = std::max(0.001, baseInterval + jitter);
+    }
+
+    // Update rhythm memory
+    recentIntervals.pushBack(intervalSec);
+    if ((int)recentIntervals.size() > rhythmMemorySize)
+        recentIntervals.popFront();
+
+    next.time = now + (int64_t)(intervalSec * sr);
+    notesScheduled = queue.push(next);
+}
+
+void StringFieldEngine::scheduleSyncedPulse(int64_t now)
+{
+    const double grid = syncGridBeats[limit(1, maxSync, params.sync)];
+
+    // Next slot after the last one, skipping any the playhead has passed
+    int64_t slot = (int64_t)std::ceil(timeToPpq(now) / grid - 1e-9);
+    if (pulseSlot != NoPulseSlot)
+        slot = std::max(slot, pulseSlot + 1);
+
+    // Regularity jitter is a fraction of the grid, at most half a slot either
+    // way, and drawn per slot: it never accumulates and never reorders onsets.
+    // High regularity (1.0) = ±2.5% of the grid, low (0.0) = ±50%
+    float varianceAmount = mapRange(params.regularity, 0.0f, 1.0f, 1.0f, 0.05f);
+
+    rhythmRng.seek((uint64_t)slot, 2);
+    double jitter = (rhythmRng.nextDouble() - 0.5) * varianceAmount * grid;
+
+    pulseSlot = slot;
+    pulseOnsetPpq = (double)slot * grid + jitter;
+
+    ScheduledEvent next;
+    next.type = ScheduledType::NoteOn;
+    next.time = std::max(now, ppqToTime(pulseOnsetPpq));
+    notesScheduled = queue.push(next);
+    pulseQueued = notesScheduled;
+}
+
+void StringFieldEngine::retimeSyncedPulse(int64_t now)
+{
+    if (!pulseQueued)
+        return;
+
+    queue.removeIf([](const ScheduledEvent& e) { return e.type == ScheduledType::NoteOn; });
+
+    ScheduledEvent next;
+    next.type = ScheduledType::NoteOn;
+    next.time = std::max(now, ppqToTime(pulseOnsetPpq));
+    notesScheduled = queue.push(next);
+    pulseQueued = notesScheduled;
+}
+
+void StringFieldEngine::handlePedalToggle(int64_t now, int offset, EventSink& sink)
+{
+    // Toggle pedal state and send CC 64. At very low engagement a due press
+    // is skipped, so the pedal only ever goes up there.
+    const bool down = !pedalDown && isPedalEngaged(params.energy, params.density);
+
+    if (down != pedalDown)
+    {
+        pedalDown = down;
+        int pedalValue = pedalDown ? 127 : 0;
+
+        // Send to all channels (sustain is global)
+        for (int ch = 1; ch <= 16; ++ch)
+            sink.handleEvent(MidiEvent::controller(offset, ch, 64, pedalValue));
+    }
+
+    // Schedule next pedal change
+    schedulePedalChange(now, params.energy, params.density);
+}
+
+void StringFieldEngine::handleNoteOn(int64_t now, int offset, EventSink& sink)
+{
+    // Position every stream at this note's draws
+    rhythmRng.seek(noteIndex, 1);
+    pitchRng.seek(noteIndex);
+    velocityRng.seek(noteIndex);
+    articulationRng.seek(noteIndex);
+    ++noteIndex;
+
+    // Density probabilistic gating
+    if (rhythmRng.nextFloat() <= params.density)
+    {
+        int note = pickNote(params.center, params.spread);
+        int vel = pickVelocity(params.vel);
+        int channel = pickArticulation(params.routes);
+
+        // Voice allocation: retrigger the same note, else a free voice, else steal
+        int slot = voices.findNote(note, channel);
+        if (slot < 0)
+            slot = voices.findFree();
+        if (slot < 0)
+            slot = voices.chooseVictim((StealMode)params.steal, channel);
+
+        Voice& voice = voices[slot];
+
+        if (voice.active)
+        {
+            // MONOPHONIC: if switching channels, release sustain pedal on old channel first
+            // This ensures true monophonic behavior across articulations
+            if (voices.getSize() == 1 && channel != voice.channel && pedalDown)
+                sink.handleEvent(MidiEvent::controller(offset, voice.channel, 64, 0));
+
+            sink.handleEvent(MidiEvent::noteOff(offset, voice.channel, voice.note));
+            queue.removeIf([slot](const ScheduledEvent& e)
+                           { return e.type == ScheduledType::NoteOff && e.voice == slot; });
+        }
+
+        sink.handleEvent(MidiEvent::noteOn(offset, channel, note, vel));
+
+        voice.active = true;
+        voice.note = note;
+        voice.channel = channel;
+        voice.velocity = vel;
+        voice.startTime = now;
+        voice.offTime = now + (int64_t)calculateDuration(params.energy);
+
+        // Schedule note-off
+        ScheduledEvent off;
+        off.time = voice.offTime;
+        off.type = ScheduledType::NoteOff;
+        off.note = note;
+        off.channel = channel;
+        off.voice = slot;
+        queue.push(off);
+    }
+
+    // Schedule next event
+    scheduleNextNote(now);
+}
+
+void StringFieldEngine::render(int64_t startSample, int numSamples, EventSink& sink)
+{
+    const int64_t blockStart = startSample;
+    const int64_t blockEnd = startSample + numSamples;
+
+    // Initialize schedulers if needed
+    if (!notesScheduled)
+        scheduleNextNote(blockStart);
+
+    if (params.pedal && !pedalScheduled)
+        schedulePedalChange(blockStart, params.energy, params.density);
+
+    // Drain every event due inside this block, in time order
+    while (!queue.empty() && queue.top().time < blockEnd)
+    {
+        const ScheduledEvent e = queue.pop();
+        const int offset = (int)std::max<int64_t>(0, e.time - blockStart);
+
+        switch (e.type)
+        {
+            case ScheduledType::PedalToggle:
+            {
+                ScopedStageTimer timer(profiler, HotPathStage::Pedal);
+                pedalScheduled = false;
+                handlePedalToggle(e.time, offset, sink);
+                break;
+            }
+
+            case ScheduledType::NoteOff:
+                sink.handleEvent(MidiEvent::noteOff(offset, e.channel, e.note));
+                voices[e.voice].active = false;
+                break;
+
+            case ScheduledType::NoteOn:
+            {
+                ScopedStageTimer timer(profiler, HotPathStage::Notes);
+                notesScheduled = false;
+                handleNoteOn(e.time, offset, sink);
+                break;
+            }
+        }
+    }
+}
+
+// === Pitch-Class Set Helper Functions ===
+
+void StringFieldEngine::setPitchClassSet(const CompiledPitchClassSet* set)
+{
+    pcSet = set;
+    numPitchClasses = set != nullptr ? set->numPitchClasses : 0;
+    numRemainingPCs = 0;
+    std::fill(std::begin(pcToMidiMap), std::end(pcToMidiMap), -1);
+
+    if (numPitchClasses == 0)
+        return;
+
+    std::copy(set->pitchClasses, set->pitchClasses + numPitchClasses, pitchClassSet);
+
+    // Initialize remaining PCs (randomized order for exhaustion)
+    pitchRng.seek(noteIndex, 1);
+    shuffleRemainingPCs();
+}
+
+void StringFieldEngine::shuffleRemainingPCs()
+{
+    std::copy(pitchClassSet, pitchClassSet + numPitchClasses, remainingPCs);
+    numRemainingPCs = numPitchClasses;
+
+    // Fisher-Yates shuffle
+    for (int i = numRemainingPCs - 1; i > 0; --i)
+    {
+        int j = pitchRng.nextInt(i + 1);
+        std::swap(remainingPCs[i], remainingPCs[j]);
+    }
+}
+
+void StringFieldEngine::transformPitchClassSet()
+{
+    if (numPitchClasses == 0)
+        return;
+
+    if (params.pcMode == 1)
+    {
+        // Transpose only (Tn)
+        int transposition = pitchRng.nextInt(12);  // T0 to T11
+        for (int i = 0; i < numPitchClasses; ++i)
+            pitchClassSet[i] = (pitchClassSet[i] + transposition) % 12;
+    }
+    else if (params.pcMode == 2)
+    {
+        // Transpose + Invert (TnI)
+        bool invert = pitchRng.nextBool();
+        int transposition = pitchRng.nextInt(12);
+
+        if (invert)
+        {
+            for (int i = 0; i < numPitchClasses; ++i)
+                pitchClassSet[i] = (12 - pitchClassSet[i] + transposition) % 12;  // Inversion then transposition
+        }
+        else
+        {
+            for (int i = 0; i < numPitchClasses; ++i)
+                pitchClassSet[i] = (pitchClassSet[i] + transposition) % 12;
+        }
+    }
+
+    // Re-shuffle for new exhaustion cycle
+    shuffleRemainingPCs();
+
+    // Clear octave memory on transformation
+    std::fill(std::begin(pcToMidiMap), std::end(pcToMidiMap), -1);
+}
+
+int StringFieldEngine::mapPCToMIDI(int pitchClass, int center, int spread)
+{
+    int lo = limit(0, 127, center - spread);
+    int hi = limit(0, 127, center + spread);
+
+    // Check if we've already assigned a MIDI note to this PC (octave memory)
+    int midiNote = pcToMidiMap[pitchClass];
+    if (midiNote >= 0)
+    {
+        // Make sure it's still in range
+        if (midiNote >= lo && midiNote <= hi)
+            return midiNote;
+    }
+
+    // Find all valid MIDI notes matching this pitch class within range
+    int candidates[11];  // At most 11 octaves of one PC in 0-127
+    int numCandidates = 0;
+    const uint8_t* notes = pcSet->notesForPC[pitchClass];
+    for (int i = 0; i < pcSet->numNotesForPC[pitchClass]; ++i)
+    {
+        if (notes[i] >= lo && notes[i] <= hi)
+            candidates[numCandidates++] = notes[i];
+    }
+
+    if (numCandidates == 0)
+    {
+        // Fallback: find closest note with this PC
+        for (int note = center; note >= 0; --note)
+            if (note % 12 == pitchClass) { candidates[numCandidates++] = note; break; }
+        for (int note = center; note <= 127; ++note)
+            if (note % 12 == pitchClass) { candidates[numCandidates++] = note; break; }
+    }
+
+    if (numCandidates == 0)
+        return center;  // Emergency fallback
+
+    // Randomly pick octave
+    int chosenNote = candidates[pitchRng.nextInt(numCandidates)];
+
+    // Store in memory
+    pcToMidiMap[pitchClass] = chosenNote;
+
+    return chosenNote;
+}
+
+} // namespace stringfield
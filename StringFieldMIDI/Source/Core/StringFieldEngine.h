@@ -0,0 +1,200 @@
+#pragma once
+#include "AliasTable.h"
+#include "EngineParams.h"
+#include "EventQueue.h"
+#include "FixedRingBuffer.h"
+#include "HotPathProfiler.h"
+#include "MidiEvent.h"
+#include "MotifMemory.h"
+#include "CounterRandom.h"
+#include "PitchClassSet.h"
+#include "VoicePool.h"
+#include "WeightProfile.h"
+#include <cstdint>
+
+namespace stringfield
+{
+
+// Host position: `ppq` quarter notes at sample `time`, moving at `bpm`
+struct TransportPosition
+{
+    int64_t time = 0;
+    double ppq = 0.0;
+    double bpm = 120.0;
+};
+
+// Headless String Field generator. No JUCE, no host: feed it parameters and
+// render sample ranges into an EventSink. The plugin wraps one of these;
+// offline tools can drive it directly.
+//
+// Every scheduled event that falls inside a rendered range is emitted at its
+// exact offset, and all scheduling is relative to event times, never to block
+// boundaries. With constant parameters the output is therefore identical for
+// any way of splitting the timeline into render() calls.
+//
+// Synced pulse mode places onsets on a grid in PPQ (quarter-note) space
+// rather than counting seconds: onset k sits at k * grid plus a jitter drawn
+// for slot k. Sample times are derived from the host position each block, so
+// no error accumulates, tempo changes move pending onsets with the grid, and
+// every instance following the same host lands on the same slots.
+//
+// Randomness is counter-based: every draw is a function of (seed, stream,
+// event index), with separate streams for pitch, rhythm, velocity,
+// articulation and pedal. Note N's draws can be computed directly, and one
+// stream using more numbers never perturbs another.
+//
+// The whole generator state lives in plain value members (no pointers apart
+// from the shared, immutable PC set and weights), so an engine can be
+// checkpointed and restored by copying it; see CheckpointCache.
+//
+// render(), setParameters() and stop() never allocate or lock.
+class StringFieldEngine
+{
+public:
+    static constexpr int MaxMemory = 16;
+    static constexpr int MaxHorizon = 4096;     // Decay/Markov memory at MaxMemory, in notes
+    static constexpr int64_t NoPulseSlot = INT64_MIN;
+
+    StringFieldEngine();
+
+    // Resets scheduling state for a new sample rate (event counters and memory are kept)
+    void prepare(double sampleRate);
+
+    // Applies a parameter set. Seed changes rekey the random streams and
+    // restart the event count; disabling the pedal releases it immediately
+    // (events go out at offset 0).
+    void setParameters(const EngineParams& newParams, int64_t now, EventSink& sink);
+    const EngineParams& getParameters() const { return params; }
+
+    // Adopts a compiled pitch-class set (nullptr or an empty set disables it).
+    // Realtime-safe; the set must outlive its use by the engine.
+    void setPitchClassSet(const CompiledPitchClassSet* set);
+
+    // Adopts user pitch/route weights (nullptr = flat). Realtime-safe; the
+    // profile must outlive its use by the engine.
+    void setWeightProfile(const CompiledWeightProfile* profile);
+
+    // Times pedal and note handling into `profiler` (nullptr = off). Not part
+    // of the generator state: CheckpointCache::restore keeps the live one.
+    void setProfiler(HotPathProfiler* newProfiler) { profiler = newProfiler; }
+    HotPathProfiler* getProfiler() const { return profiler; }
+
+    // Generates events for [startSample, startSample + numSamples). Ranges
+    // are expected to be contiguous while the transport runs.
+    void render(int64_t startSample, int numSamples, EventSink& sink);
+
+    // Host tempo and position for the following render() calls. Synced pulse
+    // onsets are placed by it; without one the grid runs at the Tempo
+    // parameter from time 0.
+    void setTransport(const TransportPosition& position);
+
+    // Time of the earliest scheduled event (INT64_MAX if none). A render()
+    // schedules the first note and pedal change from its start if needed.
+    int64_t getNextEventTime() const { return queue.empty() ? INT64_MAX : queue.top().time; }
+
+    // Transport stop: pedal up, all notes off, all sound off
+    void stop(EventSink& sink);
+
+    // Advances from a state at `from` to `to` without emitting anything
+    void fastForward(int64_t from, int64_t to);
+
+    // Re-sends the controller state the generator assumes (sustain pedal held),
+    // e.g. after restoring a checkpoint. Events go out at offset 0.
+    void sendControllerState(EventSink& sink);
+
+private:
+    // Plays out rate-mode streams from the same tables and helpers
+    friend class BatchKernel;
+
+    // === State Variables ===
+    double sr = 44100.0;
+    EngineParams params;
+
+    // Scheduler (sample-time): pending note-ons, note-offs and pedal toggles
+    EventQueue<VoicePool::MaxVoices + 8> queue;
+    bool notesScheduled = false;      // A NoteOn is queued
+    bool pedalScheduled = false;      // A PedalToggle is queued
+
+    // Synced pulse: tempo map (ppq = anchorPpq + (t - anchorTime) / samplesPerBeat)
+    // and the grid slot of the queued onset
+    bool hostTempo = false;
+    int64_t anchorTime = 0;
+    double anchorPpq = 0.0;
+    double samplesPerBeat = 0.0;
+    int64_t pulseSlot = NoPulseSlot;  // Last scheduled slot
+    bool pulseQueued = false;         // The queued NoteOn is a synced onset
+    double pulseOnsetPpq = 0.0;
+
+    // Sounding notes (size 1 = monophonic v0.1 behavior)
+    VoicePool voices;
+
+    // Sustain pedal state (automatic, energy/density controlled)
+    bool pedalDown = false;
+    bool lastPedalParamState = false;  // Track parameter changes
+
+    // Random streams, keyed by seed; positioned per event
+    CounterRandom pitchRng, rhythmRng, velocityRng, articulationRng, pedalRng;
+    int lastSeed = 1;
+    uint64_t noteIndex = 0;           // Note slots handled since the seed was set
+    uint64_t pedalIndex = 0;          // Pedal changes scheduled since the seed was set
+
+    // Sampling tables, rebuilt when their parameters or the weights change
+    const CompiledWeightProfile* weights = nullptr;
+    AliasTable<128> pitchTable;           // Chromatic range lo..hi
+    int pitchTableLow = 0;
+    AliasTable<16> routeTable;            // Routes 1..numRoutes
+
+    // Memory kernels (Feldman-ish fragile memory)
+    // Recent: the last `memory` notes and half as many intervals
+    // (one spare slot each: the oldest entry is dropped after pushing)
+    FixedRingBuffer<int, MaxMemory + 1> recentNotes;              // Pitch memory
+    FixedRingBuffer<double, MaxMemory / 2 + 1> recentIntervals;   // Rhythm memory
+
+    // Decay and Markov: horizons of up to MaxHorizon notes in fixed tables
+    RecencyReservoir<uint8_t, 32> decayNotes;
+    RecencyReservoir<float, 16> decayIntervals;
+    TransitionTable<uint8_t, 128, 4> noteTransitions;        // By the previous note
+    TransitionTable<uint8_t, 128, 4> notePairTransitions;    // By the previous two (hashed)
+    TransitionTable<float, 16, 4> intervalTransitions;       // By the previous interval's bucket
+    int previousNotes[2] { -1, -1 };      // Most recent first (-1 = none)
+    int previousIntervalBucket = -1;
+
+    // Pitch-class set state
+    const CompiledPitchClassSet* pcSet = nullptr;   // Candidate-note tables
+    int pitchClassSet[12] {};             // Current PC set (0-11)
+    int numPitchClasses = 0;
+    int remainingPCs[12] {};              // PCs not yet exhausted
+    int numRemainingPCs = 0;
+    int pcToMidiMap[12] {};               // PC → MIDI note memory (-1 = none, for octave consistency)
+
+    HotPathProfiler* profiler = nullptr;  // Stage timing (instrumented builds)
+
+    // === Helper Methods ===
+    void setSeed(int seed);
+    void scheduleNextNote(int64_t now);
+    void scheduleSyncedPulse(int64_t now);
+    void retimeSyncedPulse(int64_t now);
+    double getSamplesPerBeat() const;
+    double timeToPpq(int64_t time) const;
+    int64_t ppqToTime(double ppq) const;
+    static bool isPedalEngaged(float energy, float density);
+    static double drawPedalWait(CounterRandom& rng, float energy, float density, bool pedalDown);
+    void schedulePedalChange(int64_t now, float energy, float density);
+    void handlePedalToggle(int64_t now, int offset, EventSink& sink);
+    void handleNoteOn(int64_t now, int offset, EventSink& sink);
+    void buildPitchTable();
+    void buildRouteTable();
+    int pickNote(int center, int spread);
+    int pickRememberedNote(int horizon);
+    double pickRememberedInterval(double baseInterval, int horizon);
+    int pickVelocity(int baseVel);
+    int pickArticulation(int numRoutes);
+    double calculateDuration(float energy);
+
+    // Pitch-class set helpers
+    void transformPitchClassSet();  // Apply random Tn or TnI
+    void shuffleRemainingPCs();     // Fisher-Yates over a fresh copy of the set
+    int mapPCToMIDI(int pitchClass, int center, int spread);
+};
+
+} // namespace stringfield
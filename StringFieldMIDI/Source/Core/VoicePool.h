@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+
+namespace stringfield
+{
+
+// Which voice gives way when a new note arrives and every voice is busy
+enum class StealMode
+{
+    Oldest = 0,       // Longest-sounding voice
+    Quietest = 1,     // Lowest velocity (oldest among equals)
+    SameRoute = 2     // Oldest voice on the new note's channel, else oldest overall
+};
+
+struct Voice
+{
+    bool active = false;
+    int note = 0;
+    int channel = 1;
+    int velocity = 0;
+    int64_t startTime = 0;    // Absolute sample time of the note-on
+    int64_t offTime = 0;      // Absolute sample time of the scheduled note-off
+};
+
+// Fixed-capacity voice table. Plain arrays only: safe to use and copy on the
+// audio thread. The usable size can shrink below MaxVoices at runtime; voices
+// above it simply ring out.
+class VoicePool
+{
+public:
+    static constexpr int MaxVoices = 16;
+
+    void setSize(int newSize) noexcept
+    {
+        size = newSize < 1 ? 1 : (newSize > MaxVoices ? MaxVoices : newSize);
+    }
+
+    int getSize() const noexcept { return size; }
+
+    void clear() noexcept
+    {
+        for (auto& v : voices)
+            v.active = false;
+    }
+
+    Voice& operator[](int index) noexcept { return voices[index]; }
+    const Voice& operator[](int index) const noexcept { return voices[index]; }
+
+    int numActive() const noexcept
+    {
+        int n = 0;
+        for (const auto& v : voices)
+            n += v.active ? 1 : 0;
+        return n;
+    }
+
+    // Voice already sounding this note on this channel, or -1
+    int findNote(int note, int channel) const noexcept
+    {
+        for (int i = 0; i < MaxVoices; ++i)
+            if (voices[i].active && voices[i].note == note && voices[i].channel == channel)
+                return i;
+        return -1;
+    }
+
+    // Idle voice within the current size, or -1
+    int findFree() const noexcept
+    {
+        for (int i = 0; i < size; ++i)
+            if (!voices[i].active)
+                return i;
+        return -1;
+    }
+
+    // Voice to steal for a new note on `channel` (all voices in size are busy)
+    int chooseVictim(StealMode mode, int channel) const noexcept
+    {
+        int victim = 0;
+
+        for (int i = 1; i < size; ++i)
+        {
+            const Voice& v = voices[i];
+            const Voice& best = voices[victim];
+
+            switch (mode)
+            {
+                case StealMode::Quietest:
+                    if (v.velocity < best.velocity
+                        || (v.velocity == best.velocity && v.startTime < best.startTime))
+                        victim = i;
+                    break;
+
+                case StealMode::SameRoute:
+                {
+                    bool vSame = v.channel == channel;
+                    bool bestSame = best.channel == channel;
+                    if ((vSame && !bestSame)
+                        || (vSame == bestSame && v.startTime < best.startTime))
+                        victim = i;
+                    break;
+                }
+
+                case StealMode::Oldest:
+                default:
+                    if (v.startTime < best.startTime)
+                        victim = i;
+                    break;
+            }
+        }
+
+        return victim;
+    }
+
+private:
+    Voice voices[MaxVoices];
+    int size = 1;
+};
+
+} // namespace stringfield
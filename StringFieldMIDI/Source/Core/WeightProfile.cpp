@@ -0,0 +1,60 @@
+#include "WeightProfile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace stringfield
+{
+
+namespace
+{
+    // Anything larger could overflow once multiplied into a distribution
+    constexpr float maxWeight = 1.0e6f;
+
+    // Fills `weights` from the text, returns false if the result is flat.
+    // Text with a weight that is negative, not finite or above maxWeight is
+    // invalid, and leaves the distribution flat as a whole.
+    bool parseWeights(const std::string& text, float* weights, int count)
+    {
+        std::fill(weights, weights + count, 1.0f);
+
+        const char* p = text.c_str();
+        int parsed = 0;
+        while (*p != '\0' && parsed < count)
+        {
+            char* end = nullptr;
+            const float value = std::strtof(p, &end);
+            if (end == p)
+            {
+                ++p;              // Separator or stray character
+                continue;
+            }
+
+            if (!std::isfinite(value) || value < 0.0f || value > maxWeight)
+            {
+                std::fill(weights, weights + count, 1.0f);
+                return false;
+            }
+
+            weights[parsed++] = value;
+            p = end;
+        }
+
+        const bool anyWeight = std::any_of(weights, weights + count, [](float w) { return w > 0.0f; });
+        const bool uniform = std::all_of(weights, weights + count, [&](float w) { return w == weights[0]; });
+        return anyWeight && !uniform;
+    }
+}
+
+std::unique_ptr<CompiledWeightProfile> CompiledWeightProfile::compile(const std::string& pitchText,
+                                                                      const std::string& routeText)
+{
+    auto profile = std::make_unique<CompiledWeightProfile>();
+    profile->pitchSource = pitchText;
+    profile->routeSource = routeText;
+    profile->flatPitch = !parseWeights(pitchText, profile->pitch, 12);
+    profile->flatRoutes = !parseWeights(routeText, profile->routes, 16);
+    return profile;
+}
+
+} // namespace stringfield
@@ -0,0 +1,33 @@
+#pragma once
+#include <memory>
+#include <string>
+
+namespace stringfield
+{
+
+// User weighting of the pitch and articulation distributions, parsed ahead
+// of time like CompiledPitchClassSet. Immutable once compiled; share it
+// read-only.
+//
+// Pitch weights are per pitch class (C to B) and scale the chromatic range;
+// route weights (routes 1-16) scale the articulation distribution, so
+// Articulation and Energy still shape it.
+struct CompiledWeightProfile
+{
+    // Relative weights separated by spaces or commas, e.g.
+    // "4 0 1 0 2 1 0 3 0 1 0 1". Missing entries weigh 1. Empty text, all
+    // zeros, or any weight that is negative, inf/nan or above 1e6 leaves
+    // that distribution flat.
+    static std::unique_ptr<CompiledWeightProfile> compile(const std::string& pitchText,
+                                                          const std::string& routeText);
+
+    std::string pitchSource;           // Texts as typed
+    std::string routeSource;
+
+    float pitch[12] {};
+    float routes[16] {};
+    bool flatPitch = true;
+    bool flatRoutes = true;
+};
+
+} // namespace stringfield
@@ -0,0 +1,97 @@
+#include "ParamSnapshot.h"
+
+ParamSnapshot::ParamSnapshot(juce::AudioProcessorValueTreeState& state)
+    : apvts(state)
+{
+    for (int i = 0; i < numParams; ++i)
+    {
+        raw[(size_t)i] = apvts.getRawParameterValue(ids[i]);
+        jassert(raw[(size_t)i] != nullptr);
+
+        flags[(size_t)i].mask = &dirty;
+        flags[(size_t)i].bit = 1u << i;
+        apvts.addParameterListener(ids[i], &flags[(size_t)i]);
+    }
+}
+
+ParamSnapshot::~ParamSnapshot()
+{
+    for (int i = 0; i < numParams; ++i)
+        apvts.removeParameterListener(ids[i], &flags[(size_t)i]);
+}
+
+uint32_t ParamSnapshot::update() noexcept
+{
+    const uint32_t changed = dirty.exchange(0, std::memory_order_acquire);
+    if (changed == 0)
+        return 0;
+
+    for (int i = 0; i < numParams; ++i)
+        apply(values, i, raw[(size_t)i]->load(std::memory_order_relaxed));
+
+    return changed;
+}
+
+int ParamSnapshot::indexOf(const juce::String& parameterID) noexcept
+{
+    for (int i = 0; i < numParams; ++i)
+        if (parameterID == ids[i])
+            return i;
+    return -1;
+}
+
+void ParamSnapshot::apply(stringfield::EngineParams& p, int index, float value) noexcept
+{
+    switch (index)
+    {
+        case rate:          p.rate = value; break;
+        case density:       p.density = value; break;
+        case energy:        p.energy = value; break;
+        case center:        p.center = (int)value; break;
+        case spread:        p.spread = (int)value; break;
+        case vel:           p.vel = (int)value; break;
+        case seed:          p.seed = (int)value; break;
+        case routes:        p.routes = (int)value; break;
+        case memory:        p.memory = (int)value; break;
+        case articulation:  p.articulation = value; break;
+        case pulse:         p.pulse = value > 0.5f; break;
+        case tempo:         p.tempo = value; break;
+        case regularity:    p.regularity = value; break;
+        case pcmode:        p.pcMode = (int)value; break;
+        case pedal:         p.pedal = value > 0.5f; break;
+        case voices:        p.voices = (int)value; break;
+        case steal:         p.steal = (int)value; break;
+        case sync:          p.sync = (int)value; break;
+        case players:       p.players = (int)value; break;
+        case memmode:       p.memoryMode = (int)value; break;
+        default:            break;
+    }
+}
+
+float ParamSnapshot::valueOf(const stringfield::EngineParams& p, int index) noexcept
+{
+    switch (index)
+    {
+        case rate:          return p.rate;
+        case density:       return p.density;
+        case energy:        return p.energy;
+        case center:        return (float)p.center;
+        case spread:        return (float)p.spread;
+        case vel:           return (float)p.vel;
+        case seed:          return (float)p.seed;
+        case routes:        return (float)p.routes;
+        case memory:        return (float)p.memory;
+        case articulation:  return p.articulation;
+        case pulse:         return p.pulse ? 1.0f : 0.0f;
+        case tempo:         return p.tempo;
+        case regularity:    return p.regularity;
+        case pcmode:        return (float)p.pcMode;
+        case pedal:         return p.pedal ? 1.0f : 0.0f;
+        case voices:        return (float)p.voices;
+        case steal:         return (float)p.steal;
+        case sync:          return (float)p.sync;
+        case players:       return (float)p.players;
+        case memmode:       return (float)p.memoryMode;
+        default:            return 0.0f;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "Core/EngineParams.h"
+#include <array>
+#include <atomic>
+
+// Per-block view of the plugin parameters.
+//
+// Raw value pointers are looked up once at construction, and an APVTS
+// listener per parameter sets a dirty bit whenever it moves (host automation,
+// GUI or conductor CCs). A block in which nothing changed costs one atomic
+// exchange; otherwise the engine parameter set is refreshed from the cached
+// pointers, without any string-keyed lookups.
+class ParamSnapshot
+{
+public:
+    enum Index
+    {
+        rate, density, energy, center, spread, vel, seed, routes, memory,
+        articulation, pulse, tempo, regularity, pcmode, pedal, voices, steal, sync, players,
+        memmode, numParams
+    };
+
+    static constexpr const char* ids[numParams] = {
+        "rate", "density", "energy", "center", "spread", "vel", "seed", "routes", "memory",
+        "articulation", "pulse", "tempo", "regularity", "pcmode", "pedal", "voices", "steal", "sync",
+        "players", "memmode"
+    };
+
+    explicit ParamSnapshot(juce::AudioProcessorValueTreeState& state);
+    ~ParamSnapshot();
+
+    // Audio thread: refreshes the snapshot if anything changed since the last
+    // call and returns the mask of changed parameters (bit = Index).
+    uint32_t update() noexcept;
+
+    const stringfield::EngineParams& get() const noexcept { return values; }
+
+    // Index of a parameter ID, or -1
+    static int indexOf(const juce::String& parameterID) noexcept;
+
+    // Writes a real-unit parameter value into an engine parameter set
+    static void apply(stringfield::EngineParams& params, int index, float value) noexcept;
+
+    // Reads one back (inverse of apply)
+    static float valueOf(const stringfield::EngineParams& params, int index) noexcept;
+
+    // Forces a full refresh on the next update()
+    void markAllDirty() noexcept { dirty.store(allBits, std::memory_order_release); }
+
+private:
+    static constexpr uint32_t allBits = (1u << numParams) - 1;
+
+    struct DirtyFlag : juce::AudioProcessorValueTreeState::Listener
+    {
+        std::atomic<uint32_t>* mask = nullptr;
+        uint32_t bit = 0;
+
+        void parameterChanged(const juce::String&, float) override
+        {
+            mask->fetch_or(bit, std::memory_order_release);
+        }
+    };
+
+    juce::AudioProcessorValueTreeState& apvts;
+    std::array<std::atomic<float>*, numParams> raw {};
+    std::array<DirtyFlag, numParams> flags;
+    std::atomic<uint32_t> dirty { allBits };
+    stringfield::EngineParams values;
+
+    JUCE_DECLARE_NON_COPYABLE(ParamSnapshot)
+};
@@ -33,10 +33,15 @@ StringFieldMIDIEditor::StringFieldMIDIEditor(StringFieldMIDIProcessor& p)
     setupSlider(memorySlider, memoryLabel, "MEMORY");
     setupSlider(articulationSlider, articulationLabel, "ARTICULATION");
     setupSlider(pulseSlider, pulseLabel, "PULSE");
+    setupSlider(syncSlider, syncLabel, "SYNC");
     setupSlider(tempoSlider, tempoLabel, "TEMPO");
     setupSlider(regularitySlider, regularityLabel, "REGULARITY");
     setupSlider(pcModeSlider, pcModeLabel, "PC MODE");
     setupSlider(pedalSlider, pedalLabel, "PEDAL");
+    setupSlider(voicesSlider, voicesLabel, "VOICES");
+    setupSlider(stealSlider, stealLabel, "STEAL");
+    setupSlider(conductorSlider, conductorLabel, "CONDUCT");
+    setupSlider(memoryModeSlider, memoryModeLabel, "MEM MODE");
 
     // Setup PC set text editor
     addAndMakeVisible(pcSetEditor);
@@ -55,6 +60,51 @@ StringFieldMIDIEditor::StringFieldMIDIEditor(StringFieldMIDIProcessor& p)
     pcSetEditor.setFont(juce::Font("Courier New", 14.0f, juce::Font::bold));
     pcSetEditor.addListener(this);
 
+    // MIDI export button + status (top right of the title plate)
+    addAndMakeVisible(exportButton);
+    exportButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xFF1A1A1A));
+    exportButton.setColour(juce::TextButton::textColourOffId, juce::Colour(0xFFD4AF37));
+    exportButton.onClick = [this] { exportButtonClicked(); };
+
+    addAndMakeVisible(exportStatusLabel);
+    exportStatusLabel.setJustificationType(juce::Justification::centredRight);
+    exportStatusLabel.setColour(juce::Label::textColourId, juce::Colour(0xFF8B7355));
+    exportStatusLabel.setFont(juce::Font("Courier New", 10.0f, juce::Font::plain));
+    updateExportStatus();
+
+    addAndMakeVisible(weightsButton);
+    weightsButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xFF1A1A1A));
+    weightsButton.setColour(juce::TextButton::textColourOffId, juce::Colour(0xFFD4AF37));
+    weightsButton.onClick = [this] { weightsButtonClicked(); };
+
+    addAndMakeVisible(ensembleButton);
+    ensembleButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xFF1A1A1A));
+    ensembleButton.setColour(juce::TextButton::textColourOffId, juce::Colour(0xFFD4AF37));
+    ensembleButton.onClick = [this] { ensembleButtonClicked(); };
+
+    playersSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    playersSlider.setTextBoxStyle(juce::Slider::TextBoxLeft, false, 40, 20);
+    playersSlider.setSize(360, 24);
+
+    // Only instrumented builds have anything to show
+    addChildComponent(statsButton);
+    statsButton.setVisible(stringfield::HotPathProfiler::enabled);
+    statsButton.setColour(juce::TextButton::buttonColourId, juce::Colour(0xFF1A1A1A));
+    statsButton.setColour(juce::TextButton::textColourOffId, juce::Colour(0xFFD4AF37));
+    statsButton.onClick = [this] { statsButtonClicked(); };
+
+    statsText.setMultiLine(true);
+    statsText.setReadOnly(true);
+    statsText.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 12.0f, juce::Font::plain));
+    statsText.setSize(520, 170);
+
+    addAndMakeVisible(dinButton);
+    dinButton.setColour(juce::ToggleButton::textColourId, juce::Colour(0xFFD4AF37));
+    dinButton.setColour(juce::ToggleButton::tickColourId, juce::Colour(0xFFFFBF00));
+    dinButton.setTooltip("Pace output at 31250-baud DIN MIDI speed");
+    dinAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        processor.apvts, "dinlimit", dinButton);
+
     // Attach to parameters
     rateAttachment = std::make_unique<SliderAttachment>(
         processor.apvts, "rate", rateSlider);
@@ -78,6 +128,8 @@ StringFieldMIDIEditor::StringFieldMIDIEditor(StringFieldMIDIProcessor& p)
         processor.apvts, "articulation", articulationSlider);
     pulseAttachment = std::make_unique<SliderAttachment>(
         processor.apvts, "pulse", pulseSlider);
+    syncAttachment = std::make_unique<SliderAttachment>(
+        processor.apvts, "sync", syncSlider);
     tempoAttachment = std::make_unique<SliderAttachment>(
         processor.apvts, "tempo", tempoSlider);
     regularityAttachment = std::make_unique<SliderAttachment>(
@@ -86,8 +138,22 @@ StringFieldMIDIEditor::StringFieldMIDIEditor(StringFieldMIDIProcessor& p)
         processor.apvts, "pcmode", pcModeSlider);
     pedalAttachment = std::make_unique<SliderAttachment>(
         processor.apvts, "pedal", pedalSlider);
-
-    setSize(700, 600);
+    voicesAttachment = std::make_unique<SliderAttachment>(
+        processor.apvts, "voices", voicesSlider);
+    stealAttachment = std::make_unique<SliderAttachment>(
+        processor.apvts, "steal", stealSlider);
+    conductorAttachment = std::make_unique<SliderAttachment>(
+        processor.apvts, "conductor", conductorSlider);
+    memoryModeAttachment = std::make_unique<SliderAttachment>(
+        processor.apvts, "memmode", memoryModeSlider);
+    playersAttachment = std::make_unique<SliderAttachment>(
+        processor.apvts, "players", playersSlider);
+
+    addAndMakeVisible(activityView);
+
+    // The cached background covers every pixel
+    setOpaque(true);
+    setSize(780, 720);
 }
 
 void StringFieldMIDIEditor::textEditorTextChanged(juce::TextEditor&)
@@ -95,7 +161,141 @@ void StringFieldMIDIEditor::textEditorTextChanged(juce::TextEditor&)
     processor.setPitchClassSet(pcSetEditor.getText());
 }
 
+void StringFieldMIDIEditor::exportButtonClicked()
+{
+    if (processor.isExportingMidi())
+    {
+        processor.stopMidiExport();
+        updateExportStatus();
+        return;
+    }
+
+    exportChooser = std::make_unique<juce::FileChooser>(
+        "Export MIDI",
+        juce::File::getSpecialLocation(juce::File::userMusicDirectory).getChildFile("StringField.mid"),
+        "*.mid");
+
+    exportChooser->launchAsync(juce::FileBrowserComponent::saveMode
+                                   | juce::FileBrowserComponent::canSelectFiles
+                                   | juce::FileBrowserComponent::warnAboutOverwriting,
+                               [this](const juce::FileChooser& chooser)
+                               {
+                                   auto file = chooser.getResult();
+                                   if (file != juce::File())
+                                       processor.startMidiExport(file.withFileExtension("mid"));
+                                   updateExportStatus();
+                               });
+}
+
+void StringFieldMIDIEditor::weightsButtonClicked()
+{
+    auto* window = new juce::AlertWindow("WEIGHTS",
+                                         "Relative weights separated by spaces. Missing entries weigh 1; empty = flat.",
+                                         juce::MessageBoxIconType::NoIcon, this);
+    window->addTextEditor("pitch", processor.getPitchWeights(), "Pitch classes C C# D ... B:");
+    window->addTextEditor("routes", processor.getRouteWeights(), "Routes 1-16:");
+    window->addButton("OK", 1, juce::KeyPress(juce::KeyPress::returnKey));
+    window->addButton("CANCEL", 0, juce::KeyPress(juce::KeyPress::escapeKey));
+
+    // The window deletes itself when dismissed
+    juce::Component::SafePointer<StringFieldMIDIEditor> safeThis(this);
+    window->enterModalState(true, juce::ModalCallbackFunction::create([safeThis, window](int result)
+    {
+        if (result == 1 && safeThis != nullptr)
+            safeThis->processor.setWeightProfile(window->getTextEditorContents("pitch"),
+                                                 window->getTextEditorContents("routes"));
+    }), true);
+}
+
+void StringFieldMIDIEditor::ensembleButtonClicked()
+{
+    auto* window = new juce::AlertWindow("ENSEMBLE",
+                                         "Players, and per player (separated by ;) any of:\n"
+                                         "seed=N center=N spread=N vel=N density=X energy=X (added), "
+                                         "rate=X (times), ch=A-B (channels). Unset: seed + player, "
+                                         "an even share of the 16 channels.",
+                                         juce::MessageBoxIconType::NoIcon, this);
+    window->addCustomComponent(&playersSlider);
+    window->addTextEditor("layout", processor.getEnsembleLayout(), "Players:");
+    window->addButton("OK", 1, juce::KeyPress(juce::KeyPress::returnKey));
+    window->addButton("CANCEL", 0, juce::KeyPress(juce::KeyPress::escapeKey));
+
+    // The window deletes itself when dismissed (playersSlider stays ours)
+    juce::Component::SafePointer<StringFieldMIDIEditor> safeThis(this);
+    window->enterModalState(true, juce::ModalCallbackFunction::create([safeThis, window](int result)
+    {
+        if (result == 1 && safeThis != nullptr)
+            safeThis->processor.setEnsembleLayout(window->getTextEditorContents("layout"));
+    }), true);
+}
+
+void StringFieldMIDIEditor::statsButtonClicked()
+{
+    const auto report = juce::String(processor.getProfiler().getReport().format());
+    statsText.setText(report, false);
+
+    auto* window = new juce::AlertWindow("STATS", "processBlock timings since the last reset",
+                                         juce::MessageBoxIconType::NoIcon, this);
+    window->addCustomComponent(&statsText);
+    window->addButton("COPY", 1);
+    window->addButton("RESET", 2);
+    window->addButton("CLOSE", 0, juce::KeyPress(juce::KeyPress::escapeKey));
+
+    // The window deletes itself when dismissed (statsText stays ours)
+    juce::Component::SafePointer<StringFieldMIDIEditor> safeThis(this);
+    window->enterModalState(true, juce::ModalCallbackFunction::create([safeThis, report](int result)
+    {
+        if (result == 1)
+            juce::SystemClipboard::copyTextToClipboard(report);
+        else if (result == 2 && safeThis != nullptr)
+            safeThis->processor.getProfiler().reset();
+    }), true);
+}
+
+void StringFieldMIDIEditor::updateExportStatus()
+{
+    const auto& logger = processor.getMidiLogger();
+
+    if (processor.isExportingMidi())
+    {
+        exportButton.setButtonText("STOP EXPORT");
+        exportStatusLabel.setText("RECORDING", juce::dontSendNotification);
+        return;
+    }
+
+    exportButton.setButtonText("EXPORT MIDI");
+
+    // Overflowed events can't be recovered, so say how many were lost
+    juce::String status;
+    if (logger.getWrittenCount() > 0 || logger.getDroppedCount() > 0)
+    {
+        status = juce::String((juce::int64)logger.getWrittenCount()) + " EVENTS";
+        if (logger.getDroppedCount() > 0)
+            status += ", " + juce::String((juce::int64)logger.getDroppedCount()) + " DROPPED";
+    }
+    exportStatusLabel.setText(status, juce::dontSendNotification);
+}
+
 void StringFieldMIDIEditor::paint(juce::Graphics& g)
+{
+    // Re-rendered only after a resize or a move to a display with another scale
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (backgroundCache.isNull() || scale != backgroundScale)
+    {
+        backgroundCache = juce::Image(juce::Image::RGB,
+                                      juce::jmax(1, juce::roundToInt((float)getWidth() * scale)),
+                                      juce::jmax(1, juce::roundToInt((float)getHeight() * scale)),
+                                      false);
+        juce::Graphics backgroundGraphics(backgroundCache);
+        backgroundGraphics.addTransform(juce::AffineTransform::scale(scale));
+        paintBackground(backgroundGraphics);
+        backgroundScale = scale;
+    }
+
+    g.drawImage(backgroundCache, getLocalBounds().toFloat());
+}
+
+void StringFieldMIDIEditor::paintBackground(juce::Graphics& g)
 {
     auto bounds = getLocalBounds();
 
@@ -158,9 +358,24 @@ void StringFieldMIDIEditor::paint(juce::Graphics& g)
 
 void StringFieldMIDIEditor::resized()
 {
+    backgroundCache = {};
+
+    // Export controls sit inside the right end of the title plate
+    auto exportArea = juce::Rectangle<int>(getWidth() - 140, 19, 110, 22);
+    exportButton.setBounds(exportArea);
+    exportStatusLabel.setBounds(exportArea.translated(0, 22).withHeight(14).withTrimmedLeft(-40));
+    dinButton.setBounds(exportArea.translated(-64, 0).withWidth(58));
+    weightsButton.setBounds(30, 19, 80, 22);
+    statsButton.setBounds(116, 19, 60, 22);
+    ensembleButton.setBounds(182, 19, 80, 22);
+
     auto area = getLocalBounds().reduced(30);
     area.removeFromTop(55); // Title space
 
+    // Activity view along the bottom edge, PC controls above it
+    activityView.setBounds(area.removeFromBottom(110));
+    area.removeFromBottom(10);
+
     // Reserve space for PC controls at bottom
     auto pcControlsArea = area.removeFromBottom(70);
 
@@ -198,8 +413,10 @@ void StringFieldMIDIEditor::resized()
     setupKnob(routesSlider, routesLabel, 2, 1);
     setupKnob(memorySlider, memoryLabel, 2, 2);
 
-    // Row 4: Articulation (centered)
+    // Row 4: Voices, Articulation, Steal
+    setupKnob(voicesSlider, voicesLabel, 3, 0);
     setupKnob(articulationSlider, articulationLabel, 3, 1);
+    setupKnob(stealSlider, stealLabel, 3, 2);
 
     // PC controls at bottom (separate area)
     pcControlsArea.removeFromTop(10); // Spacing
@@ -225,6 +442,13 @@ void StringFieldMIDIEditor::resized()
 
     pcControlsArea.removeFromLeft(10); // Spacing
 
+    // Host grid division (small knob, 0 = free-running)
+    auto syncArea = pcControlsArea.removeFromLeft(70);
+    syncLabel.setBounds(syncArea.removeFromTop(16));
+    syncSlider.setBounds(syncArea.removeFromTop(45));
+
+    pcControlsArea.removeFromLeft(10); // Spacing
+
     // Tempo knob
     auto tempoArea = pcControlsArea.removeFromLeft(80);
     tempoLabel.setBounds(tempoArea.removeFromTop(16));
@@ -239,6 +463,20 @@ void StringFieldMIDIEditor::resized()
 
     pcControlsArea.removeFromLeft(10); // Spacing
 
+    // Conductor bus role (small knob)
+    auto conductorArea = pcControlsArea.removeFromLeft(70);
+    conductorLabel.setBounds(conductorArea.removeFromTop(16));
+    conductorSlider.setBounds(conductorArea.removeFromTop(45));
+
+    pcControlsArea.removeFromLeft(10); // Spacing
+
+    // Memory mode: Recent, Decay, Markov (small knob)
+    auto memoryModeArea = pcControlsArea.removeFromLeft(70);
+    memoryModeLabel.setBounds(memoryModeArea.removeFromTop(16));
+    memoryModeSlider.setBounds(memoryModeArea.removeFromTop(45));
+
+    pcControlsArea.removeFromLeft(10); // Spacing
+
     // PC Set text editor (rest of width)
     pcSetLabel.setBounds(pcControlsArea.removeFromTop(16));
     pcSetEditor.setBounds(pcControlsArea.removeFromTop(32).reduced(2, 2));
@@ -1,9 +1,15 @@
 #pragma once
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_audio_processors/juce_audio_processors.h>
+#include "ActivityView.h"
 #include "PluginProcessor.h"
+#include "ThrottledSliderAttachment.h"
 
-// Custom vintage LookAndFeel for rotary knobs
+// Custom vintage LookAndFeel for rotary knobs.
+//
+// The knob face (ring, body, highlight, ticks) never changes, so it is
+// rendered once per size and display scale into an image; each frame only
+// composites that image and draws the pointer and centre cap.
 class VintageLookAndFeel : public juce::LookAndFeel_V4
 {
 public:
@@ -15,13 +21,79 @@ public:
 
     void drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height,
                          float sliderPos, float rotaryStartAngle, float rotaryEndAngle,
-                         juce::Slider& slider) override
+                         juce::Slider&) override
     {
+        // Cached face at the pixel density of the target
+        const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        g.drawImage(getFace(width, height, scale, rotaryStartAngle, rotaryEndAngle),
+                    juce::Rectangle<int>(x, y, width, height).toFloat());
+
         auto radius = juce::jmin(width / 2, height / 2) - 8.0f;
         auto centreX = x + width * 0.5f;
         auto centreY = y + height * 0.5f;
         auto angle = rotaryStartAngle + sliderPos * (rotaryEndAngle - rotaryStartAngle);
 
+        // Pointer (brass indicator line)
+        auto pointerLength = radius * 0.65f;
+        auto pointerThickness = 3.0f;
+        juce::Path pointer;
+        pointer.addRectangle(-pointerThickness * 0.5f, -pointerLength, pointerThickness, pointerLength);
+        g.setColour(juce::Colour(0xFFFFBF00)); // Bright amber
+        g.fillPath(pointer, juce::AffineTransform::rotation(angle)
+                                                   .translated(centreX, centreY));
+
+        // Center cap
+        g.setColour(juce::Colour(0xFF1A1A1A));
+        g.fillEllipse(centreX - 6.0f, centreY - 6.0f, 12.0f, 12.0f);
+        g.setColour(juce::Colour(0xFFD4AF37));
+        g.drawEllipse(centreX - 6.0f, centreY - 6.0f, 12.0f, 12.0f, 1.0f);
+    }
+
+private:
+    struct KnobFace
+    {
+        int width = 0, height = 0;
+        float scale = 1.0f;
+        float startAngle = 0.0f, endAngle = 0.0f;
+        juce::Image image;
+    };
+
+    // A handful of knob sizes × the display scales in use
+    static constexpr size_t maxFaces = 16;
+    std::vector<KnobFace> faces;
+
+    const juce::Image& getFace(int width, int height, float scale, float startAngle, float endAngle)
+    {
+        for (const auto& face : faces)
+            if (face.width == width && face.height == height && face.scale == scale
+                && face.startAngle == startAngle && face.endAngle == endAngle)
+                return face.image;
+
+        if (faces.size() >= maxFaces)
+            faces.clear();
+
+        KnobFace face { width, height, scale, startAngle, endAngle,
+                        juce::Image(juce::Image::ARGB,
+                                    juce::jmax(1, juce::roundToInt((float)width * scale)),
+                                    juce::jmax(1, juce::roundToInt((float)height * scale)),
+                                    true) };
+        {
+            juce::Graphics faceGraphics(face.image);
+            faceGraphics.addTransform(juce::AffineTransform::scale(scale));
+            drawFace(faceGraphics, width, height, startAngle, endAngle);
+        }
+
+        faces.push_back(std::move(face));
+        return faces.back().image;
+    }
+
+    static void drawFace(juce::Graphics& g, int width, int height,
+                         float rotaryStartAngle, float rotaryEndAngle)
+    {
+        auto radius = juce::jmin(width / 2, height / 2) - 8.0f;
+        auto centreX = width * 0.5f;
+        auto centreY = height * 0.5f;
+
         // Outer ring (brushed brass)
         g.setColour(juce::Colour(0xFF8B7355)); // Dark brass
         g.fillEllipse(centreX - radius, centreY - radius, radius * 2.0f, radius * 2.0f);
@@ -57,21 +129,6 @@ public:
             ), 1.5f);
             g.strokePath(tick, juce::PathStrokeType(1.5f));
         }
-
-        // Pointer (brass indicator line)
-        juce::Path pointer;
-        auto pointerLength = radius * 0.65f;
-        auto pointerThickness = 3.0f;
-        pointer.addRectangle(-pointerThickness * 0.5f, -pointerLength, pointerThickness, pointerLength);
-        g.setColour(juce::Colour(0xFFFFBF00)); // Bright amber
-        g.fillPath(pointer, juce::AffineTransform::rotation(angle)
-                                                   .translated(centreX, centreY));
-
-        // Center cap
-        g.setColour(juce::Colour(0xFF1A1A1A));
-        g.fillEllipse(centreX - 6.0f, centreY - 6.0f, 12.0f, 12.0f);
-        g.setColour(juce::Colour(0xFFD4AF37));
-        g.drawEllipse(centreX - 6.0f, centreY - 6.0f, 12.0f, 12.0f, 1.0f);
     }
 };
 
@@ -89,6 +146,18 @@ public:
     void textEditorTextChanged(juce::TextEditor&) override;
 
 private:
+    // Static panel (gradient, texture, bezel, title plate, screws), drawn
+    // into backgroundCache at the display scale; invalidated by resized()
+    void paintBackground(juce::Graphics&);
+    juce::Image backgroundCache;
+    float backgroundScale = 0.0f;
+
+    void exportButtonClicked();
+    void updateExportStatus();
+    void weightsButtonClicked();
+    void ensembleButtonClicked();
+    void statsButtonClicked();
+
     StringFieldMIDIProcessor& processor;
 
     VintageLookAndFeel vintageLAF;
@@ -97,17 +166,43 @@ private:
     juce::Slider centerSlider, spreadSlider, velSlider;
     juce::Slider seedSlider, routesSlider, memorySlider;
     juce::Slider articulationSlider, pcModeSlider, pedalSlider;
-    juce::Slider pulseSlider, tempoSlider, regularitySlider;
+    juce::Slider pulseSlider, syncSlider, tempoSlider, regularitySlider;
+    juce::Slider voicesSlider, stealSlider, conductorSlider, memoryModeSlider;
 
     juce::Label rateLabel, densityLabel, energyLabel;
     juce::Label centerLabel, spreadLabel, velLabel;
     juce::Label seedLabel, routesLabel, memoryLabel;
     juce::Label articulationLabel, pcModeLabel, pcSetLabel, pedalLabel;
-    juce::Label pulseLabel, tempoLabel, regularityLabel;
+    juce::Label pulseLabel, syncLabel, tempoLabel, regularityLabel;
+    juce::Label voicesLabel, stealLabel, conductorLabel, memoryModeLabel;
 
     juce::TextEditor pcSetEditor;
 
-    using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+    // MIDI export
+    juce::TextButton exportButton;
+    juce::Label exportStatusLabel;
+    std::unique_ptr<juce::FileChooser> exportChooser;
+
+    // User pitch/route weights (edited in a popup)
+    juce::TextButton weightsButton { "WEIGHTS" };
+
+    // Ensemble size and per-player layout (edited in a popup)
+    juce::TextButton ensembleButton { "ENSEMBLE" };
+    juce::Slider playersSlider;
+
+    // Hot-path timings (instrumented builds only)
+    juce::TextButton statsButton { "STATS" };
+    juce::TextEditor statsText;
+
+    // Pace output at DIN MIDI speed (hardware synths)
+    juce::ToggleButton dinButton { "DIN" };
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> dinAttachment;
+
+    // Piano roll and route meters of what is being emitted
+    ActivityView activityView { processor.getActivityFeed(), [this] { return processor.getSampleRate(); } };
+
+    // Automation reaches the knobs at a capped frame rate
+    using SliderAttachment = ThrottledSliderAttachment;
 
     std::unique_ptr<SliderAttachment> rateAttachment;
     std::unique_ptr<SliderAttachment> densityAttachment;
@@ -120,10 +215,16 @@ private:
     std::unique_ptr<SliderAttachment> memoryAttachment;
     std::unique_ptr<SliderAttachment> articulationAttachment;
     std::unique_ptr<SliderAttachment> pulseAttachment;
+    std::unique_ptr<SliderAttachment> syncAttachment;
     std::unique_ptr<SliderAttachment> tempoAttachment;
     std::unique_ptr<SliderAttachment> regularityAttachment;
     std::unique_ptr<SliderAttachment> pcModeAttachment;
     std::unique_ptr<SliderAttachment> pedalAttachment;
+    std::unique_ptr<SliderAttachment> voicesAttachment;
+    std::unique_ptr<SliderAttachment> stealAttachment;
+    std::unique_ptr<SliderAttachment> conductorAttachment;
+    std::unique_ptr<SliderAttachment> memoryModeAttachment;
+    std::unique_ptr<SliderAttachment> playersAttachment;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StringFieldMIDIEditor)
 };
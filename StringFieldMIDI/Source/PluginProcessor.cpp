@@ -1,13 +1,12 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "Core/AllocationTrap.h"
 
 StringFieldMIDIProcessor::StringFieldMIDIProcessor()
     : AudioProcessor(BusesProperties()
                      .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
       apvts(*this, nullptr, "PARAMS", createParameters())
 {
-    rng.setSeed(1);
-
     // Set up default CC mappings (conductor-ready out of the box)
     // Using unused CC range 20-31 to avoid conflicts with standard controllers
     ccToParameterMap[20] = "rate";           // CC 20 → Rate
@@ -21,6 +20,15 @@ StringFieldMIDIProcessor::StringFieldMIDIProcessor()
     ccToParameterMap[28] = "pulse";          // CC 28 → Pulse
     ccToParameterMap[29] = "tempo";          // CC 29 → Tempo
     ccToParameterMap[30] = "regularity";     // CC 30 → Regularity
+    rebuildCCRouting();
+    conductorHandoff.publish(std::make_unique<ConductorFollowSettings>(conductorSettings));
+
+    for (auto* param : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+            apvts.addParameterListener(ranged->getParameterID(), this);
+
+    // Commits MIDI-learned mappings on the message thread
+    startTimerHz(20);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout
@@ -69,6 +77,10 @@ StringFieldMIDIProcessor::createParameters()
     params.push_back(std::make_unique<juce::AudioParameterFloat>(
         "regularity", "Regularity", 0.0f, 1.0f, 0.5f));
 
+    // Pulse grid locked to the host: 0=Free, 1=1/2, 2=1/4, 3=1/8, 4=1/8T, 5=1/16, 6=1/16T
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        "sync", "Pulse Sync", 0, 6, 0));
+
     // PC Mode: 0=Off, 1=Transpose, 2=Transpose+Invert
     params.push_back(std::make_unique<juce::AudioParameterInt>(
         "pcmode", "PC Mode", 0, 2, 0));
@@ -77,307 +89,125 @@ StringFieldMIDIProcessor::createParameters()
     params.push_back(std::make_unique<juce::AudioParameterInt>(
         "pedal", "Sustain Pedal", 0, 1, 1));  // Default ON
 
-    return { params.begin(), params.end() };
-}
-
-void StringFieldMIDIProcessor::prepareToPlay(double sampleRate, int)
-{
-    sr = sampleRate;
-    sampleCounter = 0;
-    nextNoteOnSample = 0;
-    activeNote = -1;
-    noteOffSample = 0;
-    wasPlaying = false;
-}
-
-void StringFieldMIDIProcessor::handleTransportStop(juce::MidiBuffer& midi)
-{
-    // Release sustain pedal on all channels
-    for (int ch = 1; ch <= 16; ++ch)
-    {
-        midi.addEvent(juce::MidiMessage::controllerEvent(ch, 64, 0), 0);  // Pedal up
-        midi.addEvent(juce::MidiMessage::controllerEvent(ch, 123, 0), 0); // All Notes Off
-        midi.addEvent(juce::MidiMessage::controllerEvent(ch, 120, 0), 0); // All Sound Off
-    }
-    activeNote = -1;
-    noteOffSample = 0;
-    pedalDown = false;
-    nextPedalChangeSample = 0;
-}
-
-int StringFieldMIDIProcessor::pickNote(int center, int spread)
-{
-    if (spread <= 0)
-        return juce::jlimit(0, 127, center);
-
-    int pcMode = (int)*apvts.getRawParameterValue("pcmode");
-
-    // === PITCH-CLASS SET MODE ===
-    if (pcMode > 0 && !pitchClassSet.empty())
-    {
-        // Check if set is exhausted
-        if (remainingPCs.empty())
-            transformPitchClassSet();  // Transform and reset
-
-        if (remainingPCs.empty())  // Fallback if still empty
-            return juce::jlimit(0, 127, center);
-
-        // Pick next pitch class from remaining set
-        int pitchClass = remainingPCs.back();
-        remainingPCs.pop_back();
-
-        // Map to MIDI note with octave memory
-        return mapPCToMIDI(pitchClass, center, spread);
-    }
-
-    // === CHROMATIC MODE ===
-    int lo = juce::jlimit(0, 127, center - spread);
-    int hi = juce::jlimit(0, 127, center + spread);
-
-    // Get parameters
-    int memorySize = (int)*apvts.getRawParameterValue("memory");
-    float energy = *apvts.getRawParameterValue("energy");
-
-    // MOTIVIC MEMORY MODE: Higher memory = more repetition of recent notes
-    // Scale memory strength by energy
-    // Low energy = strong repetition (motivic loops)
-    // High energy = weaker repetition (more exploration)
-    float memoryStrength = juce::jmap(energy, 0.0f, 1.0f, 1.0f, 0.3f);
+    // Polyphony: 1 = monophonic
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        "voices", "Voices", 1, stringfield::VoicePool::MaxVoices, 1));
 
-    // No memory: use simple random
-    if (memorySize <= 0 || recentNotes.empty())
-    {
-        int note = rng.nextInt(juce::Range<int>(lo, hi + 1));
+    // Voice stealing: 0=Oldest, 1=Quietest, 2=Same route
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        "steal", "Voice Stealing", 0, 2, 0));
 
-        // Store in memory for future
-        if (memorySize > 0)
-        {
-            recentNotes.push_back(note);
-            if ((int)recentNotes.size() > memorySize)
-                recentNotes.pop_front();
-        }
+    // Conductor bus: 0=Off, 1=Lead (publish), 2=Follow
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        "conductor", "Conductor", 0, 2, 0));
 
-        return note;
-    }
+    // Output: pace events at 31250-baud DIN MIDI speed (for hardware synths)
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        "dinlimit", "DIN Bandwidth", 0, 1, 0));
 
-    // With memory: FAVOR repeating recent notes (strength scaled by energy)
-    // Probability to repeat from memory vs pick something new
-    float repeatProbability = memoryStrength * 0.8f;  // 80% at low energy, 24% at high energy
+    // Ensemble: independent players in this instance (per-player layout is text state)
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        "players", "Players", 1, stringfield::Ensemble::MaxPlayers, 1));
 
-    int note;
-    if (rng.nextFloat() < repeatProbability && !recentNotes.empty())
-    {
-        // Pick randomly from recent notes (motivic repetition)
-        int memoryIndex = rng.nextInt(juce::Range<int>(0, (int)recentNotes.size()));
-        note = recentNotes[memoryIndex];
-    }
-    else
-    {
-        // Pick from full range (exploration)
-        note = rng.nextInt(juce::Range<int>(lo, hi + 1));
-    }
+    // Lookahead: generate this many ms ahead on a background thread (0 = in the callback)
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        "lookahead", "Lookahead", 0, stringfield::LookaheadGenerator::MaxDistanceMs, 0));
 
-    // Update memory
-    recentNotes.push_back(note);
-    if ((int)recentNotes.size() > memorySize)
-        recentNotes.pop_front();
+    // Memory mode: 0=Recent, 1=Decay (long, recency-weighted), 2=Markov (transitions)
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        "memmode", "Memory Mode", 0, 2, 0));
 
-    return note;
+    return { params.begin(), params.end() };
 }
 
-int StringFieldMIDIProcessor::pickVelocity(int baseVel)
+StringFieldMIDIProcessor::~StringFieldMIDIProcessor()
 {
-    int variation = rng.nextInt(juce::Range<int>(-10, 11));
-    return juce::jlimit(1, 127, baseVel + variation);
-}
+    for (auto* param : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+            apvts.removeParameterListener(ranged->getParameterID(), this);
 
-int StringFieldMIDIProcessor::pickArticulation(int numRoutes, float articulation, float energy)
-{
-    // Weighted distribution for articulation selection
-    // articulation (0.0-1.0): center of distribution
-    //   0.0 = favor channel 1 (legato, sustained)
-    //   0.5 = favor middle channels
-    //   1.0 = favor channel numRoutes (staccato, extreme)
-    // energy: controls spread width
-    //   Low energy = narrow focus (stay near center)
-    //   High energy = wide spread (explore many articulations)
-
-    if (numRoutes <= 1)
-        return 1;
-
-    // Map articulation to channel center (0-indexed: 0 to numRoutes-1)
-    float centerChannel = articulation * (float)(numRoutes - 1);
-
-    // Spread width controlled by energy
-    // Low energy (0.0): ±0.5 channel (very focused)
-    // High energy (1.0): ±(numRoutes-1) (full exploration)
-    float spreadWidth = juce::jmap(energy, 0.0f, 1.0f,
-                                    0.5f,
-                                    (float)(numRoutes - 1));
-
-    // Triangular distribution: sum of two random variables
-    // Creates a peak at center, falls off linearly
-    float r1 = rng.nextFloat() - 0.5f;  // -0.5 to 0.5
-    float r2 = rng.nextFloat() - 0.5f;
-    float offset = (r1 + r2) * spreadWidth;
-
-    float channelFloat = centerChannel + offset;
-
-    // Clamp and convert to 1-indexed MIDI channel
-    int channel = (int)std::round(channelFloat) + 1;
-    return juce::jlimit(1, numRoutes, channel);
+    conductorBus.releaseLeadership(this);
 }
 
-double StringFieldMIDIProcessor::calculateDuration(float energy)
+void StringFieldMIDIProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    // Low energy -> long notes (Feldman-ish)
-    double durationSec = juce::jmap((double)energy, 0.0, 1.0, 1.2, 0.08);
-    return durationSec * sr;
-}
+    ensemble.prepare(sampleRate);
+    ensemble.setProfiler(&profiler);
+    profiler.prepare(sampleRate);
+    currentSampleRate = sampleRate;
+    sampleCounter = 0;
+    wasPlaying = false;
 
-void StringFieldMIDIProcessor::schedulePedalChange(float energy, float density)
-{
-    // AUTOMATIC SUSTAIN PEDAL (Energy/Density controlled)
-    // Low energy + low density = pedal stays DOWN for long periods (creates chords/washes)
-    // High energy + high density = pedal rarely used (clean articulation)
+    // Starts the checkpoint worker (it sleeps until a locate needs it)
+    checkpoints.prepare(sampleRate);
+    locatePending = false;
 
-    // Calculate engagement probability
-    float engagementProb = (1.0f - energy) * density;
+    // Each MidiBuffer event takes 9 bytes (time + size + 3 data bytes). Leave room
+    // for transport-stop bursts and pedal fan-out on top of a generous
+    // per-sample event budget, plus the capped input passthrough.
+    midiReserveBytes = 9 * (512 + samplesPerBlock / 16) + passThroughBudgetBytes;
 
-    // Decide whether to use pedal at all
-    if (engagementProb < 0.15f)
-    {
-        // Very low engagement - schedule long OFF period
-        if (pedalDown)
-        {
-            pedalDown = false;
-            double offDurationSec = 5.0 + rng.nextDouble() * 10.0;  // 5-15 seconds off
-            nextPedalChangeSample = sampleCounter + (int64_t)(offDurationSec * sr);
-        }
-        else
-        {
-            nextPedalChangeSample = sampleCounter + (int64_t)(5.0 * sr);
-        }
-        return;
-    }
+    // Unmapped input is copied here when mapped CCs are consumed, then swapped in
+    passThroughMidi.ensureSize((size_t)midiReserveBytes);
 
-    if (pedalDown)
-    {
-        // Pedal is down - schedule when to lift it
-        // Low energy = long pedal down (many notes blend together)
-        // High energy = short pedal down (minimal blending)
-        double pedalDownDurationSec = juce::jmap((double)energy,
-                                                  0.0, 1.0,
-                                                  8.0, 0.5);  // 8 seconds to 0.5 seconds
-
-        // Add some randomness (±30%)
-        double variation = (rng.nextDouble() - 0.5) * 0.6 * pedalDownDurationSec;
-        pedalDownDurationSec = juce::jmax(0.5, pedalDownDurationSec + variation);
-
-        nextPedalChangeSample = sampleCounter + (int64_t)(pedalDownDurationSec * sr);
-    }
-    else
-    {
-        // Pedal is up - schedule when to press it
-        // At low energy, short gaps between pedal phrases
-        // At high energy, longer gaps (pedal rarely engaged)
-        double pedalUpDurationSec = juce::jmap((double)energy,
-                                                0.0, 1.0,
-                                                1.0, 5.0);  // 1 second to 5 seconds
-
-        // Add some randomness
-        double variation = (rng.nextDouble() - 0.5) * 0.6 * pedalUpDurationSec;
-        pedalUpDurationSec = juce::jmax(0.5, pedalUpDurationSec + variation);
-
-        nextPedalChangeSample = sampleCounter + (int64_t)(pedalUpDurationSec * sr);
-    }
+    outputShaper.prepare(sampleRate);
+
+    // Restarts the worker thread if lookahead is on (none while the host has us
+    // released; timerCallback starts and stops it as the parameter moves)
+    lookahead.setEnabled(lookaheadMs->load(std::memory_order_relaxed) > 0.5f);
+    lookahead.prepare(sampleRate);
+    lookaheadActive = false;
 }
 
-void StringFieldMIDIProcessor::scheduleNextNote(double bpm, double ppqPos)
+namespace
 {
-    // === PULSE MODE ===
-    bool pulseEnabled = *apvts.getRawParameterValue("pulse") > 0.5f;
-
-    if (pulseEnabled)
+    // Writes shaped output to the host's MidiBuffer (and the export logger)
+    struct MidiBufferSink : stringfield::EventSink
     {
-        float tempo = *apvts.getRawParameterValue("tempo");
-        float regularity = *apvts.getRawParameterValue("regularity");
-
-        // Beat interval in seconds
-        double beatInterval = 60.0 / juce::jmax(40.0f, tempo);
-
-        // Regularity controls variance:
-        // High regularity (1.0) = strict tempo, minimal variance (±5%)
-        // Low regularity (0.0) = high variance (±100%), tempo not perceivable
-        float varianceAmount = juce::jmap(regularity, 0.0f, 1.0f, 1.0f, 0.05f);
-
-        // Random variance around beat interval
-        double variance = (rng.nextDouble() - 0.5) * 2.0 * varianceAmount * beatInterval;
-        double intervalSec = juce::jmax(0.05, beatInterval + variance);
-
-        nextNoteOnSample = sampleCounter + (int64_t)(intervalSec * sr);
-        return;
-    }
+        MidiBufferSink(juce::MidiBuffer& b, stringfield::MidiEventLogger* l,
+                       stringfield::ActivityFeed& f, int64_t start)
+            : buffer(b), logger(l), feed(f), blockStart(start) {}
 
-    // === RATE MODE (original behavior) ===
-    float rate = *apvts.getRawParameterValue("rate");
-    float energy = *apvts.getRawParameterValue("energy");
-    int memorySize = (int)*apvts.getRawParameterValue("memory");
+        void handleEvent(const stringfield::MidiEvent& e) override
+        {
+            buffer.addEvent(e.data, e.size, e.offset);
+            feed.push(e, blockStart + e.offset);
+            ++numEvents;
 
-    double baseInterval = 1.0 / juce::jmax(0.001f, rate);
+            if (logger != nullptr)
+                logger->log(e);
+        }
 
-    // RHYTHMIC MEMORY MODE: Higher memory = more repetition of recent rhythms
-    // Low energy = strong rhythmic repetition (ostinato patterns)
-    // High energy = weaker repetition (more varied rhythm)
-    float memoryStrength = juce::jmap(energy, 0.0f, 1.0f, 1.0f, 0.3f);
+        juce::MidiBuffer& buffer;
+        stringfield::MidiEventLogger* logger;   // nullptr when not exporting
+        stringfield::ActivityFeed& feed;
+        int64_t blockStart;
+        int numEvents = 0;
+    };
 
-    // No rhythm memory: use simple jitter
-    if (memorySize <= 0 || recentIntervals.empty())
+    // Engine output → output shaper, offsets made relative to the block
+    struct ShaperSink : stringfield::EventSink
     {
-        double jitter = (rng.nextDouble() - 0.5) * (energy * baseInterval);
-        double intervalSec = juce::jmax(0.001, baseInterval + jitter);
+        ShaperSink(stringfield::OutputShaper& s, stringfield::EventSink& p)
+            : shaper(s), port(p) {}
 
-        // Store in rhythm memory for future
-        if (memorySize > 0)
+        void handleEvent(const stringfield::MidiEvent& e) override
         {
-            recentIntervals.push_back(intervalSec);
-            int rhythmMemorySize = juce::jmax(1, memorySize / 2);  // Rhythm memory is half of pitch memory
-            if ((int)recentIntervals.size() > rhythmMemorySize)
-                recentIntervals.pop_front();
+            auto shifted = e;
+            shifted.offset += blockOffset;
+            shaper.handleEvent(shifted, port);
         }
 
-        nextNoteOnSample = sampleCounter + (int64_t)(intervalSec * sr);
-        return;
-    }
-
-    // With rhythm memory: FAVOR repeating recent intervals (strength scaled by energy)
-    int rhythmMemorySize = juce::jmax(1, memorySize / 2);
-    float repeatProbability = memoryStrength * 0.75f;  // 75% at low energy, 22.5% at high energy
-
-    double intervalSec;
-    if (rng.nextFloat() < repeatProbability && !recentIntervals.empty())
-    {
-        // Pick from recent intervals (rhythmic ostinato)
-        int memoryIndex = rng.nextInt(juce::Range<int>(0, (int)recentIntervals.size()));
-        intervalSec = recentIntervals[memoryIndex];
+        stringfield::OutputShaper& shaper;
+        stringfield::EventSink& port;
+        int blockOffset = 0;        // Start of the current sub-block
+    };
 
-        // Add slight variation (±10%) to avoid mechanical feel
-        double variation = (rng.nextDouble() - 0.5) * 0.2 * intervalSec;
-        intervalSec = juce::jmax(0.001, intervalSec + variation);
-    }
-    else
+    // Ensemble updates while the lookahead worker generates the output
+    struct DiscardSink : stringfield::EventSink
     {
-        // Pick new interval (exploration)
-        double jitter = (rng.nextDouble() - 0.5) * (energy * baseInterval);
-        intervalSec = juce::jmax(0.001, baseInterval + jitter);
-    }
-
-    // Update rhythm memory
-    recentIntervals.push_back(intervalSec);
-    if ((int)recentIntervals.size() > rhythmMemorySize)
-        recentIntervals.pop_front();
-
-    nextNoteOnSample = sampleCounter + (int64_t)(intervalSec * sr);
+        void handleEvent(const stringfield::MidiEvent&) override {}
+    };
 }
 
 void StringFieldMIDIProcessor::processBlock(
@@ -387,10 +217,22 @@ void StringFieldMIDIProcessor::processBlock(
     juce::ScopedNoDenormals noDenormals;
     buffer.clear();
 
+    // The host owns midiMessages, so it can't be reserved in prepareToPlay.
+    // Grow whichever buffer arrives short; hosts usually reuse one, so this
+    // happens once, but one that hands over a new buffer gets it grown too.
+    if (midiMessages.data.getNumAllocated() < midiReserveBytes)
+        midiMessages.ensureSize((size_t)midiReserveBytes);
+
+    // No heap use from here on. The scope only traps in executables that link
+    // the allocation trap; the plugin never replaces the host's allocator.
+    stringfield::ScopedNoAllocation noAllocation;
+    profiler.beginBlock();
+
     // === Read Playhead ===
     bool isPlaying = false;
+    int64_t hostTime = sampleCounter;
     double bpm = 120.0;
-    double ppqPos = 0.0;
+    juce::Optional<double> ppq;
 
     if (auto* playhead = getPlayHead())
     {
@@ -398,393 +240,519 @@ void StringFieldMIDIProcessor::processBlock(
         if (posInfo.hasValue())
         {
             isPlaying = posInfo->getIsPlaying();
-            auto bpmVal = posInfo->getBpm();
-            if (bpmVal.hasValue())
-                bpm = *bpmVal;
-            auto ppqVal = posInfo->getPpqPosition();
-            if (ppqVal.hasValue())
-                ppqPos = *ppqVal;
+
+            if (auto time = posInfo->getTimeInSamples())
+                hostTime = *time;
+            if (auto hostBpm = posInfo->getBpm())
+                bpm = juce::jmax(1.0, *hostBpm);
+            ppq = posInfo->getPpqPosition();
         }
     }
 
-    // === Seed Handling ===
-    int seed = (int)*apvts.getRawParameterValue("seed");
-    if (seed != lastSeed)
+    // Offline renders run faster than the worker could stay ahead, and the
+    // in-callback generator is exact there anyway. The worker thread comes
+    // up on the message thread shortly after the parameter is turned on.
+    const bool useLookahead = lookaheadMs->load(std::memory_order_relaxed) > 0.5f
+                              && lookahead.isRunning() && ! isNonRealtime();
+    const bool switched = useLookahead != lookaheadActive;
+
+    // Starting the transport or jumping while playing (locate, cycle) puts
+    // the generator in the state it has at the host position. So does
+    // switching generators, which silences the previous one first.
+    const bool located = isPlaying && (! wasPlaying || hostTime != sampleCounter || switched);
+    const bool silence = wasPlaying && ! switched;
+    const auto checkpointSpacing = (int64_t)(checkpointBeats * 60.0 / bpm * currentSampleRate);
+    sampleCounter = hostTime;
+
+    // === MIDI Learn / CC Processing ===
+    // Adopt the newest routing table, then read the input CCs before the
+    // engine starts adding to the same buffer
     {
-        rng.setSeed((int64_t)seed);
-        lastSeed = seed;
-        nextNoteOnSample = sampleCounter;
+        stringfield::ScopedStageTimer timer(&profiler, stringfield::HotPathStage::Controllers);
+        ccRoutingHandoff.receive();
+        collectCCChanges(midiMessages);
     }
 
-    // === MIDI Learn / CC Processing ===
-    for (const juce::MidiMessageMetadata metadata : midiMessages)
+    // === Parameters ===
+    const int numSamples = buffer.getNumSamples();
+
+    MidiBufferSink port(midiMessages, midiLogger.isRecording() ? &midiLogger : nullptr, activityFeed, sampleCounter);
+    outputShaper.setBandwidthLimit(dinLimit->load(std::memory_order_relaxed) > 0.5f);
+    outputShaper.beginBlock(numSamples, port);
+
+    ShaperSink sink(outputShaper, port);
+
+    // In lookahead mode the ensemble here only keeps up with the state (for
+    // checkpoints and switching back); the worker's copy makes the output
+    DiscardSink discard;
+    stringfield::EventSink& ensembleSink = useLookahead ? static_cast<stringfield::EventSink&>(discard)
+                                                        : static_cast<stringfield::EventSink&>(sink);
+    lookahead.setDistance(lookaheadMs->load(std::memory_order_relaxed));
+    bool stateChanged = false;
     {
-        const juce::MidiMessage& message = metadata.getMessage();
+        stringfield::ScopedStageTimer timer(&profiler, stringfield::HotPathStage::Parameters);
+
+        if (updateBlockParameters(ensembleSink))
+            stateChanged = true;
 
-        if (message.isController())
+        // Adopt a newly compiled PC set (the replaced one is freed on the
+        // message thread once the background workers are done with it too)
+        if (auto* pcSet = pcSetHandoff.receiveKeepingPrevious())
         {
-            int ccNumber = message.getControllerNumber();
-            int ccValue = message.getControllerValue();
+            ensemble.setPitchClassSet(pcSet);
+            stateChanged = true;
+        }
 
-            // MIDI Learn mode: map this CC to the learning parameter
-            if (midiLearnEnabled && !midiLearnParameterID.isEmpty())
-            {
-                ccToParameterMap[ccNumber] = midiLearnParameterID;
-                midiLearnEnabled = false;
-                midiLearnParameterID = "";
-            }
-            // Normal mode: apply CC to mapped parameter
-            else if (ccToParameterMap.find(ccNumber) != ccToParameterMap.end())
-            {
-                juce::String paramID = ccToParameterMap[ccNumber];
-                auto* param = apvts.getParameter(paramID);
-
-                if (param != nullptr)
-                {
-                    // Normalize CC value (0-127) to parameter range (0.0-1.0)
-                    float normalizedValue = ccValue / 127.0f;
-                    param->setValueNotifyingHost(normalizedValue);
-                }
-            }
+        // Adopt new user weights (likewise)
+        if (auto* weights = weightsHandoff.receiveKeepingPrevious())
+        {
+            ensemble.setWeightProfile(weights);
+            stateChanged = true;
         }
-    }
 
-    // === Sustain Pedal Parameter Change ===
-    bool pedalParamOn = *apvts.getRawParameterValue("pedal") > 0.5f;
-    if (pedalParamOn != lastPedalParamState)
-    {
-        // When disabling pedal: immediately release on all channels
-        if (!pedalParamOn && lastPedalParamState)
+        // Adopt a new ensemble layout (likewise)
+        if (auto* layout = ensembleHandoff.receiveKeepingPrevious())
         {
-            for (int ch = 1; ch <= 16; ++ch)
-                midiMessages.addEvent(juce::MidiMessage::controllerEvent(ch, 64, 0), 0);
-            pedalDown = false;
-            nextPedalChangeSample = 0;
+            ensemble.setLayout(layout, sampleCounter, ensembleSink);
+            stateChanged = true;
         }
-        // When enabling pedal: let the algorithm schedule it (judicious application)
-        // No immediate action needed - scheduleNextNote will handle it
 
-        lastPedalParamState = pedalParamOn;
+        if (stateChanged)
+        {
+            checkpoints.invalidate();
+            lookahead.update(getGeneratorState(), sampleCounter);
+        }
     }
 
-    // === Transport Stop ===
-    if (wasPlaying && !isPlaying)
-        handleTransportStop(midiMessages);
+    // === Transport ===
+    // Stopping, or handing over to the other generator, releases what the
+    // one that was playing left sounding
+    if (wasPlaying && (! isPlaying || switched))
+    {
+        if (lookaheadActive)
+            lookahead.stop(sink);
+        else
+            ensemble.stop(sink);
+    }
 
-    wasPlaying = isPlaying;
+    lookaheadActive = useLookahead;
 
-    if (!isPlaying)
+    // Synced pulses follow the host grid (the engine keeps its tempo map
+    // while the host agrees with it, and re-times pending onsets otherwise)
+    stringfield::TransportPosition transport { sampleCounter, ppq.hasValue() ? *ppq : 0.0, bpm };
+    const bool hasTransport = isPlaying && ppq.hasValue();
+
+    if (located)
     {
-        sampleCounter += buffer.getNumSamples();
-        return;
+        stringfield::ScopedStageTimer timer(&profiler, stringfield::HotPathStage::Locate);
+
+        if (useLookahead)
+            lookahead.start(getGeneratorState(), sampleCounter, checkpointSpacing,
+                            hasTransport ? &transport : nullptr, silence, sink);
+        else
+            locatePending = ! locate(sampleCounter, checkpointSpacing, silence, hasTransport ? &transport : nullptr, sink);
+    }
+    else if (locatePending && isPlaying && ! useLookahead)
+    {
+        // Still waiting for checkpoints: try again at the new host position
+        stringfield::ScopedStageTimer timer(&profiler, stringfield::HotPathStage::Locate);
+        locatePending = ! locate(sampleCounter, checkpointSpacing, false, hasTransport ? &transport : nullptr, sink);
     }
 
-    // === Event Generation ===
-    const int numSamples = buffer.getNumSamples();
-    const int64_t blockStart = sampleCounter;
-    const int64_t blockEnd = sampleCounter + numSamples;
+    if (! isPlaying || useLookahead)
+        locatePending = false;
 
-    // Initialize schedulers if needed
-    if (nextNoteOnSample <= blockStart)
-        scheduleNextNote(bpm, ppqPos);
+    const bool generating = isPlaying && ! locatePending;
 
-    // Check if sustain pedal is enabled
-    int pedalEnabled = (int)*apvts.getRawParameterValue("pedal");
+    if (hasTransport)
+    {
+        if (useLookahead)
+            lookahead.setTransport(transport);
+        else
+            ensemble.setTransport(transport);
+    }
+
+    wasPlaying = isPlaying;
 
-    if (pedalEnabled > 0)
+    // === Event Generation ===
+    // Mapped CCs split the block: the engine renders up to each CC's offset,
+    // then continues with the new value. (The lookahead worker takes them
+    // all at its next chunk boundary.)
+    int position = 0;
+
+    for (int i = 0; i < numCCChanges; ++i)
     {
-        if (nextPedalChangeSample <= blockStart)
+        const auto& change = ccChanges[(size_t)i];
+        const int offset = juce::jlimit(0, numSamples, change.offset);
+
+        if (generating && ! useLookahead && offset > position)
         {
-            float energy = *apvts.getRawParameterValue("energy");
-            float density = *apvts.getRawParameterValue("density");
-            schedulePedalChange(energy, density);
+            sink.blockOffset = position;
+            ensemble.render(sampleCounter + position, offset - position, sink);
+            position = offset;
         }
 
-        // 1. Handle sustain pedal changes
-        if (nextPedalChangeSample >= blockStart && nextPedalChangeSample < blockEnd)
-        {
-            int offset = (int)(nextPedalChangeSample - blockStart);
+        ParamSnapshot::apply(blockParams, change.route.index,
+                             change.route.parameter->convertFrom0to1(change.normalised));
+        sink.blockOffset = offset;
+        ensemble.setParameters(blockParams, sampleCounter + offset, ensembleSink);
+        checkpoints.invalidate();
 
-            // Toggle pedal state and send CC 64
-            pedalDown = !pedalDown;
-            int pedalValue = pedalDown ? 127 : 0;
+        // Keeps host automation and the GUI in step (the snapshot picks the
+        // same value up next block). Host wrappers may allocate here.
+        stringfield::ScopedAllocationAllowed hostCall;
+        change.route.parameter->setValueNotifyingHost(change.normalised);
+    }
 
-            // Send to all channels (sustain is global)
-            for (int ch = 1; ch <= 16; ++ch)
-            {
-                midiMessages.addEvent(
-                    juce::MidiMessage::controllerEvent(ch, 64, pedalValue),
-                    offset
-                );
-            }
+    sink.blockOffset = 0;
 
-            // Schedule next pedal change
-            float energy = *apvts.getRawParameterValue("energy");
-            float density = *apvts.getRawParameterValue("density");
-            schedulePedalChange(energy, density);
-        }
-    }
+    if (numCCChanges > 0)
+        lookahead.update(getGeneratorState(), sampleCounter);
 
-    // 2. Emit note-off if scheduled
-    if (activeNote >= 0 &&
-        noteOffSample >= blockStart &&
-        noteOffSample < blockEnd)
+    if (useLookahead)
     {
-        int offset = (int)(noteOffSample - blockStart);
-        midiMessages.addEvent(
-            juce::MidiMessage::noteOff(activeChannel, activeNote),
-            offset
-        );
-        activeNote = -1;
-        noteOffSample = 0;
+        stringfield::ScopedStageTimer timer(&profiler, stringfield::HotPathStage::Playout);
+        if (isPlaying)
+            lookahead.play(sampleCounter, numSamples, sink);
+        else
+            lookahead.discard();
     }
-
-    // 3. Emit note-on if scheduled (with density check)
-    if (nextNoteOnSample >= blockStart && nextNoteOnSample < blockEnd)
+    else
     {
-        float density = *apvts.getRawParameterValue("density");
+        // Whatever a worker that was just switched off still sends
+        lookahead.discard();
 
-        // Density probabilistic gating
-        if (rng.nextFloat() <= density)
+        if (generating && position < numSamples)
         {
-            int center = (int)*apvts.getRawParameterValue("center");
-            int spread = (int)*apvts.getRawParameterValue("spread");
-            int baseVel = (int)*apvts.getRawParameterValue("vel");
-            int numRoutes = (int)*apvts.getRawParameterValue("routes");
-            float energy = *apvts.getRawParameterValue("energy");
-            float articulation = *apvts.getRawParameterValue("articulation");
-
-            int note = pickNote(center, spread);
-            int vel = pickVelocity(baseVel);
-            int channel = pickArticulation(numRoutes, articulation, energy);
-            int offset = (int)(nextNoteOnSample - blockStart);
-
-            // MONOPHONIC: Force note-off on previous note before starting new one
-            if (activeNote >= 0)
-            {
-                // If switching channels, release sustain pedal on old channel first
-                // This ensures true monophonic behavior across articulations
-                if (channel != activeChannel && pedalDown)
-                {
-                    midiMessages.addEvent(
-                        juce::MidiMessage::controllerEvent(activeChannel, 64, 0),
-                        offset
-                    );
-                }
-
-                midiMessages.addEvent(
-                    juce::MidiMessage::noteOff(activeChannel, activeNote),
-                    offset
-                );
-            }
-
-            midiMessages.addEvent(
-                juce::MidiMessage::noteOn(channel, note, (juce::uint8)vel),
-                offset
-            );
-
-            // Schedule note-off
-            double duration = calculateDuration(energy);
-            noteOffSample = nextNoteOnSample + (int64_t)duration;
-            activeNote = note;
-            activeChannel = channel;
+            sink.blockOffset = position;
+            ensemble.render(sampleCounter + position, numSamples - position, sink);
         }
 
-        // Schedule next event
-        scheduleNextNote(bpm, ppqPos);
+        if (generating)
+            checkpoints.capture(ensemble, sampleCounter + numSamples, checkpointSpacing);
     }
 
+    // Objects the previous state pointed to go once neither worker can go back to it
+    if (lookahead.isCurrent() && checkpoints.isCurrent())
+    {
+        pcSetHandoff.releasePrevious();
+        weightsHandoff.releasePrevious();
+        ensembleHandoff.releasePrevious();
+    }
+
+    publishToConductorBus();
+
     sampleCounter += numSamples;
+    midiLogger.advance(numSamples);
+
+    profiler.endBlock(numSamples, port.numEvents,
+                      outputShaper.getNumDropped() + midiLogger.getDroppedCount() + passThroughDropped);
 }
 
-// === Pitch-Class Set Helper Functions ===
+bool StringFieldMIDIProcessor::locate(int64_t time, int64_t spacing, bool silence,
+                                      const stringfield::TransportPosition* transport,
+                                      stringfield::EventSink& sink)
+{
+    // Release whatever was sounding at the old position
+    if (silence)
+        ensemble.stop(sink);
+
+    // Checkpoints for a new state are built off the audio thread; until they
+    // reach `time` this may come from the old ones or have to wait. An
+    // offline render has the time to generate the path here, exactly.
+    if (! checkpoints.restore(ensemble, getGeneratorState(), time, spacing, transport, isNonRealtime()))
+        return false;
+
+    ensemble.sendControllerState(sink);
+    return true;
+}
 
-void StringFieldMIDIProcessor::parsePitchClassSet(const juce::String& pcString)
+bool StringFieldMIDIProcessor::updateBlockParameters(stringfield::EventSink& sink)
 {
-    pitchClassSet.clear();
-    remainingPCs.clear();
-    pcToMidiMap.clear();
+    // One snapshot per block from cached pointers. The engine only sees (and
+    // checks seed/pedal edges) when something changed: a local parameter, the
+    // follow settings, the conductor role or a new conductor frame.
+    bool changed = paramSnapshot.update() != 0;
 
-    if (pcString.isEmpty())
-        return;
+    if (conductorHandoff.receive() != nullptr)
+        changed = true;
 
-    // Parse pitch-class notation: 0-9, A=10, B=11
-    for (int i = 0; i < pcString.length(); ++i)
+    const int role = (int)conductorRole->load(std::memory_order_relaxed);
+    if (role != lastConductorRole)
     {
-        juce::juce_wchar ch = pcString[i];
-        int pc = -1;
-
-        if (ch >= '0' && ch <= '9')
-            pc = ch - '0';
-        else if (ch == 'A' || ch == 'a')
-            pc = 10;
-        else if (ch == 'B' || ch == 'b')
-            pc = 11;
-
-        if (pc >= 0 && pc <= 11)
+        if (lastConductorRole == RoleLead)
         {
-            // Avoid duplicates
-            if (std::find(pitchClassSet.begin(), pitchClassSet.end(), pc) == pitchClassSet.end())
-                pitchClassSet.push_back(pc);
+            conductorBus.releaseLeadership(this);
+            leading = false;
         }
+
+        conductorFrame = {};              // Re-read from scratch when following
+        lastConductorRole = role;
+        changed = true;
     }
 
-    // Initialize remaining PCs (randomized order for exhaustion)
-    remainingPCs = pitchClassSet;
+    const bool following = role == RoleFollow;
+    if (following && conductorBus.read(conductorFrame))
+        changed = true;
 
-    // Fisher-Yates shuffle using juce::Random
-    for (int i = (int)remainingPCs.size() - 1; i > 0; --i)
-    {
-        int j = rng.nextInt(i + 1);
-        std::swap(remainingPCs[i], remainingPCs[j]);
-    }
+    if (! changed)
+        return false;
 
-    lastPCSetString = pcString;
+    blockParams = paramSnapshot.get();
+
+    const auto* settings = conductorHandoff.getCurrent();
+    if (following && settings != nullptr && conductorFrame.sequence != 0)
+        settings->applyTo(blockParams, conductorFrame);
+
+    ensemble.setParameters(blockParams, sampleCounter, sink);
+    return true;
 }
 
-void StringFieldMIDIProcessor::transformPitchClassSet()
+stringfield::GeneratorState StringFieldMIDIProcessor::getGeneratorState() const
 {
-    if (pitchClassSet.empty())
+    stringfield::GeneratorState state;
+    state.params = blockParams;
+    state.layout = ensembleHandoff.getCurrent();
+    state.pcSet = pcSetHandoff.getCurrent();
+    state.weights = weightsHandoff.getCurrent();
+    return state;
+}
+
+void StringFieldMIDIProcessor::publishToConductorBus()
+{
+    if (lastConductorRole != RoleLead)
+        return;
+
+    // Retried every block, so a waiting leader takes over when the current one leaves
+    if (! conductorBus.claimLeadership(this))
         return;
 
-    int pcMode = (int)*apvts.getRawParameterValue("pcmode");
+    float values[ParamSnapshot::numParams];
+    bool dirty = ! leading;
 
-    if (pcMode == 1)
+    for (int i = 0; i < ParamSnapshot::numParams; ++i)
     {
-        // Transpose only (Tn)
-        int transposition = rng.nextInt(12);  // T0 to T11
-        for (int& pc : pitchClassSet)
-            pc = (pc + transposition) % 12;
+        values[i] = ParamSnapshot::valueOf(blockParams, i);
+        dirty = dirty || values[i] != publishedValues[i];
     }
-    else if (pcMode == 2)
+
+    if (dirty && conductorBus.publish(values, ParamSnapshot::numParams))
     {
-        // Transpose + Invert (TnI)
-        bool invert = rng.nextBool();
-        int transposition = rng.nextInt(12);
+        std::copy(std::begin(values), std::end(values), std::begin(publishedValues));
+        leading = true;
+    }
+}
 
-        if (invert)
+void StringFieldMIDIProcessor::collectCCChanges(juce::MidiBuffer& midiMessages)
+{
+    numCCChanges = 0;
+    const auto* table = ccRoutingHandoff.getCurrent();
+
+    // Everything except the CCs used here passes through to the instrument, up
+    // to passThroughBudgetBytes; a flood beyond that is dropped rather than
+    // growing the buffer on the audio thread
+    passThroughMidi.clear();
+    bool consumed = false;
+    bool truncated = false;
+
+    auto passThrough = [this, &truncated](const juce::MidiMessageMetadata& metadata)
+    {
+        const int eventBytes = (int)(sizeof(int32_t) + sizeof(uint16_t)) + metadata.numBytes;
+        if (passThroughMidi.data.size() + eventBytes > passThroughBudgetBytes)
         {
-            for (int& pc : pitchClassSet)
-                pc = (12 - pc + transposition) % 12;  // Inversion then transposition
+            ++passThroughDropped;
+            truncated = true;
+            return;
         }
-        else
+
+        passThroughMidi.addEvent(metadata.data, metadata.numBytes, metadata.samplePosition);
+    };
+
+    for (const juce::MidiMessageMetadata metadata : midiMessages)
+    {
+        const juce::MidiMessage& message = metadata.getMessage();
+
+        if (! message.isController())
         {
-            for (int& pc : pitchClassSet)
-                pc = (pc + transposition) % 12;
+            passThrough(metadata);
+            continue;
         }
-    }
 
-    // Re-shuffle for new exhaustion cycle
-    remainingPCs = pitchClassSet;
+        const int ccNumber = message.getControllerNumber();
 
-    // Fisher-Yates shuffle using juce::Random
-    for (int i = (int)remainingPCs.size() - 1; i > 0; --i)
-    {
-        int j = rng.nextInt(i + 1);
-        std::swap(remainingPCs[i], remainingPCs[j]);
-    }
+        // MIDI Learn mode: catch this CC, timerCallback maps it to the learning parameter
+        if (midiLearnEnabled.exchange(false, std::memory_order_acq_rel))
+        {
+            pendingLearnCC.store(ccNumber, std::memory_order_release);
+            consumed = true;
+            continue;
+        }
 
-    // Clear octave memory on transformation
-    pcToMidiMap.clear();
-}
+        const auto* route = table != nullptr ? &table->get(message.getChannel(), ccNumber) : nullptr;
+        if (route == nullptr || route->parameter == nullptr)
+        {
+            passThrough(metadata);
+            continue;
+        }
 
-int StringFieldMIDIProcessor::mapPCToMIDI(int pitchClass, int center, int spread)
-{
-    int lo = juce::jlimit(0, 127, center - spread);
-    int hi = juce::jlimit(0, 127, center + spread);
+        consumed = true;
 
-    // Check if we've already assigned a MIDI note to this PC (octave memory)
-    auto it = pcToMidiMap.find(pitchClass);
-    if (it != pcToMidiMap.end())
-    {
-        int midiNote = it->second;
-        // Make sure it's still in range
-        if (midiNote >= lo && midiNote <= hi)
-            return midiNote;
-    }
+        // Coalesce: a later CC for the same parameter replaces the earlier one
+        // and moves to the back, so the list stays ordered by offset
+        int slot = 0;
+        while (slot < numCCChanges && ccChanges[(size_t)slot].route.index != route->index)
+            ++slot;
 
-    // Find all valid MIDI notes matching this pitch class within range
-    std::vector<int> candidates;
-    for (int note = lo; note <= hi; ++note)
-    {
-        if (note % 12 == pitchClass)
-            candidates.push_back(note);
-    }
+        if (slot < numCCChanges)
+        {
+            for (int i = slot + 1; i < numCCChanges; ++i)
+                ccChanges[(size_t)(i - 1)] = ccChanges[(size_t)i];
+            --numCCChanges;
+        }
 
-    if (candidates.empty())
-    {
-        // Fallback: find closest note with this PC
-        for (int note = center; note >= 0; --note)
-            if (note % 12 == pitchClass) { candidates.push_back(note); break; }
-        for (int note = center; note <= 127; ++note)
-            if (note % 12 == pitchClass) { candidates.push_back(note); break; }
+        auto& change = ccChanges[(size_t)numCCChanges++];
+        change.offset = metadata.samplePosition;
+        change.normalised = message.getControllerValue() / 127.0f;  // 0-127 → 0.0-1.0
+        change.route = *route;
     }
 
-    if (candidates.empty())
-        return center;  // Emergency fallback
+    jassert(passThroughMidi.data.size() <= passThroughBudgetBytes);
 
-    // Randomly pick octave
-    int chosenNote = candidates[rng.nextInt((int)candidates.size())];
+    // Swapping keeps both buffers' storage, so nothing reallocates. A truncated
+    // flood swaps too, so the output added later fits the reserve.
+    if (consumed || truncated)
+        midiMessages.swapWith(passThroughMidi);
+}
 
-    // Store in memory
-    pcToMidiMap[pitchClass] = chosenNote;
+void StringFieldMIDIProcessor::rebuildCCRouting()
+{
+    ccRoutingHandoff.publish(CCRoutingTable::build(ccToParameterMap, apvts));
+    markStateDirty();
+}
 
-    return chosenNote;
+void StringFieldMIDIProcessor::setPitchClassSet(const juce::String& pcString)
+{
+    pcSetHandoff.publish(stringfield::CompiledPitchClassSet::compile(pcString.toStdString()));
+    lastPCSetString = pcString;
+    markStateDirty();
 }
 
-void StringFieldMIDIProcessor::getStateInformation(juce::MemoryBlock& destData)
+void StringFieldMIDIProcessor::setWeightProfile(const juce::String& pitchWeights, const juce::String& routeWeights)
 {
-    auto state = apvts.copyState();
+    weightsHandoff.publish(stringfield::CompiledWeightProfile::compile(pitchWeights.toStdString(),
+                                                                       routeWeights.toStdString()));
+    lastPitchWeights = pitchWeights;
+    lastRouteWeights = routeWeights;
+    markStateDirty();
+}
 
-    // Add PC set string to state
-    state.setProperty("pcset", lastPCSetString, nullptr);
+void StringFieldMIDIProcessor::setEnsembleLayout(const juce::String& layout)
+{
+    ensembleHandoff.publish(stringfield::CompiledEnsemble::compile(layout.toStdString()));
+    lastEnsembleLayout = layout;
+    markStateDirty();
+}
 
-    // Add MIDI CC mappings to state
-    juce::String ccMappingsString;
-    for (const auto& mapping : ccToParameterMap)
+void StringFieldMIDIProcessor::getStateInformation(juce::MemoryBlock& destData)
+{
+    const juce::ScopedLock lock(stateLock);
+
+    // Hosts autosave often; an unchanged session reuses the last blob. The
+    // flag is cleared first so a change made while encoding dirties it again.
+    if (stateDirty.exchange(false, std::memory_order_acquire) || cachedState.isEmpty())
     {
-        ccMappingsString += juce::String(mapping.first) + ":" + mapping.second + ";";
+        PluginState state(apvts);
+
+        for (auto* param : getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+                state.parameters.emplace_back(ranged->getParameterID(),
+                                              ranged->convertFrom0to1(ranged->getValue()));
+
+        state.pcSet = lastPCSetString;
+        state.pitchWeights = lastPitchWeights;
+        state.routeWeights = lastRouteWeights;
+        state.follow = conductorSettings;
+        state.ccMappings = ccToParameterMap;
+        state.ensembleLayout = lastEnsembleLayout;
+
+        state.write(cachedState);
     }
-    state.setProperty("ccmappings", ccMappingsString, nullptr);
 
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    destData = cachedState;
 }
 
 void StringFieldMIDIProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    std::unique_ptr<juce::XmlElement> xml(getXmlFromBinary(data, sizeInBytes));
-    if (xml && xml->hasTagName(apvts.state.getType()))
-    {
-        auto state = juce::ValueTree::fromXml(*xml);
-        apvts.replaceState(state);
+    // Decode and compile everything first: on bad data nothing changes, and
+    // the audio thread keeps running on the old state until the swap below
+    auto state = PluginState::read(data, sizeInBytes, apvts);
+    if (state == nullptr)
+        return;
 
-        // Restore PC set string
-        if (state.hasProperty("pcset"))
-        {
-            juce::String pcString = state.getProperty("pcset").toString();
-            parsePitchClassSet(pcString);
-        }
+    std::unique_ptr<stringfield::CompiledPitchClassSet> pcSet;
+    if (state->hasPCSet)
+        pcSet = stringfield::CompiledPitchClassSet::compile(state->pcSet.toStdString());
 
-        // Restore MIDI CC mappings
-        if (state.hasProperty("ccmappings"))
-        {
-            ccToParameterMap.clear();
-            juce::String ccMappingsString = state.getProperty("ccmappings").toString();
-            juce::StringArray mappings = juce::StringArray::fromTokens(ccMappingsString, ";", "");
+    auto weights = stringfield::CompiledWeightProfile::compile(state->pitchWeights.toStdString(),
+                                                               state->routeWeights.toStdString());
+
+    std::unique_ptr<CCRoutingTable> routing;
+    if (state->hasCCMappings)
+        routing = CCRoutingTable::build(state->ccMappings, apvts);
 
-            for (const auto& mapping : mappings)
+    auto layout = stringfield::CompiledEnsemble::compile(state->ensembleLayout.toStdString());
+
+    // === Swap ===
+    // Parameters missing from the state go back to their defaults, as
+    // replaceState did; unchanged ones don't notify the host
+    for (auto* param : getParameters())
+    {
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param);
+        if (ranged == nullptr)
+            continue;
+
+        float normalised = ranged->getDefaultValue();
+        for (const auto& [id, value] : state->parameters)
+        {
+            if (id == ranged->getParameterID())
             {
-                juce::StringArray parts = juce::StringArray::fromTokens(mapping, ":", "");
-                if (parts.size() == 2)
-                {
-                    int ccNumber = parts[0].getIntValue();
-                    juce::String paramID = parts[1];
-                    ccToParameterMap[ccNumber] = paramID;
-                }
+                normalised = ranged->convertTo0to1(value);
+                break;
             }
         }
+
+        if (normalised != ranged->getValue())
+            ranged->setValueNotifyingHost(normalised);
     }
+
+    paramSnapshot.markAllDirty();
+
+    if (pcSet != nullptr)
+    {
+        pcSetHandoff.publish(std::move(pcSet));
+        lastPCSetString = state->pcSet;
+    }
+
+    weightsHandoff.publish(std::move(weights));
+    lastPitchWeights = state->pitchWeights;
+    lastRouteWeights = state->routeWeights;
+
+    ensembleHandoff.publish(std::move(layout));
+    lastEnsembleLayout = state->ensembleLayout;
+
+    if (state->hasFollow)
+    {
+        conductorSettings = state->follow;
+        conductorHandoff.publish(std::make_unique<ConductorFollowSettings>(conductorSettings));
+    }
+
+    if (routing != nullptr)
+    {
+        ccToParameterMap = std::move(state->ccMappings);
+        ccRoutingHandoff.publish(std::move(routing));
+    }
+
+    markStateDirty();
 }
 
 juce::AudioProcessorEditor* StringFieldMIDIProcessor::createEditor()
@@ -796,8 +764,32 @@ juce::AudioProcessorEditor* StringFieldMIDIProcessor::createEditor()
 
 void StringFieldMIDIProcessor::setMIDILearnMode(bool enabled, const juce::String& paramID)
 {
-    midiLearnEnabled = enabled;
     midiLearnParameterID = enabled ? paramID : "";
+    pendingLearnCC.store(-1);
+    midiLearnEnabled.store(enabled && paramID.isNotEmpty(), std::memory_order_release);
+}
+
+void StringFieldMIDIProcessor::timerCallback()
+{
+    // Free PC sets and routing tables the audio thread has replaced. The only
+    // place that collects, as publish() may run on a host's loading thread.
+    pcSetHandoff.collectGarbage();
+    weightsHandoff.collectGarbage();
+    ensembleHandoff.collectGarbage();
+    ccRoutingHandoff.collectGarbage();
+    conductorHandoff.collectGarbage();
+
+    // The lookahead worker thread only exists while the parameter is on
+    lookahead.setEnabled(lookaheadMs->load(std::memory_order_relaxed) > 0.5f);
+
+    // Commit a CC caught by MIDI learn (std::map insertion allocates, so not on the audio thread)
+    int ccNumber = pendingLearnCC.exchange(-1);
+    if (ccNumber >= 0 && midiLearnParameterID.isNotEmpty())
+    {
+        ccToParameterMap[ccNumber] = midiLearnParameterID;
+        midiLearnParameterID = "";
+        rebuildCCRouting();
+    }
 }
 
 int StringFieldMIDIProcessor::getCCForParameter(const juce::String& paramID) const
@@ -819,11 +811,37 @@ void StringFieldMIDIProcessor::clearCCMapping(const juce::String& paramID)
         else
             ++it;
     }
+
+    rebuildCCRouting();
 }
 
 void StringFieldMIDIProcessor::clearAllCCMappings()
 {
     ccToParameterMap.clear();
+    rebuildCCRouting();
+}
+
+// === MIDI Export ===
+
+bool StringFieldMIDIProcessor::startMidiExport(const juce::File& file)
+{
+    return midiLogger.start(file.getFullPathName().toStdString(), currentSampleRate);
+}
+
+// === Conductor Bus ===
+
+void StringFieldMIDIProcessor::setConductorFollow(const juce::String& paramID,
+                                                  ConductorFollowSettings::Mode mode,
+                                                  float offset)
+{
+    const int index = ParamSnapshot::indexOf(paramID);
+    if (index < 0)
+        return;
+
+    conductorSettings.modes[index] = mode;
+    conductorSettings.offsets[index] = offset;
+    conductorHandoff.publish(std::make_unique<ConductorFollowSettings>(conductorSettings));
+    markStateDirty();
 }
 
 // Factory function
@@ -1,17 +1,30 @@
 #pragma once
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_audio_utils/juce_audio_utils.h>
-#include <deque>
-
-class StringFieldMIDIProcessor : public juce::AudioProcessor
+#include "Core/ActivityFeed.h"
+#include "Core/CheckpointBuilder.h"
+#include "Core/Ensemble.h"
+#include "Core/HotPathProfiler.h"
+#include "Core/LookaheadGenerator.h"
+#include "Core/MidiEventLogger.h"
+#include "Core/ObjectHandoff.h"
+#include "Core/OutputShaper.h"
+#include "CCRoutingTable.h"
+#include "ConductorFollow.h"
+#include "ParamSnapshot.h"
+#include "PluginState.h"
+
+class StringFieldMIDIProcessor : public juce::AudioProcessor,
+                                 private juce::AudioProcessorValueTreeState::Listener,
+                                 private juce::Timer
 {
 public:
     StringFieldMIDIProcessor();
-    ~StringFieldMIDIProcessor() override = default;
+    ~StringFieldMIDIProcessor() override;
 
     // === JUCE AudioProcessor Interface ===
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override {}
+    void releaseResources() override { lookahead.release(); checkpoints.release(); }
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
     bool isBusesLayoutSupported(const BusesLayout&) const override { return true; }
@@ -40,70 +53,164 @@ public:
     juce::AudioProcessorValueTreeState apvts;
 
     // === Public API for Editor ===
-    void setPitchClassSet(const juce::String& pcString) { parsePitchClassSet(pcString); }
+    // Compiles the set here (message thread) and hands it to the audio thread
+    void setPitchClassSet(const juce::String& pcString);
     juce::String getPitchClassSet() const { return lastPCSetString; }
 
-    // MIDI Learn API
+    // User weights for pitch classes and routes (space-separated, empty = flat)
+    void setWeightProfile(const juce::String& pitchWeights, const juce::String& routeWeights);
+    juce::String getPitchWeights() const { return lastPitchWeights; }
+    juce::String getRouteWeights() const { return lastRouteWeights; }
+
+    // Per-player ensemble settings (see CompiledEnsemble; empty = defaults).
+    // The number of players is the "players" parameter.
+    void setEnsembleLayout(const juce::String& layout);
+    juce::String getEnsembleLayout() const { return lastEnsembleLayout; }
+
+    // MIDI Learn API (message thread)
     void setMIDILearnMode(bool enabled, const juce::String& paramID = "");
-    bool isMIDILearning() const { return midiLearnEnabled; }
+    bool isMIDILearning() const { return midiLearnEnabled.load(std::memory_order_acquire); }
     juce::String getMIDILearnParameter() const { return midiLearnParameterID; }
     int getCCForParameter(const juce::String& paramID) const;
     void clearCCMapping(const juce::String& paramID);
     void clearAllCCMappings();
 
+    // Conductor bus API (message thread). Role is the "conductor" parameter.
+    void setConductorFollow(const juce::String& paramID, ConductorFollowSettings::Mode mode, float offset = 0.0f);
+    const ConductorFollowSettings& getConductorFollow() const { return conductorSettings; }
+    bool isConductorLeader() const { return conductorBus.isLeader(this); }
+
+    // MIDI export: streams every emitted event to a .mid file (message thread)
+    bool startMidiExport(const juce::File& file);
+    void stopMidiExport() { midiLogger.stop(); }
+    bool isExportingMidi() const { return midiLogger.isRecording(); }
+    const stringfield::MidiEventLogger& getMidiLogger() const { return midiLogger; }
+
+    // Emitted notes and pedal changes for the activity view (editor drains it)
+    stringfield::ActivityFeed& getActivityFeed() { return activityFeed; }
+
+    // Block and stage timings (empty unless built with STRINGFIELD_INSTRUMENTATION)
+    stringfield::HotPathProfiler& getProfiler() { return profiler; }
+
 private:
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
 
     // === State Variables ===
-    double sr = 44100.0;
     bool wasPlaying = false;
 
-    // Scheduler (sample-time)
+    // Parameter values for the current block (cached raw pointers + dirty flags)
+    ParamSnapshot paramSnapshot { apvts };
+
+    // Host MidiBuffers are grown to this size, then never reallocate
+    int midiReserveBytes = 0;
+
+    // Host timeline (sample-time; follows the host position while playing)
     int64_t sampleCounter = 0;
-    int64_t nextNoteOnSample = 0;
+    double currentSampleRate = 44100.0;
 
-    // Active note (monophonic v0.1)
-    int activeNote = -1;
-    int activeChannel = 1;
-    int64_t noteOffSample = 0;
+    // Generator snapshots along the host timeline, for instant locate. Once
+    // anything the generator depends on changes, a worker thread rebuilds
+    // them from the origin; a locate before that either uses the old ones
+    // or waits (silent) until the new ones reach the host position.
+    static constexpr double checkpointBeats = 4.0;
+    stringfield::CheckpointBuilder checkpoints;
+    bool locatePending = false;           // Waiting for checkpoints; the ensemble plays nothing
 
-    // Sustain pedal state (automatic, energy/density controlled)
-    bool pedalDown = false;
-    int64_t nextPedalChangeSample = 0;
-    bool lastPedalParamState = false;  // Track parameter changes
+    // Generator (JUCE-free, see Source/Core): one to 16 players on one timeline
+    stringfield::Ensemble ensemble;
 
-    // RNG
-    juce::Random rng;
-    int lastSeed = 1;
+    // Background generation for the "lookahead" parameter: a worker renders
+    // its own ensemble ahead and processBlock only plays the events out
+    stringfield::LookaheadGenerator lookahead;
+    std::atomic<float>* lookaheadMs = apvts.getRawParameterValue("lookahead");
+    bool lookaheadActive = false;         // Mode of the last block
 
-    // Memory kernels (Feldman-ish fragile memory)
-    std::deque<int> recentNotes;      // Pitch memory
-    std::deque<double> recentIntervals;  // Rhythm memory
+    juce::String lastPCSetString;         // PC set as typed by the user (message thread)
 
-    // Pitch-class set state
-    std::vector<int> pitchClassSet;       // Current PC set (0-11)
-    std::vector<int> remainingPCs;        // PCs not yet exhausted
-    std::map<int, int> pcToMidiMap;       // PC → MIDI note memory (for octave consistency)
-    juce::String lastPCSetString;         // Track when to re-parse
+    // Compiled PC sets travel to the audio thread lock-free
+    stringfield::ObjectHandoff<stringfield::CompiledPitchClassSet> pcSetHandoff;
 
-    // MIDI Learn state
+    // Weight profiles, likewise
+    stringfield::ObjectHandoff<stringfield::CompiledWeightProfile> weightsHandoff;
+    juce::String lastPitchWeights, lastRouteWeights;   // As typed (message thread)
+
+    // Per-player ensemble settings, likewise
+    stringfield::ObjectHandoff<stringfield::CompiledEnsemble> ensembleHandoff;
+    juce::String lastEnsembleLayout;                   // As typed (message thread)
+
+    // MIDI Learn state. The map and parameter ID belong to the message thread;
+    // the audio thread only sees the flag, the pending CC and the routing table.
     std::map<int, juce::String> ccToParameterMap;  // CC number → parameter ID
-    bool midiLearnEnabled = false;
     juce::String midiLearnParameterID;
+    std::atomic<bool> midiLearnEnabled { false };
+    std::atomic<int> pendingLearnCC { -1 };        // Caught on the audio thread, committed by timerCallback
+
+    // CC → parameter lookup, rebuilt whenever ccToParameterMap changes
+    stringfield::ObjectHandoff<CCRoutingTable> ccRoutingHandoff;
+
+    // Mapped CCs of the current block, one per parameter (last value wins),
+    // in order of arrival
+    struct CCChange
+    {
+        int offset = 0;
+        float normalised = 0.0f;
+        CCRoutingTable::Route route;
+    };
+
+    std::array<CCChange, ParamSnapshot::numParams> ccChanges;
+    int numCCChanges = 0;
+
+    // Emitted events → background .mid writer
+    stringfield::MidiEventLogger midiLogger;
+
+    // Emitted events → activity view; drops when nobody drains it
+    stringfield::ActivityFeed activityFeed;
+
+    // Cycle counts of processBlock and its stages
+    stringfield::HotPathProfiler profiler;
+
+    // Output stage: channel-aware pedal/all-off fan-out, optional DIN pacing
+    stringfield::OutputShaper outputShaper;
+    std::atomic<float>* dinLimit = apvts.getRawParameterValue("dinlimit");
+
+    // Input events that pass through (mapped CCs are consumed). Capped at 512
+    // three-byte events a block; the excess is counted as dropped.
+    static constexpr int passThroughBudgetBytes = 9 * 512;
+    juce::MidiBuffer passThroughMidi;
+    uint64_t passThroughDropped = 0;
+
+    // Saved state, re-encoded only after something in it changed. Parameter
+    // changes (possibly on the audio thread) just raise the flag.
+    juce::CriticalSection stateLock;
+    juce::MemoryBlock cachedState;
+    std::atomic<bool> stateDirty { true };
+
+    // === Conductor Bus ===
+    enum ConductorRole { RoleOff = 0, RoleLead, RoleFollow };
+
+    stringfield::ConductorBus& conductorBus = stringfield::ConductorBus::shared();
+    std::atomic<float>* conductorRole = apvts.getRawParameterValue("conductor");
+    int lastConductorRole = RoleOff;
+
+    ConductorFollowSettings conductorSettings { apvts };     // Message thread copy
+    stringfield::ObjectHandoff<ConductorFollowSettings> conductorHandoff;
+    stringfield::ConductorBus::Frame conductorFrame;       // Follower: last frame read
+
+    stringfield::EngineParams blockParams;                 // Effective parameters (local + conductor + CCs)
+    float publishedValues[ParamSnapshot::numParams] {};
+    bool leading = false;
 
     // === Helper Methods ===
-    void handleTransportStop(juce::MidiBuffer& midi);
-    void scheduleNextNote(double bpm, double ppqPos);
-    void schedulePedalChange(float energy, float density);
-    int pickNote(int center, int spread);
-    int pickVelocity(int baseVel);
-    int pickArticulation(int numRoutes, float articulation, float energy);
-    double calculateDuration(float energy);
-
-    // Pitch-class set helpers
-    void parsePitchClassSet(const juce::String& pcString);
-    void transformPitchClassSet();  // Apply random Tn or TnI
-    int mapPCToMIDI(int pitchClass, int center, int spread);
+    void timerCallback() override;
+    void parameterChanged(const juce::String&, float) override { markStateDirty(); }
+    void markStateDirty() noexcept { stateDirty.store(true, std::memory_order_release); }
+    bool updateBlockParameters(stringfield::EventSink& sink);
+    stringfield::GeneratorState getGeneratorState() const;
+    bool locate(int64_t time, int64_t spacing, bool silence,
+                const stringfield::TransportPosition* transport, stringfield::EventSink& sink);
+    void publishToConductorBus();
+    void rebuildCCRouting();
+    void collectCCChanges(juce::MidiBuffer& midiMessages);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StringFieldMIDIProcessor)
 };
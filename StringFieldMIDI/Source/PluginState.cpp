@@ -0,0 +1,145 @@
+#include "PluginState.h"
+
+namespace
+{
+    constexpr int magic = 0x74734653;           // "SFst" as little-endian bytes
+    constexpr int endMarker = 0x6e654653;       // "SFen"
+    constexpr int maxEntries = 4096;            // Sanity bound on any count
+
+    bool isPlausibleCount(int count) { return count >= 0 && count <= maxEntries; }
+}
+
+void PluginState::write(juce::MemoryBlock& dest) const
+{
+    juce::MemoryOutputStream out(dest, false);
+
+    out.writeInt(magic);
+    out.writeCompressedInt(currentVersion);
+
+    out.writeCompressedInt((int)parameters.size());
+    for (const auto& [id, value] : parameters)
+    {
+        out.writeString(id);
+        out.writeFloat(value);
+    }
+
+    out.writeString(pcSet);
+    out.writeString(pitchWeights);
+    out.writeString(routeWeights);
+
+    follow.write(out);
+
+    out.writeCompressedInt((int)ccMappings.size());
+    for (const auto& [cc, id] : ccMappings)
+    {
+        out.writeCompressedInt(cc);
+        out.writeString(id);
+    }
+
+    out.writeString(ensembleLayout);
+
+    out.writeInt(endMarker);
+}
+
+std::unique_ptr<PluginState> PluginState::read(const void* data, int sizeInBytes,
+                                               juce::AudioProcessorValueTreeState& apvts)
+{
+    if (data == nullptr || sizeInBytes < 4)
+        return nullptr;
+
+    auto state = std::make_unique<PluginState>(apvts);
+
+    juce::MemoryInputStream in(data, (size_t)sizeInBytes, false);
+    if (in.readInt() == magic)
+    {
+        if (!state->readBinary(in))
+            return nullptr;
+
+        return state;
+    }
+
+    // Sessions saved before the binary format
+    std::unique_ptr<juce::XmlElement> xml(juce::AudioProcessor::getXmlFromBinary(data, sizeInBytes));
+    if (xml != nullptr && xml->hasTagName(apvts.state.getType()) && state->readXml(*xml))
+        return state;
+
+    return nullptr;
+}
+
+bool PluginState::readBinary(juce::InputStream& in)
+{
+    // Fields are only ever appended, but an older build can't know how far
+    // to trust a newer blob
+    const int version = in.readCompressedInt();
+    if (version < 1 || version > currentVersion)
+        return false;
+
+    const int numParameters = in.readCompressedInt();
+    if (!isPlausibleCount(numParameters))
+        return false;
+
+    parameters.reserve((size_t)numParameters);
+    for (int i = 0; i < numParameters; ++i)
+    {
+        auto id = in.readString();
+        const float value = in.readFloat();
+        parameters.emplace_back(std::move(id), value);
+    }
+
+    pcSet = in.readString();
+    pitchWeights = in.readString();
+    routeWeights = in.readString();
+
+    if (!follow.read(in))
+        return false;
+
+    const int numMappings = in.readCompressedInt();
+    if (!isPlausibleCount(numMappings))
+        return false;
+
+    for (int i = 0; i < numMappings; ++i)
+    {
+        const int cc = in.readCompressedInt();
+        auto id = in.readString();
+        if (cc >= 0 && cc < 128 && id.isNotEmpty())
+            ccMappings[cc] = id;
+    }
+
+    if (version >= 2)
+        ensembleLayout = in.readString();
+
+    // A short read returns zeros, so a truncated blob never ends on the marker
+    return in.readInt() == endMarker;
+}
+
+bool PluginState::readXml(const juce::XmlElement& xml)
+{
+    for (auto* param : xml.getChildWithTagNameIterator("PARAM"))
+    {
+        const auto id = param->getStringAttribute("id");
+        if (id.isNotEmpty() && param->hasAttribute("value"))
+            parameters.emplace_back(id, (float)param->getDoubleAttribute("value"));
+    }
+
+    hasPCSet = xml.hasAttribute("pcset");
+    pcSet = xml.getStringAttribute("pcset");
+
+    // Sessions older than weight profiles have none: flat
+    pitchWeights = xml.getStringAttribute("pitchweights");
+    routeWeights = xml.getStringAttribute("routeweights");
+
+    hasFollow = xml.hasAttribute("conductorfollow");
+    if (hasFollow)
+        follow.fromString(xml.getStringAttribute("conductorfollow"));
+
+    // Format: "cc:paramID;" per mapping
+    hasCCMappings = xml.hasAttribute("ccmappings");
+    for (const auto& mapping : juce::StringArray::fromTokens(xml.getStringAttribute("ccmappings"), ";", ""))
+    {
+        juce::StringArray parts = juce::StringArray::fromTokens(mapping, ":", "");
+        if (parts.size() == 2)
+            ccMappings[parts[0].getIntValue()] = parts[1];
+    }
+
+    return true;
+}
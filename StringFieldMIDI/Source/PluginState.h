@@ -0,0 +1,49 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "ConductorFollow.h"
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Everything the plugin saves with a session, as plain values.
+//
+// Saved as a small versioned binary blob:
+//     magic "SFst", version, parameters (ID, real value), PC set, pitch and
+//     route weights, conductor follow, CC mappings, [2: ensemble layout],
+//     end marker
+// written with JUCE's little-endian stream helpers. Sessions saved before the
+// binary format (APVTS XML via copyXmlToBinary) are still read.
+//
+// Decoding validates everything and touches nothing outside the struct, so a
+// restore can build all its runtime objects before swapping any of them in.
+struct PluginState
+{
+    static constexpr int currentVersion = 2;
+
+    explicit PluginState(juce::AudioProcessorValueTreeState& apvts) : follow(apvts) {}
+
+    std::vector<std::pair<juce::String, float>> parameters;   // Parameter ID, real value
+
+    // Old XML sessions may lack these; absent parts keep their current value
+    bool hasPCSet = true;
+    bool hasFollow = true;
+    bool hasCCMappings = true;
+
+    juce::String pcSet;
+    juce::String pitchWeights, routeWeights;
+    ConductorFollowSettings follow;
+    std::map<int, juce::String> ccMappings;                   // CC number → parameter ID
+    juce::String ensembleLayout;                              // Older sessions: empty (defaults)
+
+    void write(juce::MemoryBlock& dest) const;
+
+    // Binary or legacy XML. nullptr if the data is neither, is truncated or
+    // comes from a newer version.
+    static std::unique_ptr<PluginState> read(const void* data, int sizeInBytes,
+                                             juce::AudioProcessorValueTreeState& apvts);
+
+private:
+    bool readBinary(juce::InputStream& in);
+    bool readXml(const juce::XmlElement& xml);
+};
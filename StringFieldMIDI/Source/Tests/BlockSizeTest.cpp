@@ -0,0 +1,135 @@
+// stringfield_block_size_test: the generator's output must not depend on
+// how the host splits the timeline into blocks.
+//
+//   ctest --test-dir build        (or run the executable directly)
+//
+// Renders a fixed seed across rate, memory, pulse, PC-set and ensemble
+// configurations at block sizes 1, 7, 512 and 8192, and as one single
+// block, and compares the event streams byte for byte (absolute time and
+// message). Every event must also fall inside the block that emitted it.
+// Exits 1 on any difference.
+
+#include "Core/Ensemble.h"
+#include "Core/PitchClassSet.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int lengthSamples = (int)(60 * sampleRate);
+    constexpr size_t recordSize = sizeof(int64_t) + 3;
+
+    struct Config
+    {
+        const char* name;
+        stringfield::EngineParams params;
+        const char* pcSet = "";
+    };
+
+    // Absolute sample time and message bytes of every event, in order
+    struct Recorder : stringfield::EventSink
+    {
+        void handleEvent(const stringfield::MidiEvent& event) override
+        {
+            if (event.offset < 0 || event.offset >= blockSize)
+                ++outOfBlock;
+
+            const int64_t time = blockStart + event.offset;
+            uint8_t record[recordSize];
+            std::memcpy(record, &time, sizeof(time));
+            std::memcpy(record + sizeof(time), event.data, 3);
+            bytes.insert(bytes.end(), record, record + sizeof(record));
+        }
+
+        std::vector<uint8_t> bytes;
+        int64_t blockStart = 0;
+        int blockSize = 0;
+        int outOfBlock = 0;
+    };
+
+    std::vector<Config> makeConfigs()
+    {
+        std::vector<Config> configs;
+        auto add = [&configs](const char* name, auto&& configure, const char* pcSet = "")
+        {
+            Config c { name, {}, pcSet };
+            c.params.seed = 7;
+            c.params.density = 0.8f;
+            configure(c.params);
+            configs.push_back(c);
+        };
+
+        add("rate", [](auto&) {});
+        add("rate=20 energy=0.9", [](auto& p) { p.rate = 20.0f; p.energy = 0.9f; });
+        add("rate=0.2 energy=0", [](auto& p) { p.rate = 0.2f; p.energy = 0.0f; });
+        add("memory=8", [](auto& p) { p.memory = 8; p.rate = 8.0f; });
+        add("memory=16 decay", [](auto& p) { p.memory = 16; p.memoryMode = 1; p.rate = 8.0f; });
+        add("memory=16 markov", [](auto& p) { p.memory = 16; p.memoryMode = 2; p.rate = 8.0f; });
+        add("pulse", [](auto& p) { p.pulse = true; p.tempo = 180.0f; p.regularity = 0.3f; });
+        add("pulse sync=1/16", [](auto& p) { p.pulse = true; p.sync = 5; p.tempo = 140.0f; });
+        add("pcmode=1", [](auto& p) { p.pcMode = 1; p.rate = 8.0f; }, "0 2 4 7 9");
+        add("pcmode=2", [](auto& p) { p.pcMode = 2; p.rate = 8.0f; }, "0 1 4 6 8");
+        add("voices=8 routes=4", [](auto& p) { p.voices = 8; p.routes = 4; p.rate = 12.0f; p.energy = 0.1f; });
+        add("players=4", [](auto& p) { p.players = 4; p.voices = 4; p.rate = 6.0f; });
+        return configs;
+    }
+
+    // `blockSize` 0 renders the whole timeline as one block
+    Recorder render(const Config& config, const stringfield::CompiledPitchClassSet* pcSet, int blockSize)
+    {
+        auto generator = std::make_unique<stringfield::Ensemble>();
+        generator->prepare(sampleRate);
+        generator->setPitchClassSet(pcSet);
+
+        Recorder recorder;
+        recorder.blockSize = lengthSamples;
+        generator->setParameters(config.params, 0, recorder);
+
+        const int step = blockSize > 0 ? blockSize : lengthSamples;
+        for (int64_t start = 0; start < lengthSamples; start += step)
+        {
+            recorder.blockStart = start;
+            recorder.blockSize = (int)std::min<int64_t>(step, lengthSamples - start);
+            generator->render(start, recorder.blockSize, recorder);
+        }
+
+        return recorder;
+    }
+}
+
+int main()
+{
+    int failures = 0;
+
+    for (const auto& config : makeConfigs())
+    {
+        const auto pcSet = stringfield::CompiledPitchClassSet::compile(config.pcSet);
+        const auto reference = render(config, pcSet.get(), 0);
+
+        if (reference.bytes.empty())
+        {
+            std::printf("FAIL %-20s no events\n", config.name);
+            ++failures;
+            continue;
+        }
+
+        for (int blockSize : { 1, 7, 512, 8192 })
+        {
+            const auto split = render(config, pcSet.get(), blockSize);
+            const bool same = split.bytes == reference.bytes && split.outOfBlock == 0;
+            failures += same ? 0 : 1;
+
+            std::printf("%s %-20s block %-5d %zu events%s\n", same ? "ok  " : "FAIL", config.name, blockSize,
+                        split.bytes.size() / recordSize, split.outOfBlock > 0 ? " (outside their block)" : "");
+        }
+    }
+
+    std::printf("%d failure(s)\n", failures);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,212 @@
+// stringfield_locate_test: a locate must not generate the path up to its
+// target on the audio thread.
+//
+//   ctest --test-dir build        (or run the executable directly)
+//
+// Drives a CheckpointBuilder the way processBlock does: a cold locate 90
+// minutes in, a locate after a parameter change (served from the old
+// checkpoints until the new ones arrive), and one after a change of player
+// count (which has to wait for them). No restore() may take a tenth of what
+// generating the path to a cold locate takes, and once the worker is done each locate must play exactly what the
+// straight path from the origin plays. Exits 1 on any failure.
+
+#include "Core/CheckpointBuilder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int64_t coldTarget = (int64_t)(5400 * sampleRate);
+
+    // Absolute sample time and message bytes of every event, in order
+    struct Recorder : stringfield::EventSink
+    {
+        void handleEvent(const stringfield::MidiEvent& event) override
+        {
+            const int64_t time = blockStart + event.offset;
+            uint8_t record[sizeof(time) + 3];
+            std::memcpy(record, &time, sizeof(time));
+            std::memcpy(record + sizeof(time), event.data, 3);
+            bytes.insert(bytes.end(), record, record + sizeof(record));
+        }
+
+        std::vector<uint8_t> bytes;
+        int64_t blockStart = 0;
+    };
+
+    struct Discard : stringfield::EventSink
+    {
+        void handleEvent(const stringfield::MidiEvent&) override {}
+    };
+
+    int failures = 0;
+    double slowestRestoreMs = 0.0;
+
+    void check(bool ok, const char* what)
+    {
+        std::printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+        failures += ok ? 0 : 1;
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // CPU time of the calling thread where the platform has it: on a single
+    // core the worker woken by a restore() runs inside the call, and wall
+    // time would count its build against the audio thread
+    double threadMilliseconds()
+    {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+        timespec now;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1.0e6;
+#else
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    std::vector<uint8_t> play(stringfield::Ensemble& ensemble, int64_t from, double seconds)
+    {
+        Recorder recorder;
+        const int64_t end = from + (int64_t)(seconds * sampleRate);
+        for (int64_t time = from; time < end; time += blockSize)
+        {
+            recorder.blockStart = time;
+            ensemble.render(time, blockSize, recorder);
+        }
+        return recorder.bytes;
+    }
+
+    // What `state` plays from `time`, straight from the origin
+    std::vector<uint8_t> expected(const stringfield::GeneratorState& state, int64_t time, int64_t spacing)
+    {
+        Discard discard;
+        auto ensemble = std::make_unique<stringfield::Ensemble>();
+        ensemble->prepare(sampleRate);
+        ensemble->setParameters(state.params, 0, discard);
+
+        stringfield::CheckpointCache cache;
+        cache.prepare();
+        cache.reset(sampleRate, state.params, nullptr, nullptr);
+        cache.restore(*ensemble, time, spacing);
+        return play(*ensemble, time, 2.0);
+    }
+
+    // One processBlock's locate, timed
+    bool locate(stringfield::CheckpointBuilder& builder, stringfield::Ensemble& ensemble,
+                const stringfield::GeneratorState& state, int64_t time, int64_t spacing)
+    {
+        const double start = threadMilliseconds();
+        const bool done = builder.restore(ensemble, state, time, spacing, nullptr, false);
+        slowestRestoreMs = std::max(slowestRestoreMs, threadMilliseconds() - start);
+        return done;
+    }
+
+    // Tries again every block (silent) until the checkpoints are there, like
+    // processBlock; `time` follows the host
+    bool waitForLocate(stringfield::CheckpointBuilder& builder, stringfield::Ensemble& ensemble,
+                       const stringfield::GeneratorState& state, int64_t& time, int64_t spacing)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        while (millisecondsSince(start) < 10000.0)
+        {
+            if (locate(builder, ensemble, state, time, spacing))
+                return true;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            time += blockSize;
+        }
+        return false;
+    }
+
+    bool waitForWorker(const stringfield::CheckpointBuilder& builder)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        while (! builder.isCurrent() && millisecondsSince(start) < 10000.0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return builder.isCurrent();
+    }
+}
+
+int main()
+{
+    Discard discard;
+    const auto spacing = (int64_t)(2.0 * sampleRate);
+
+    stringfield::GeneratorState state;
+    state.params.seed = 5;
+    state.params.rate = 8.0f;
+    state.params.density = 0.6f;
+    state.params.voices = 4;
+
+    auto ensemble = std::make_unique<stringfield::Ensemble>();
+    ensemble->prepare(sampleRate);
+    ensemble->setParameters(state.params, 0, discard);
+
+    stringfield::CheckpointBuilder builder;
+    builder.prepare(sampleRate);
+
+    // What the audio thread used to do on a cold locate
+    double coldMs;
+    {
+        auto reference = std::make_unique<stringfield::Ensemble>();
+        reference->prepare(sampleRate);
+        reference->setParameters(state.params, 0, discard);
+        stringfield::CheckpointCache cache;
+        cache.prepare();
+        cache.reset(sampleRate, state.params, nullptr, nullptr);
+
+        const double start = threadMilliseconds();
+        cache.restore(*reference, coldTarget, spacing);
+        coldMs = threadMilliseconds() - start;
+    }
+
+    // Nothing to locate from yet: wait for the worker, silent
+    int64_t time = coldTarget;
+    check(! locate(builder, *ensemble, state, time, spacing), "a cold locate waits for the worker");
+    check(waitForLocate(builder, *ensemble, state, time, spacing), "the checkpoints arrive");
+    check(play(*ensemble, time, 2.0) == expected(state, time, spacing), "the locate is exact once they have");
+
+    // A parameter change: the old checkpoints serve until the new ones are built
+    state.params.density = 0.3f;
+    ensemble->setParameters(state.params, time, discard);
+    builder.invalidate();
+
+    time = (int64_t)(600 * sampleRate);
+    check(locate(builder, *ensemble, state, time, spacing), "after a change the old checkpoints serve at once");
+    check(! play(*ensemble, time, 2.0).empty(), "and the ensemble plays from them");
+
+    check(waitForWorker(builder), "the worker finishes the new checkpoints");
+    check(locate(builder, *ensemble, state, time, spacing), "a locate takes them");
+    check(play(*ensemble, time, 2.0) == expected(state, time, spacing), "and is exact again");
+
+    // A different number of players can't use the old checkpoints
+    state.params.players = 2;
+    ensemble->setParameters(state.params, time, discard);
+    builder.invalidate();
+
+    time = (int64_t)(300 * sampleRate);
+    check(! locate(builder, *ensemble, state, time, spacing), "a new player count waits for the worker");
+    check(waitForLocate(builder, *ensemble, state, time, spacing), "the checkpoints arrive");
+    check(play(*ensemble, time, 2.0) == expected(state, time, spacing), "the locate is exact once they have");
+
+    builder.release();
+
+    std::printf("     slowest restore(): %.3f ms; generating the path to 90 min: %.2f ms\n",
+                slowestRestoreMs, coldMs);
+    check(slowestRestoreMs < coldMs / 10.0, "no locate costs the callback a tenth of a cold one");
+
+    std::printf("%d failure(s)\n", failures);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,198 @@
+// stringfield_midi_export_test: a MIDI export must keep running forward
+// when the host position jumps back.
+//
+//   ctest --test-dir build        (or run the executable directly)
+//
+// Plays an ensemble block by block the way processBlock does, with a locate
+// back into the song and a restart from zero along the way, logging the
+// output to a .mid file. The file must hold every event, in the order
+// played, at the time it was played (not its song position). Exits 1 on
+// any failure.
+
+#include "Core/CheckpointCache.h"
+#include "Core/Ensemble.h"
+#include "Core/MidiEventLogger.h"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    struct Logged
+    {
+        int64_t tick;
+        uint8_t data[3];
+    };
+
+    // Logs to the export and keeps what the file should hold
+    struct ExportSink : stringfield::EventSink
+    {
+        explicit ExportSink(stringfield::MidiEventLogger& l) : logger(l) {}
+
+        void handleEvent(const stringfield::MidiEvent& event) override
+        {
+            logger.log(event);
+            played.push_back({ clock + event.offset, { event.data[0], event.data[1], event.data[2] } });
+        }
+
+        stringfield::MidiEventLogger& logger;
+        int64_t clock = 0;                      // Samples played, as the logger counts them
+        std::vector<Logged> played;             // `tick` holds the sample time until converted
+    };
+
+    int failures = 0;
+
+    void check(bool ok, const char* what)
+    {
+        std::printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+        failures += ok ? 0 : 1;
+    }
+
+    uint32_t readVarLen(const std::vector<uint8_t>& bytes, size_t& pos)
+    {
+        uint32_t value = 0;
+        while (pos < bytes.size())
+        {
+            const uint8_t b = bytes[pos++];
+            value = (value << 7) | (b & 0x7F);
+            if ((b & 0x80) == 0)
+                break;
+        }
+        return value;
+    }
+
+    // Channel messages of a format 0 file, at absolute ticks
+    std::vector<Logged> readFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        std::vector<Logged> events;
+        size_t pos = 14 + 8;                    // Header chunk, track chunk header
+        int64_t tick = 0;
+        uint8_t status = 0;
+
+        while (pos < bytes.size())
+        {
+            tick += readVarLen(bytes, pos);
+            if (pos >= bytes.size())
+                break;
+
+            if (bytes[pos] == 0xFF)             // Meta event
+            {
+                pos += 2;
+                pos += readVarLen(bytes, pos);
+                continue;
+            }
+
+            if (bytes[pos] & 0x80)
+                status = bytes[pos++];
+
+            const int size = (status & 0xE0) == 0xC0 ? 1 : 2;
+            Logged e { tick, { status, 0, 0 } };
+            for (int i = 0; i < size && pos < bytes.size(); ++i)
+                e.data[1 + i] = bytes[pos++];
+            events.push_back(e);
+        }
+
+        return events;
+    }
+}
+
+int main()
+{
+    const auto path = std::filesystem::temp_directory_path() / "stringfield_midi_export_test.mid";
+
+    stringfield::EngineParams params;
+    params.seed = 11;
+    params.rate = 8.0f;
+    params.density = 0.6f;
+    params.voices = 4;
+
+    auto ensemble = std::make_unique<stringfield::Ensemble>();
+    ensemble->prepare(sampleRate);
+
+    stringfield::CheckpointCache checkpoints;
+    checkpoints.prepare();
+    checkpoints.reset(sampleRate, params, nullptr, nullptr);
+    const auto spacing = (int64_t)(2.0 * sampleRate);
+
+    stringfield::MidiEventLogger logger;
+    if (! logger.start(path.string(), sampleRate))
+    {
+        std::printf("FAIL can't write %s\n", path.string().c_str());
+        return 1;
+    }
+
+    ExportSink sink(logger);
+    ensemble->setParameters(params, 0, sink);
+
+    // Song positions played, in order: 0-20 s, a locate back to 5 s, then
+    // a stop and a restart from the top
+    const struct { double from, to; } passes[] = { { 0, 20 }, { 5, 15 }, { 0, 10 } };
+    int64_t lastSongEnd = 0;
+
+    for (const auto& pass : passes)
+    {
+        int64_t song = (int64_t)(pass.from * sampleRate);
+        const int64_t end = (int64_t)(pass.to * sampleRate);
+
+        if (song != lastSongEnd)
+        {
+            ensemble->stop(sink);
+            checkpoints.restore(*ensemble, song, spacing);
+            ensemble->sendControllerState(sink);
+        }
+
+        for (; song < end; song += blockSize)
+        {
+            ensemble->render(song, blockSize, sink);
+            checkpoints.capture(*ensemble, song + blockSize, spacing);
+            logger.advance(blockSize);
+            sink.clock += blockSize;
+        }
+
+        lastSongEnd = song;
+    }
+
+    ensemble->stop(sink);
+    logger.stop();
+
+    // What MidiFileWriter makes of the times: ticks from the first event
+    const double ticksPerSample = stringfield::MidiFileWriter::ticksPerQuarter * 120.0 / (60.0 * sampleRate);
+    const int64_t first = sink.played.empty() ? 0 : sink.played.front().tick;
+    for (auto& e : sink.played)
+        e.tick = (int64_t)std::llround((double)(e.tick - first) * ticksPerSample);
+
+    const auto written = readFile(path);
+    std::filesystem::remove(path);
+
+    bool same = written.size() == sink.played.size();
+    for (size_t i = 0; same && i < written.size(); ++i)
+    {
+        const auto& a = written[i];
+        const auto& b = sink.played[i];
+        same = a.tick == b.tick && a.data[0] == b.data[0] && a.data[1] == b.data[1] && a.data[2] == b.data[2];
+    }
+
+    // Host positions would fold 40 s of playing into 20; the file must last 40
+    const int64_t sessionTicks = (int64_t)std::llround((double)(sink.clock - first) * ticksPerSample);
+    const int64_t lastTick = written.empty() ? 0 : written.back().tick;
+
+    check(logger.getDroppedCount() == 0, "nothing dropped");
+    check(sink.played.size() > 200, "the timeline has events");
+    check(same, "every event is in the file at the time it was played");
+    check(lastTick == sessionTicks, "the file runs as long as the session played");
+    std::printf("     %zu events written over %lld ticks\n", written.size(), (long long)lastTick);
+
+    std::printf("%d failure(s)\n", failures);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+// stringfield_output_shaper_test: DIN pacing under overload must never lose
+// a release, and nothing may leave the shaper outside its block.
+//
+//   ctest --test-dir build        (or run the executable directly)
+//
+// Floods the shaper with far more notes, pedal changes and other controllers
+// than a 31250-baud port carries, so the carry-over queue overflows, then
+// drains it. Every note-on that reaches the port must be followed by its
+// note-off, and the pedal must end up on every channel that got it down.
+// Then turns the limit off while events are still queued, which must
+// release them inside the current block. Debug builds also abort if the
+// shaper touches the heap. Exits 1 on any failure.
+
+#include "Core/AllocationTrap.h"
+#include "Core/CounterRandom.h"
+#include "Core/OutputShaper.h"
+
+#include <cstdio>
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    // What a synth on the port would be doing
+    struct Port : stringfield::EventSink
+    {
+        void handleEvent(const stringfield::MidiEvent& e) override
+        {
+            if (e.offset < 0 || e.offset >= numSamples)
+                ++outOfBlock;
+
+            const int channel = e.getChannel() - 1;
+            if (e.isNoteOn())
+            {
+                ++sounding[channel][e.data[1]];
+                ++noteOns;
+            }
+            else if (e.isNoteOff())
+            {
+                if (sounding[channel][e.data[1]] > 0)
+                    --sounding[channel][e.data[1]];
+            }
+            else if (e.isController() && e.data[1] == 64)
+            {
+                pedalDown[channel] = e.data[2] >= 64;
+            }
+        }
+
+        int countSounding() const
+        {
+            int total = 0;
+            for (const auto& channel : sounding)
+                for (int count : channel)
+                    total += count;
+            return total;
+        }
+
+        int countPedals() const
+        {
+            int total = 0;
+            for (bool down : pedalDown)
+                total += down ? 1 : 0;
+            return total;
+        }
+
+        int numSamples = blockSize;
+        int outOfBlock = 0;
+        int noteOns = 0;
+        int sounding[16][128] {};
+        bool pedalDown[16] {};
+    };
+
+    int failures = 0;
+
+    void check(bool ok, const char* what)
+    {
+        std::printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+        failures += ok ? 0 : 1;
+    }
+
+    // Two seconds of 24 notes per block over 16 channels, each held a few
+    // blocks, with pedal changes and unrelated controllers mixed in
+    void flood(stringfield::OutputShaper& shaper, Port& port)
+    {
+        stringfield::CounterRandom rng(3, stringfield::RandomStream::Pitch);
+        int held[16][128] {};
+        int releaseBlock[4096][3] {};
+        int numHeld = 0;
+
+        for (int block = 0; block < (int)(2.0 * sampleRate / blockSize); ++block)
+        {
+            shaper.beginBlock(blockSize, port);
+
+            // Note-offs of notes started three blocks ago
+            int remaining = 0;
+            for (int i = 0; i < numHeld; ++i)
+            {
+                auto& note = releaseBlock[i];
+                if (note[0] <= block)
+                {
+                    shaper.handleEvent(stringfield::MidiEvent::noteOff(0, note[1] + 1, note[2]), port);
+                    --held[note[1]][note[2]];
+                }
+                else
+                {
+                    releaseBlock[remaining][0] = note[0];
+                    releaseBlock[remaining][1] = note[1];
+                    releaseBlock[remaining][2] = note[2];
+                    ++remaining;
+                }
+            }
+            numHeld = remaining;
+
+            for (int i = 0; i < 24 && numHeld < 4096; ++i)
+            {
+                const int offset = rng.nextInt(blockSize);
+                const int channel = rng.nextInt(16);
+                const int note = 36 + rng.nextInt(48);
+
+                // One sounding copy per key, as the generator's voices guarantee
+                if (held[channel][note] > 0)
+                    continue;
+
+                shaper.handleEvent(stringfield::MidiEvent::noteOn(offset, channel + 1, note, 90), port);
+                ++held[channel][note];
+                releaseBlock[numHeld][0] = block + 3;
+                releaseBlock[numHeld][1] = channel;
+                releaseBlock[numHeld][2] = note;
+                ++numHeld;
+            }
+
+            const int channel = rng.nextInt(16) + 1;
+            shaper.handleEvent(stringfield::MidiEvent::controller(blockSize - 1, channel, 64, rng.nextBool() ? 127 : 0), port);
+            shaper.handleEvent(stringfield::MidiEvent::controller(blockSize - 1, channel, 1, rng.nextInt(128)), port);
+        }
+
+        // Release what is still held, and lift every pedal as a stop does
+        shaper.beginBlock(blockSize, port);
+        for (int i = 0; i < numHeld; ++i)
+            shaper.handleEvent(stringfield::MidiEvent::noteOff(0, releaseBlock[i][1] + 1, releaseBlock[i][2]), port);
+        for (int channel = 1; channel <= 16; ++channel)
+            shaper.handleEvent(stringfield::MidiEvent::controller(0, channel, 64, 0), port);
+    }
+}
+
+int main()
+{
+    // === Overload with the limit on ===
+    {
+        stringfield::OutputShaper shaper;
+        shaper.prepare(sampleRate);
+        shaper.setBandwidthLimit(true);
+
+        Port port;
+        {
+            stringfield::ScopedNoAllocation noAllocation;
+            flood(shaper, port);
+
+            for (int block = 0; block < 10000 && shaper.getNumDeferred() > 0; ++block)
+                shaper.beginBlock(blockSize, port);
+        }
+
+        const bool overflowed = shaper.getNumDropped() > 0;
+
+        check(overflowed, "flood overflows the carry-over queue");
+        check(shaper.getNumDeferred() == 0, "queue drains");
+        check(port.noteOns > 0 && port.countSounding() == 0, "every note-on sent gets its note-off");
+        check(port.countPedals() == 0, "every pedal is released");
+        check(port.outOfBlock == 0, "paced events stay inside their block");
+        std::printf("     %d note-ons sent, %llu events dropped\n", port.noteOns,
+                    (unsigned long long)shaper.getNumDropped());
+    }
+
+    // === Limit turned off with events queued past the block ===
+    {
+        stringfield::OutputShaper shaper;
+        shaper.prepare(sampleRate);
+        shaper.setBandwidthLimit(true);
+
+        Port port;
+        port.numSamples = 64;
+        shaper.beginBlock(64, port);
+        for (int i = 0; i < 32; ++i)
+            shaper.handleEvent(stringfield::MidiEvent::noteOn(0, 1, 40 + i, 90), port);
+
+        const bool queued = shaper.getNumDeferred() > 0;
+        shaper.setBandwidthLimit(false);
+        shaper.beginBlock(64, port);
+
+        check(queued && shaper.getNumDeferred() == 0, "switching the limit off flushes the queue");
+        check(port.outOfBlock == 0, "flushed events land inside the block");
+    }
+
+    std::printf("%d failure(s)\n", failures);
+    return failures > 0 ? 1 : 0;
+}
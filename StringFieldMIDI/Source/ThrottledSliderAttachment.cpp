@@ -0,0 +1,93 @@
+#include "ThrottledSliderAttachment.h"
+
+namespace
+{
+    juce::RangedAudioParameter& getParameter(juce::AudioProcessorValueTreeState& state,
+                                             const juce::String& parameterID)
+    {
+        auto* parameter = state.getParameter(parameterID);
+        jassert(parameter != nullptr);
+        return *parameter;
+    }
+}
+
+ThrottledSliderAttachment::ThrottledSliderAttachment(juce::AudioProcessorValueTreeState& state,
+                                                     const juce::String& parameterID,
+                                                     juce::Slider& s)
+    : slider(s),
+      attachment(getParameter(state, parameterID),
+                 [this](float newValue) { parameterChanged(newValue); },
+                 state.undoManager)
+{
+    // Same slider setup as SliderAttachment (all our ranges are linear)
+    auto& parameter = getParameter(state, parameterID);
+    const auto range = parameter.getNormalisableRange();
+
+    slider.valueFromTextFunction = [&parameter](const juce::String& text)
+    {
+        return (double)parameter.convertFrom0to1(parameter.getValueForText(text));
+    };
+    slider.textFromValueFunction = [&parameter](double value)
+    {
+        return parameter.getText(parameter.convertTo0to1((float)value), 0);
+    };
+    slider.setDoubleClickReturnValue(true, parameter.convertFrom0to1(parameter.getDefaultValue()));
+    slider.setNormalisableRange({ (double)range.start, (double)range.end, (double)range.interval, (double)range.skew });
+
+    attachment.sendInitialUpdate();
+    slider.valueChanged();
+    slider.addListener(this);
+}
+
+ThrottledSliderAttachment::~ThrottledSliderAttachment()
+{
+    slider.removeListener(this);
+}
+
+void ThrottledSliderAttachment::parameterChanged(float newValue)
+{
+    latestValue = newValue;
+
+    if (isTimerRunning())
+    {
+        pending = true;               // Shown on the next frame
+        return;
+    }
+
+    applyToSlider();
+    startTimerHz(maxFramesPerSecond);
+}
+
+void ThrottledSliderAttachment::timerCallback()
+{
+    if (! pending)
+    {
+        stopTimer();
+        return;
+    }
+
+    pending = false;
+    applyToSlider();
+}
+
+void ThrottledSliderAttachment::applyToSlider()
+{
+    const juce::ScopedValueSetter<bool> svs(ignoreCallbacks, true);
+    slider.setValue(latestValue, juce::sendNotificationSync);
+}
+
+void ThrottledSliderAttachment::sliderValueChanged(juce::Slider*)
+{
+    if (! ignoreCallbacks)
+        attachment.setValueAsPartOfGesture((float)slider.getValue());
+}
+
+void ThrottledSliderAttachment::sliderDragStarted(juce::Slider*)
+{
+    attachment.beginGesture();
+}
+
+void ThrottledSliderAttachment::sliderDragEnded(juce::Slider*)
+{
+    attachment.endGesture();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_gui_basics/juce_gui_basics.h>
+
+// Drop-in replacement for AudioProcessorValueTreeState::SliderAttachment that
+// caps how often parameter changes reach the slider.
+//
+// Dense automation (or conductor CCs) can move a parameter hundreds of times
+// a second, and every slider update is a repaint. Here the first change shows
+// at once; later ones only store the value, and a timer applies the latest
+// one at most maxFramesPerSecond times a second. The timer stops one frame
+// after the changes do. Slider → parameter (user drags) is immediate.
+class ThrottledSliderAttachment : private juce::Slider::Listener,
+                                  private juce::Timer
+{
+public:
+    static constexpr int maxFramesPerSecond = 30;
+
+    ThrottledSliderAttachment(juce::AudioProcessorValueTreeState& state,
+                              const juce::String& parameterID,
+                              juce::Slider& slider);
+    ~ThrottledSliderAttachment() override;
+
+private:
+    void parameterChanged(float newValue);
+    void applyToSlider();
+
+    void sliderValueChanged(juce::Slider*) override;
+    void sliderDragStarted(juce::Slider*) override;
+    void sliderDragEnded(juce::Slider*) override;
+    void timerCallback() override;
+
+    juce::Slider& slider;
+    juce::ParameterAttachment attachment;
+
+    float latestValue = 0.0f;         // Denormalised
+    bool pending = false;
+    bool ignoreCallbacks = false;
+
+    JUCE_DECLARE_NON_COPYABLE(ThrottledSliderAttachment)
+};
@@ -0,0 +1,382 @@
+// stringfield_render: renders a seed × energy × density grid to .mid files
+// on every core, without a plugin host.
+//
+//   stringfield_render --seeds 1-1000 --energy 0:1:5 --density 0.25,0.5 --out renders
+//
+// Each file depends only on its own parameter set, so a given seed always
+// renders the same file regardless of thread count or job order.
+//
+// Grids in rate mode without memory or PC set go through BatchKernel, many
+// grid points at a time (1.3-3x faster than the engine end to end, with or
+// without SIMD); everything else (or --batch 0) runs one engine per file.
+// Both write identical files.
+
+#include "Core/BatchKernel.h"
+#include "Core/MidiFileWriter.h"
+#include "Core/PitchClassSet.h"
+#include "Core/StringFieldEngine.h"
+#include "Core/WeightProfile.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        std::vector<int> seeds { 1 };
+        std::vector<float> energies { 0.2f };
+        std::vector<float> densities { 0.25f };
+        stringfield::EngineParams base;
+        std::string pcSet;
+        std::string pitchWeights, routeWeights;
+        double seconds = 60.0;
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int threads = (int)std::thread::hardware_concurrency();
+        bool batch = true;
+        std::string outDir = "renders";
+    };
+
+    struct Job
+    {
+        int seed;
+        float energy;
+        float density;
+    };
+
+    // Writes engine output straight into the file
+    struct FileSink : stringfield::EventSink
+    {
+        explicit FileSink(stringfield::MidiFileWriter& w) : writer(w) {}
+
+        void handleEvent(const stringfield::MidiEvent& e) override
+        {
+            writer.write(blockStart + e.offset, e.data, e.size);
+            ++numEvents;
+        }
+
+        stringfield::MidiFileWriter& writer;
+        int64_t blockStart = 0;
+        uint64_t numEvents = 0;
+    };
+
+    void printUsage()
+    {
+        std::printf(
+            "usage: stringfield_render [options]\n"
+            "\n"
+            "Grid (lists are \"a,b,c\", ranges \"first-last\", sweeps \"start:end:steps\"):\n"
+            "  --seeds LIST        seeds to render (default 1)\n"
+            "  --energy LIST       energy values (default 0.2)\n"
+            "  --density LIST      density values (default 0.25)\n"
+            "\n"
+            "Fixed parameters (plugin defaults unless given):\n"
+            "  --rate HZ  --center NOTE  --spread SEMIS  --vel VEL  --routes N  --memory N\n"
+            "  --memory-mode 0-2 (Recent, Decay, Markov)\n"
+            "  --articulation X  --pulse 0|1  --sync 0-6  --tempo BPM  --regularity X\n"
+            "  --pcmode 0-2  --pcset TEXT  --pedal 0|1  --voices N  --steal 0-2\n"
+            "  --pitch-weights \"W0 .. W11\"  --route-weights \"W1 .. W16\"\n"
+            "\n"
+            "Render:\n"
+            "  --seconds S         length of each file (default 60)\n"
+            "  --sample-rate HZ    timeline rate (default 48000)\n"
+            "  --block N           render block size (default 512)\n"
+            "  --threads N         worker threads (default: all cores)\n"
+            "  --batch 0|1         batch kernel where the settings allow it (default 1)\n"
+            "  --out DIR           output directory (default ./renders)\n");
+    }
+
+    // "a,b,c", "first-last" (integers) or "start:end:steps"
+    template <typename T>
+    bool parseList(const std::string& text, std::vector<T>& values)
+    {
+        values.clear();
+        size_t pos = 0;
+
+        while (pos <= text.size())
+        {
+            const size_t comma = text.find(',', pos);
+            const std::string item = text.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+            pos = comma == std::string::npos ? text.size() + 1 : comma + 1;
+
+            double first = 0, last = 0;
+            int steps = 0;
+            char sep = 0;
+
+            if (std::sscanf(item.c_str(), "%lf:%lf:%d", &first, &last, &steps) == 3 && steps > 0)
+            {
+                for (int i = 0; i < steps; ++i)
+                    values.push_back((T)(steps == 1 ? first : first + (last - first) * i / (steps - 1)));
+            }
+            else if (std::sscanf(item.c_str(), "%lf%c%lf", &first, &sep, &last) == 3 && sep == '-' && last >= first)
+            {
+                for (double v = first; v <= last; v += 1.0)
+                    values.push_back((T)v);
+            }
+            else if (std::sscanf(item.c_str(), "%lf", &first) == 1)
+            {
+                values.push_back((T)first);
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        return ! values.empty();
+    }
+
+    bool parseArgs(int argc, char** argv, Options& options)
+    {
+        auto& p = options.base;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+
+            if (arg == "--help" || arg == "-h")
+                return false;
+
+            if (i + 1 >= argc)
+            {
+                std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+                return false;
+            }
+
+            const std::string value = argv[++i];
+            const double number = std::atof(value.c_str());
+            bool ok = true;
+
+            if (arg == "--seeds")              ok = parseList(value, options.seeds);
+            else if (arg == "--energy")        ok = parseList(value, options.energies);
+            else if (arg == "--density")       ok = parseList(value, options.densities);
+            else if (arg == "--rate")          p.rate = (float)number;
+            else if (arg == "--center")        p.center = (int)number;
+            else if (arg == "--spread")        p.spread = (int)number;
+            else if (arg == "--vel")           p.vel = (int)number;
+            else if (arg == "--routes")        p.routes = (int)number;
+            else if (arg == "--memory")        p.memory = (int)number;
+            else if (arg == "--memory-mode")   p.memoryMode = (int)number;
+            else if (arg == "--articulation")  p.articulation = (float)number;
+            else if (arg == "--pulse")         p.pulse = number > 0.5;
+            else if (arg == "--sync")          p.sync = (int)number;
+            else if (arg == "--tempo")         p.tempo = (float)number;
+            else if (arg == "--regularity")    p.regularity = (float)number;
+            else if (arg == "--pcmode")        p.pcMode = (int)number;
+            else if (arg == "--pcset")         options.pcSet = value;
+            else if (arg == "--pitch-weights") options.pitchWeights = value;
+            else if (arg == "--route-weights") options.routeWeights = value;
+            else if (arg == "--pedal")         p.pedal = number > 0.5;
+            else if (arg == "--voices")        p.voices = (int)number;
+            else if (arg == "--steal")         p.steal = (int)number;
+            else if (arg == "--seconds")       options.seconds = number;
+            else if (arg == "--sample-rate")   options.sampleRate = number;
+            else if (arg == "--block")         options.blockSize = (int)number;
+            else if (arg == "--threads")       options.threads = (int)number;
+            else if (arg == "--batch")         options.batch = number > 0.5;
+            else if (arg == "--out")           options.outDir = value;
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+                return false;
+            }
+
+            if (! ok)
+            {
+                std::fprintf(stderr, "bad value for %s: %s\n", arg.c_str(), value.c_str());
+                return false;
+            }
+        }
+
+        return options.seconds > 0.0 && options.sampleRate > 0.0 && options.blockSize > 0;
+    }
+
+    std::string fileNameFor(const Job& job)
+    {
+        char name[64];
+        std::snprintf(name, sizeof(name), "seed%05d_e%.3f_d%.3f.mid", job.seed, job.energy, job.density);
+        return name;
+    }
+
+    // Renders one grid point; returns the number of events written
+    uint64_t renderJob(const Options& options, const Job& job,
+                       const stringfield::CompiledPitchClassSet* pcSet,
+                       const stringfield::CompiledWeightProfile* weights, const std::string& path)
+    {
+        stringfield::MidiFileWriter writer;
+        if (! writer.open(path, options.sampleRate))
+        {
+            std::fprintf(stderr, "can't write %s\n", path.c_str());
+            return 0;
+        }
+
+        auto params = options.base;
+        params.seed = job.seed;
+        params.energy = job.energy;
+        params.density = job.density;
+
+        auto engine = std::make_unique<stringfield::StringFieldEngine>();
+        FileSink sink(writer);
+
+        engine->prepare(options.sampleRate);
+        engine->setPitchClassSet(pcSet);
+        engine->setParameters(params, 0, sink);
+        engine->setWeightProfile(weights);
+
+        const int64_t length = (int64_t)(options.seconds * options.sampleRate);
+        for (int64_t start = 0; start < length; start += options.blockSize)
+        {
+            sink.blockStart = start;
+            engine->render(start, (int)std::min<int64_t>(options.blockSize, length - start), sink);
+        }
+
+        // Release everything at the end so no note hangs in the file
+        sink.blockStart = length;
+        engine->stop(sink);
+
+        if (! writer.close())
+            std::fprintf(stderr, "error writing %s\n", path.c_str());
+
+        return sink.numEvents;
+    }
+
+    // One worker's batch kernel; the streams keep their capacity between groups
+    struct BatchWorker
+    {
+        BatchWorker(double sampleRate, const stringfield::CompiledWeightProfile* weights)
+            : kernel(sampleRate, weights) {}
+
+        stringfield::BatchKernel kernel;
+        std::vector<stringfield::BatchKernel::Stream> streams;
+    };
+
+    // Renders grid points with the batch kernel, then writes their files;
+    // returns the number of events written
+    uint64_t renderBatch(const Options& options, const Job* jobs, int numJobs, BatchWorker& worker)
+    {
+        worker.streams.resize((size_t)numJobs);
+        for (int i = 0; i < numJobs; ++i)
+        {
+            auto& stream = worker.streams[(size_t)i];
+            stream.params = options.base;
+            stream.params.seed = jobs[i].seed;
+            stream.params.energy = jobs[i].energy;
+            stream.params.density = jobs[i].density;
+            stream.events.clear();
+        }
+
+        worker.kernel.render(worker.streams.data(), numJobs, (int64_t)(options.seconds * options.sampleRate));
+
+        uint64_t numEvents = 0;
+        for (int i = 0; i < numJobs; ++i)
+        {
+            const auto path = (std::filesystem::path(options.outDir) / fileNameFor(jobs[i])).string();
+
+            stringfield::MidiFileWriter writer;
+            if (! writer.open(path, options.sampleRate))
+            {
+                std::fprintf(stderr, "can't write %s\n", path.c_str());
+                continue;
+            }
+
+            for (const auto& event : worker.streams[(size_t)i].events)
+                writer.write(event.time, event.data, 3);
+
+            if (! writer.close())
+                std::fprintf(stderr, "error writing %s\n", path.c_str());
+
+            numEvents += worker.streams[(size_t)i].events.size();
+        }
+
+        return numEvents;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (! parseArgs(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<Job> jobs;
+    jobs.reserve(options.seeds.size() * options.energies.size() * options.densities.size());
+    for (int seed : options.seeds)
+        for (float energy : options.energies)
+            for (float density : options.densities)
+                jobs.push_back({ seed, energy, density });
+
+    std::error_code error;
+    std::filesystem::create_directories(options.outDir, error);
+    if (error)
+    {
+        std::fprintf(stderr, "can't create %s: %s\n", options.outDir.c_str(), error.message().c_str());
+        return 1;
+    }
+
+    // Shared read-only by every job
+    auto pcSet = stringfield::CompiledPitchClassSet::compile(options.pcSet);
+    auto weights = stringfield::CompiledWeightProfile::compile(options.pitchWeights, options.routeWeights);
+
+    stringfield::WorkStealingPool pool(options.threads);
+    std::atomic<uint64_t> totalEvents { 0 };
+
+    const bool batch = options.batch && stringfield::BatchKernel::supports(options.base, pcSet.get());
+
+    std::printf("rendering %zu files (%.1f s each) on %d threads, %s\n",
+                jobs.size(), options.seconds, pool.getNumThreads(),
+                batch ? stringfield::PhiloxBatch::getIsaName(stringfield::PhiloxBatch::getIsa()) : "engine");
+
+    const auto started = std::chrono::steady_clock::now();
+
+    if (batch)
+    {
+        // Groups small enough that every worker gets several
+        const int numJobs = (int)jobs.size();
+        const int groupSize = std::clamp(numJobs / (pool.getNumThreads() * 4), 1, 32);
+        const int numGroups = (numJobs + groupSize - 1) / groupSize;
+
+        std::vector<std::unique_ptr<BatchWorker>> workers;
+        for (int w = 0; w < pool.getNumThreads(); ++w)
+            workers.push_back(std::make_unique<BatchWorker>(options.sampleRate, weights.get()));
+
+        pool.run(numGroups, [&](int group, int worker)
+        {
+            const int first = group * groupSize;
+            const int count = std::min(groupSize, numJobs - first);
+            totalEvents.fetch_add(renderBatch(options, jobs.data() + first, count, *workers[(size_t)worker]),
+                                  std::memory_order_relaxed);
+        });
+    }
+    else
+    {
+        pool.run((int)jobs.size(), [&](int index, int)
+        {
+            const auto& job = jobs[(size_t)index];
+            const auto path = (std::filesystem::path(options.outDir) / fileNameFor(job)).string();
+            totalEvents.fetch_add(renderJob(options, job, pcSet.get(), weights.get(), path), std::memory_order_relaxed);
+        });
+    }
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    const double safeElapsed = elapsed > 0.0 ? elapsed : 1e-9;
+
+    std::printf("%zu files, %llu events in %.3f s\n", jobs.size(), (unsigned long long)totalEvents.load(), elapsed);
+    std::printf("%.1f files/sec, %.0f events/sec, %.0fx realtime\n",
+                (double)jobs.size() / safeElapsed,
+                (double)totalEvents.load() / safeElapsed,
+                (double)jobs.size() * options.seconds / safeElapsed);
+    return 0;
+}
@@ -0,0 +1,461 @@
+// stringfield_bench: times the generator's audio-thread path across block
+// sizes and workloads, and writes the results as CSV.
+//
+//   stringfield_bench --out bench.csv
+//   stringfield_bench --baseline bench.csv --tolerance 0.1
+//
+// Each case drives the generator the way processBlock does: a fake playhead
+// advancing block by block, mapped-CC changes splitting the block (CC
+// floods), and the output shaper feeding a counting port. Cases vary one
+// axis at a time around the plugin defaults. Every repeat renders the same
+// timeline (looped until a repeat lasts --min-time), so the spread between
+// repeats is measurement noise only.
+
+#include "Core/AllocationTrap.h"
+#include "Core/Ensemble.h"
+#include "Core/OutputShaper.h"
+#include "Core/PitchClassSet.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        double seconds = 120.0;           // Timeline per repeat
+        double sampleRate = 48000.0;
+        int repeats = 9;
+        double minRepeatSeconds = 0.1;    // Short timelines are looped up to this
+        bool quick = false;
+        std::string outPath = "bench.csv";
+        std::string baselinePath;
+        double tolerance = 0.10;
+    };
+
+    struct Case
+    {
+        std::string name;
+        std::string axis;
+        int blockSize = 512;
+        stringfield::EngineParams params;
+        int ccInterval = 0;               // Samples between mapped CCs (0 = none)
+    };
+
+    struct Result
+    {
+        Case config;
+        uint64_t blocks = 0;
+        uint64_t events = 0;              // Per timeline
+        int loops = 1;                    // Timelines per timed repeat
+        double nsPerBlock = 0.0;          // Median over repeats
+        double nsPerBlockMin = 0.0;
+        double nsPerBlockMad = 0.0;       // Median absolute deviation
+        double nsPerEvent = 0.0;          // Median
+        double load = 0.0;                // Share of the real-time budget
+    };
+
+    // End of the chain: counts what would reach the host
+    struct CountingPort : stringfield::EventSink
+    {
+        void handleEvent(const stringfield::MidiEvent&) override { ++numEvents; }
+        uint64_t numEvents = 0;
+    };
+
+    // Generator → output shaper, offsets relative to the block (as in the plugin)
+    struct ShaperSink : stringfield::EventSink
+    {
+        ShaperSink(stringfield::OutputShaper& s, stringfield::EventSink& p) : shaper(s), port(p) {}
+
+        void handleEvent(const stringfield::MidiEvent& e) override
+        {
+            auto shifted = e;
+            shifted.offset += blockOffset;
+            shaper.handleEvent(shifted, port);
+        }
+
+        stringfield::OutputShaper& shaper;
+        stringfield::EventSink& port;
+        int blockOffset = 0;
+    };
+
+    void printUsage()
+    {
+        std::printf(
+            "usage: stringfield_bench [options]\n"
+            "\n"
+            "  --seconds S         timeline rendered per repeat (default 120)\n"
+            "  --sample-rate HZ    (default 48000)\n"
+            "  --repeats N         timed repeats per case, after one warm-up (default 9)\n"
+            "  --min-time S        shortest timed repeat; timelines loop to fill it (default 0.1)\n"
+            "  --quick             fewer cases and 20 s timelines\n"
+            "  --out FILE          CSV results (default bench.csv)\n"
+            "  --baseline FILE     compare against an earlier CSV; exits 2 on regressions\n"
+            "  --tolerance X       allowed increase of the fastest repeat's ns/block (default 0.10)\n");
+    }
+
+    bool parseArgs(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+
+            if (arg == "--help" || arg == "-h")
+                return false;
+
+            if (arg == "--quick")
+            {
+                options.quick = true;
+                options.seconds = 20.0;
+                continue;
+            }
+
+            if (i + 1 >= argc)
+            {
+                std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+                return false;
+            }
+
+            const std::string value = argv[++i];
+            const double number = std::atof(value.c_str());
+
+            if (arg == "--seconds")            options.seconds = number;
+            else if (arg == "--sample-rate")   options.sampleRate = number;
+            else if (arg == "--repeats")       options.repeats = (int)number;
+            else if (arg == "--min-time")      options.minRepeatSeconds = number;
+            else if (arg == "--out")           options.outPath = value;
+            else if (arg == "--baseline")      options.baselinePath = value;
+            else if (arg == "--tolerance")     options.tolerance = number;
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+                return false;
+            }
+        }
+
+        return options.seconds > 0.0 && options.sampleRate > 0.0 && options.repeats > 0;
+    }
+
+    // One axis at a time around the plugin defaults, with every scheduled
+    // event sounding and 4 routes (so articulation and the shaper's channel
+    // logic are exercised)
+    std::vector<Case> buildCases(bool quick)
+    {
+        std::vector<Case> cases;
+        stringfield::EngineParams base;
+        base.density = 1.0f;
+        base.routes = 4;
+
+        auto add = [&](const std::string& axis, const std::string& value, auto&& configure)
+        {
+            Case c;
+            c.name = axis + "=" + value;
+            c.axis = axis;
+            c.params = base;
+            configure(c);
+            cases.push_back(c);
+        };
+
+        const std::vector<int> blockSizes = quick ? std::vector<int> { 16, 512, 8192 }
+                                                  : std::vector<int> { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+        for (int size : blockSizes)
+            add("block", std::to_string(size), [&](Case& c) { c.blockSize = size; });
+
+        const std::vector<float> rates = quick ? std::vector<float> { 0.05f, 20.0f }
+                                               : std::vector<float> { 0.05f, 0.5f, 2.0f, 8.0f, 20.0f };
+        for (float rate : rates)
+        {
+            char text[16];
+            std::snprintf(text, sizeof(text), "%g", rate);
+            add("rate", text, [&](Case& c) { c.params.rate = rate; });
+        }
+
+        const std::vector<int> memories = quick ? std::vector<int> { 0, 16 } : std::vector<int> { 0, 1, 4, 8, 16 };
+        for (int memory : memories)
+            add("memory", std::to_string(memory), [&](Case& c) { c.params.memory = memory; c.params.rate = 20.0f; });
+
+        // Memory modes at the longest horizon (Recent: 16 notes, Decay/Markov: 4096)
+        for (int mode = 0; mode <= 2; ++mode)
+            add("memmode", std::to_string(mode),
+                [&](Case& c) { c.params.memoryMode = mode; c.params.memory = 16; c.params.rate = 20.0f; });
+
+        for (int mode = 0; mode <= 2; ++mode)
+            add("pcmode", std::to_string(mode), [&](Case& c) { c.params.pcMode = mode; c.params.rate = 20.0f; });
+
+        for (int pedal = 0; pedal <= 1; ++pedal)
+            add("pedal", std::to_string(pedal), [&](Case& c) { c.params.pedal = pedal != 0; c.params.rate = 20.0f; });
+
+        // Ensemble size: what each extra player costs against a full instance
+        const std::vector<int> ensembles = quick ? std::vector<int> { 1, 16 } : std::vector<int> { 1, 2, 4, 8, 16 };
+        for (int players : ensembles)
+            add("players", std::to_string(players), [&](Case& c) { c.params.players = players; });
+
+        // Mapped CCs: none, dense automation, a controller flood
+        for (int interval : { 0, 256, 8 })
+            add("cc", interval == 0 ? "off" : "every" + std::to_string(interval),
+                [&](Case& c) { c.ccInterval = interval; c.params.rate = 20.0f; });
+
+        return cases;
+    }
+
+    // Renders the case's timeline once; returns the number of events sent
+    uint64_t renderTimeline(const Case& config, const Options& options,
+                            const stringfield::CompiledPitchClassSet* pcSet,
+                            stringfield::Ensemble& engine, stringfield::OutputShaper& shaper)
+    {
+        CountingPort port;
+        ShaperSink sink(shaper, port);
+
+        engine.reset();
+        engine.prepare(options.sampleRate);
+        engine.setPitchClassSet(pcSet);
+        engine.setParameters(config.params, 0, sink);
+        shaper.prepare(options.sampleRate);
+
+        auto params = config.params;
+        const float baseEnergy = params.energy;
+        const int64_t length = (int64_t)(options.seconds * options.sampleRate);
+        int64_t nextCC = config.ccInterval > 0 ? config.ccInterval : INT64_MAX;
+        bool ccHigh = false;
+
+        stringfield::TransportPosition transport;
+        transport.bpm = 120.0;
+
+        // As in processBlock, Debug builds abort if the blocks touch the heap
+        stringfield::ScopedNoAllocation noAllocation;
+
+        for (int64_t start = 0; start < length; start += config.blockSize)
+        {
+            const int numSamples = (int)std::min<int64_t>(config.blockSize, length - start);
+
+            shaper.beginBlock(numSamples, port);
+
+            // Fake playhead
+            transport.time = start;
+            transport.ppq = (double)start / options.sampleRate * transport.bpm / 60.0;
+            engine.setTransport(transport);
+
+            // Mapped CCs split the block, as in processBlock
+            int position = 0;
+            while (nextCC < start + numSamples)
+            {
+                const int offset = (int)(nextCC - start);
+                if (offset > position)
+                {
+                    sink.blockOffset = position;
+                    engine.render(start + position, offset - position, sink);
+                    position = offset;
+                }
+
+                ccHigh = ! ccHigh;
+                params.energy = baseEnergy + (ccHigh ? 0.01f : 0.0f);
+                sink.blockOffset = offset;
+                engine.setParameters(params, nextCC, sink);
+                nextCC += config.ccInterval;
+            }
+
+            if (position < numSamples)
+            {
+                sink.blockOffset = position;
+                engine.render(start + position, numSamples - position, sink);
+            }
+        }
+
+        return port.numEvents;
+    }
+
+    double median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        const size_t n = values.size();
+        return n == 0 ? 0.0 : (n % 2 == 1 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]));
+    }
+
+    Result runCase(const Case& config, const Options& options)
+    {
+        const auto pcSet = stringfield::CompiledPitchClassSet::compile(config.params.pcMode > 0 ? "0 2 4 7 9" : "");
+        auto engine = std::make_unique<stringfield::Ensemble>();
+        stringfield::OutputShaper shaper;
+
+        Result result;
+        result.config = config;
+
+        const int64_t length = (int64_t)(options.seconds * options.sampleRate);
+        result.blocks = (uint64_t)((length + config.blockSize - 1) / config.blockSize);
+
+        using Clock = std::chrono::steady_clock;
+
+        // Warm-up (caches, branch predictors, CPU clock), also sizing the repeats
+        const auto warmUp = Clock::now();
+        result.events = renderTimeline(config, options, pcSet.get(), *engine, shaper);
+        const double once = std::chrono::duration<double>(Clock::now() - warmUp).count();
+        result.loops = (int)std::min(100000.0, std::max(1.0, std::ceil(options.minRepeatSeconds / std::max(once, 1e-9))));
+
+        std::vector<double> nsPerBlock;
+        for (int r = 0; r < options.repeats; ++r)
+        {
+            const auto started = Clock::now();
+            for (int loop = 0; loop < result.loops; ++loop)
+                renderTimeline(config, options, pcSet.get(), *engine, shaper);
+
+            const double ns = std::chrono::duration<double, std::nano>(Clock::now() - started).count();
+            nsPerBlock.push_back(ns / ((double)result.blocks * result.loops));
+        }
+
+        result.nsPerBlock = median(nsPerBlock);
+        result.nsPerBlockMin = *std::min_element(nsPerBlock.begin(), nsPerBlock.end());
+
+        std::vector<double> deviations;
+        for (double ns : nsPerBlock)
+            deviations.push_back(std::abs(ns - result.nsPerBlock));
+        result.nsPerBlockMad = median(deviations);
+
+        result.nsPerEvent = result.events > 0 ? result.nsPerBlock * (double)result.blocks / (double)result.events : 0.0;
+        result.load = result.nsPerBlock / (config.blockSize / options.sampleRate * 1.0e9);
+        return result;
+    }
+
+    bool writeCsv(const std::string& path, const std::vector<Result>& results, const Options& options)
+    {
+        std::ofstream out(path);
+        if (! out)
+            return false;
+
+        out << "case,axis,block,rate,memory,memmode,pcmode,pedal,players,cc_interval,sample_rate,seconds,repeats,"
+               "blocks,events,ns_per_block,ns_per_block_min,ns_per_block_mad,ns_per_event,load\n";
+
+        for (const auto& r : results)
+        {
+            const auto& c = r.config;
+            char line[512];
+            std::snprintf(line, sizeof(line), "%s,%s,%d,%g,%d,%d,%d,%d,%d,%d,%g,%g,%d,%llu,%llu,%.2f,%.2f,%.2f,%.2f,%.3e\n",
+                          c.name.c_str(), c.axis.c_str(), c.blockSize, c.params.rate, c.params.memory, c.params.memoryMode,
+                          c.params.pcMode, c.params.pedal ? 1 : 0, c.params.players, c.ccInterval,
+                          options.sampleRate, options.seconds, options.repeats,
+                          (unsigned long long)r.blocks, (unsigned long long)r.events,
+                          r.nsPerBlock, r.nsPerBlockMin, r.nsPerBlockMad, r.nsPerEvent, r.load);
+            out << line;
+        }
+
+        return (bool)out;
+    }
+
+    // case → ns_per_block_min from an earlier run's CSV. The fastest repeat is
+    // the least noisy estimate of the cost itself, so that's what is compared.
+    std::map<std::string, double> readBaseline(const std::string& path)
+    {
+        std::map<std::string, double> baseline;
+        std::ifstream in(path);
+        std::string line;
+
+        if (! std::getline(in, line))
+            return baseline;
+
+        // Locate the column by name, so older files with fewer columns still work
+        std::vector<std::string> header;
+        {
+            std::stringstream fields(line);
+            std::string field;
+            while (std::getline(fields, field, ','))
+                header.push_back(field);
+        }
+
+        const auto column = std::find(header.begin(), header.end(), "ns_per_block_min");
+        if (column == header.end() || header.empty() || header[0] != "case")
+            return baseline;
+
+        const size_t index = (size_t)(column - header.begin());
+
+        while (std::getline(in, line))
+        {
+            std::vector<std::string> fields;
+            std::stringstream stream(line);
+            std::string field;
+            while (std::getline(stream, field, ','))
+                fields.push_back(field);
+
+            if (fields.size() > index)
+                baseline[fields[0]] = std::atof(fields[index].c_str());
+        }
+
+        return baseline;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (! parseArgs(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    const auto cases = buildCases(options.quick);
+    std::vector<Result> results;
+
+    std::printf("%zu cases, %.0f s timeline, %d repeats\n\n", cases.size(), options.seconds, options.repeats);
+    std::printf("%-14s %10s %10s %8s %10s %9s\n", "case", "events", "ns/block", "mad", "ns/event", "load");
+
+    for (const auto& config : cases)
+    {
+        const auto result = runCase(config, options);
+        std::printf("%-14s %10llu %10.1f %8.1f %10.1f %8.4f%%\n", config.name.c_str(),
+                    (unsigned long long)result.events, result.nsPerBlock, result.nsPerBlockMad,
+                    result.nsPerEvent, result.load * 100.0);
+        std::fflush(stdout);
+        results.push_back(result);
+    }
+
+    if (! writeCsv(options.outPath, results, options))
+    {
+        std::fprintf(stderr, "can't write %s\n", options.outPath.c_str());
+        return 1;
+    }
+
+    std::printf("\nwrote %s\n", options.outPath.c_str());
+
+    if (options.baselinePath.empty())
+        return 0;
+
+    const auto baseline = readBaseline(options.baselinePath);
+    if (baseline.empty())
+    {
+        std::fprintf(stderr, "no results in %s\n", options.baselinePath.c_str());
+        return 1;
+    }
+
+    // Only cases slower than the tolerance count; new cases are listed but pass
+    int regressions = 0;
+    std::printf("\n%-14s %10s %10s %8s\n", "case", "baseline", "now", "change");
+
+    for (const auto& r : results)
+    {
+        const auto found = baseline.find(r.config.name);
+        if (found == baseline.end() || found->second <= 0.0)
+        {
+            std::printf("%-14s %10s %10.1f %8s\n", r.config.name.c_str(), "-", r.nsPerBlockMin, "new");
+            continue;
+        }
+
+        const double change = r.nsPerBlockMin / found->second - 1.0;
+        const bool regressed = change > options.tolerance;
+        regressions += regressed ? 1 : 0;
+
+        std::printf("%-14s %10.1f %10.1f %+7.1f%%%s\n", r.config.name.c_str(), found->second,
+                    r.nsPerBlockMin, change * 100.0, regressed ? "  REGRESSION" : "");
+    }
+
+    std::printf("\n%d regression%s (tolerance %.0f%%)\n", regressions, regressions == 1 ? "" : "s",
+                options.tolerance * 100.0);
+    return regressions > 0 ? 2 : 0;
+}
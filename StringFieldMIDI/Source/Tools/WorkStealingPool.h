@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace stringfield
+{
+
+// Runs jobs 0..numJobs-1 across worker threads with work stealing.
+//
+// Jobs are dealt round-robin into one deque per worker. A worker pops from
+// the back of its own deque and, when that runs dry, steals from the front
+// of the others, so uneven job lengths (long renders, dense grids) still
+// keep every core busy. run() returns once every job has finished.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(int numThreads)
+        : queues((size_t)std::max(1, numThreads))
+    {
+    }
+
+    int getNumThreads() const noexcept { return (int)queues.size(); }
+
+    // job(jobIndex, workerIndex)
+    void run(int numJobs, const std::function<void(int, int)>& job)
+    {
+        for (int i = 0; i < numJobs; ++i)
+            queues[(size_t)i % queues.size()].jobs.push_back(i);
+
+        std::vector<std::thread> workers;
+        for (int w = 0; w < getNumThreads(); ++w)
+            workers.emplace_back([this, w, &job]
+            {
+                int index;
+                while (takeOwn(w, index) || steal(w, index))
+                    job(index, w);
+            });
+
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<int> jobs;
+    };
+
+    bool takeOwn(int worker, int& index)
+    {
+        auto& q = queues[(size_t)worker];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.jobs.empty())
+            return false;
+
+        index = q.jobs.back();
+        q.jobs.pop_back();
+        return true;
+    }
+
+    bool steal(int thief, int& index)
+    {
+        const int n = getNumThreads();
+        for (int offset = 1; offset < n; ++offset)
+        {
+            auto& q = queues[(size_t)((thief + offset) % n)];
+            std::lock_guard<std::mutex> guard(q.lock);
+            if (q.jobs.empty())
+                continue;
+
+            index = q.jobs.front();
+            q.jobs.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<Queue> queues;
+};
+
+} // namespace stringfield